@@ -47,9 +47,15 @@
 
 #include <sys/time.h>
 
+#ifdef HAVE_SIGNAL_H 
+ #include <signal.h>
+#endif
+#ifdef HAVE_PTHREAD_H 
+ #include <pthread.h>
+#endif
+
 #include <mpi.h>
 #include <pxargs.h>
-#include <ptmpf.h>
    
 /* bcast array offset for runtime params */
 #define RT_VERBOSE 0
@@ -58,10 +64,53 @@
 #define RT_PREEXIT_TIME 3
 #define RT_CHKPNT_OPTIDX 4
 #define RT_ARGS_OPTIDX 5
-#define RT_LEN 6
+#define RT_EXEC_COLUMN 6
+#define RT_PROC_LEN 7
+#define RT_NODE_TREE 8
+#define RT_CHUNKMAX 9
+#define RT_DEPTH 10
+#define RT_SLOTS 11
+#define RT_NO_SHELL 12
+#define RT_RMA 13
+#define RT_COORD_WORK 14
+#define RT_KILL_GRACE 15
+#define RT_LAUNCH_RATE 16
+#define RT_LAUNCH_NODE 17
+#define RT_RAND_SEED 18
+#define RT_RAND_START 19
+#define RT_RAND_END 20
+#define RT_TRACE 21
+#define RT_LEN 22
+
+/* the share of the coordinator's time in a --profile phase, in percent */
+#define PROF_PCT(st, ph) (100.0 * (double)(st).prof[ph] / (double)(st).prof_ns)
 
 static const char* SRC_FILE = __FILE__;
 
+/* The monitor's arguments, it runs on rank 1 or as a thread of rank 0 (--coord-work) */
+typedef struct
+{
+   MPI_Comm comm;
+   int crank;
+   int rank;
+   unsigned int* rtparams;
+   char** argv;
+   char* procpgrm;
+   FILE* verbout;
+} MONITOR_ARGS;
+
+/* The worker's arguments when it runs as a thread of rank 0 (--coord-work) */
+typedef struct
+{
+   MPI_Comm comm;
+   int rank;
+   char* procpgrm;
+   WORK_PARAMS* wparams;
+   unsigned int verbose;
+   FILE* verbout;
+   int ret;
+} WORKER_ARGS;
+
 /*-------------------------------------------------------------------------------------
 */
 static void parse_arg_hyph(char* strp, int* v0, int* v1)
@@ -93,6 +142,245 @@ static void parse_arg_hyph(char* strp, int* v0, int* v1)
    }
 }/* parse_arg_hyph */
 
+/*-------------------------------------------------------------------------------------
+* Seconds (may be fractional, e.g. 0.25) to milliseconds, < 0 is taken as 0
+*/
+static unsigned int parse_msecs(const char* strp)
+{
+   double secs = atof(strp);
+
+   if(secs <= 0.0)
+      return 0;
+   if(secs >= (double)(UINT_MAX / 1000U))
+      return (UINT_MAX / 1000U) * 1000U;
+   return (unsigned int)(secs * 1000.0 + 0.5);
+}/* parse_msecs */
+
+/*-------------------------------------------------------------------------------------
+* Parses --launch-rate "n[:m]", units per second for the job and per node, into 
+* thousandths. Returns 0, < 0 if it is not two rates >= 0 with one of them > 0.
+*/
+static int parse_rates(const char* strp, unsigned int* job, unsigned int* node)
+{
+   char* endp = NULL;
+   double r0, r1 = 0.0;
+
+   r0 = strtod(strp, &endp);
+   if( (endp != NULL) && (*endp == ':') )
+      r1 = strtod(endp + 1, &endp);
+   if( (endp == NULL) || (*endp != '\0') || (r0 < 0.0) || (r1 < 0.0) || ((r0 <= 0.0) && (r1 <= 0.0)) || 
+       (r0 > 1000000.0) || (r1 > 1000000.0) )
+      return -1;
+   *job = (unsigned int)(r0 * 1000.0 + 0.5);
+   *node = (unsigned int)(r1 * 1000.0 + 0.5);
+   return 0;
+}/* parse_rates */
+
+/*-------------------------------------------------------------------------------------
+* Parses --retry-on, a comma separated list of exit codes (or ranges n-m of them) and the 
+* words timeout and signal, into the bits of on (see PX_RETRY_BITS). Returns < 0 if a 
+* word is not one of those.
+*/
+static int parse_retry_on(const char* strp, unsigned char* on)
+{
+   char* endp = NULL;
+   long c0, c1;
+
+   memset(on, 0, PX_RETRY_BITS / 8);
+   while(*strp != '\0')
+   {
+      if(strncmp(strp, "timeout", 7) == 0)
+      {
+         c0 = c1 = PX_RETRY_TIMEOUT;
+         endp = (char*)&strp[7];
+      }
+      else if(strncmp(strp, "signal", 6) == 0)
+      {
+         c0 = c1 = PX_RETRY_SIGNAL;
+         endp = (char*)&strp[6];
+      }
+      else
+      {
+         c0 = c1 = strtol(strp, &endp, 10);
+         if( (endp != strp) && (*endp == '-') )
+            c1 = strtol(endp + 1, &endp, 10);
+         if( (endp == strp) || (c0 < 0) || (c1 < c0) || (c1 > 255) )
+            return -1;
+      }
+      if( (*endp != ',') && (*endp != '\0') )
+         return -1;
+      for(; c0 <= c1; c0++)
+         on[c0 >> 3] |= (unsigned char)(1U << (c0 & 7));
+      strp = (*endp == ',') ? (endp + 1) : endp;
+   }
+   return 0;
+}/* parse_retry_on */
+
+/*-------------------------------------------------------------------------------------
+* The -r wait (milliseconds) before the k-th worker starts its first unit. Every rank 
+* draws from the one broadcast seed, so worker k waits k+1 random steps of s0 to s1 
+* seconds, as if the coordinator had slept between the first sends.
+*/
+static unsigned int stagger_msecs(unsigned int seed, int k, unsigned int s0, unsigned int s1)
+{
+   unsigned long long msecs = 0;
+   int i;
+
+   for(i = 0; i <= k; i++)
+   {
+      seed = seed * 1103515245U + 12345U;
+      msecs += (unsigned long long)(s0 + ((seed >> 16) % (s1 - s0 + 1))) * 1000ULL;
+   }
+   return (msecs > (unsigned long long)UINT_MAX) ? UINT_MAX : (unsigned int)msecs;
+}/* stagger_msecs */
+
+/*-------------------------------------------------------------------------------------
+* This rank's share of the --launch-rate (units per second, 0 for no limit), the job's
+* rate split over all the workers and the node's over the workers on this node, the 
+* lower of the two. Collective over MPI_COMM_WORLD with a node rate. Returns < 0 on failure.
+*/
+static double launch_share(unsigned int* rtparams, int rank, int nsize, int wrankstart)
+{
+   MPI_Comm shmcomm = MPI_COMM_NULL;
+   double rate = 0.0, noderate;
+   int isworker = (rank >= wrankstart) ? 1 : 0, nlocal = 0;
+
+   if(rtparams[RT_LAUNCH_RATE] > 0)
+      rate = (rtparams[RT_LAUNCH_RATE] / 1000.0) / (double)(nsize - wrankstart);
+   if(rtparams[RT_LAUNCH_NODE] == 0)
+      return rate;
+   if( (MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &shmcomm) != MPI_SUCCESS) ||
+       (MPI_Allreduce(&isworker, &nlocal, 1, MPI_INT, MPI_SUM, shmcomm) != MPI_SUCCESS) )
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : node launch rate set up Failed! :(\n", SRC_FILE, __LINE__, rank);
+      return -1.0;
+   }
+   MPI_Comm_free(&shmcomm);
+   noderate = (rtparams[RT_LAUNCH_NODE] / 1000.0) / (double)((nlocal > 0) ? nlocal : 1);
+   return ((rate > 0.0) && (rate < noderate)) ? rate : noderate;
+}/* launch_share */
+
+/*-------------------------------------------------------------------------------------
+* The value of the option at argv[idx], either "--opt=value" or "-o value" 
+*/
+static char* argv_optval(char** argv, unsigned int idx)
+{
+   char* val;
+
+   if( (val = strchr(argv[idx], '=')) != NULL)  /* maybe long opt */
+      return &val[1];
+   return argv[idx];  /* standard opt */
+}/* argv_optval */
+
+#ifdef HAVE_GETOPT_LONG 
+/*-------------------------------------------------------------------------------------
+* The name of the long option arg is as getopt_long takes it, "--name", "--name=value" or 
+* an abbreviation of the name. An abbreviation that fits options which differ is not taken, 
+* one that fits options alike is the first of them. NULL if arg is not a long option.
+*/
+static const char* argv_longopt(const char* arg, const struct option* opts)
+{
+   const struct option* found = NULL;
+   size_t len;
+   int j;
+
+   if( (strncmp(arg, "--", 2) != 0) || (arg[2] == '\0') )
+      return NULL;
+   arg = &arg[2];
+   len = strcspn(arg, "=");
+   for(j = 0; opts[j].name != NULL; j++)
+   {
+      if(strncmp(opts[j].name, arg, len) != 0)
+         continue;
+      if(strlen(opts[j].name) == len)
+         return opts[j].name;
+      if(found == NULL)
+         found = &opts[j];
+      else if( (found->has_arg != opts[j].has_arg) || (found->flag != opts[j].flag) || (found->val != opts[j].val) )
+         return NULL;
+   }
+   return ((found != NULL) ? found->name : NULL);
+}/* argv_longopt */
+#endif
+
+/*-------------------------------------------------------------------------------------
+* Runs the monitor and, on a pre-exit event, dumps the units not completed to the -n file
+*/
+static void* run_monitor(void* targs)
+{
+   MONITOR_ARGS* ma = (MONITOR_ARGS*) targs;
+   unsigned int* rtparams = ma->rtparams;
+   char* flist = NULL;
+   char* chkpntfname = NULL;
+   unsigned char* chkpntidx = NULL;
+   unsigned int nchkpntidx = 0;
+   WORK_STORE wstore;
+   EXEC_TABLE etab;
+   int mret;
+
+   memset(&wstore, 0, sizeof(WORK_STORE));
+   memset(&etab, 0, sizeof(EXEC_TABLE));
+
+   /* this set by the coordinator rank and the index was broadcast */
+   if( rtparams[RT_ARGS_OPTIDX] == 0)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : ** WARN ** : monitor checkpointing does not currently work with unix pipes.\n", SRC_FILE, __LINE__, ma->rank);
+      flist = NULL;
+   }
+   else
+      flist = argv_optval(ma->argv, rtparams[RT_ARGS_OPTIDX]);
+
+   chkpntfname = argv_optval(ma->argv, rtparams[RT_CHKPNT_OPTIDX]);
+
+   if(rtparams[RT_VERBOSE] >= 1)
+      fprintf(ma->verbout, "MONITOR INIT, RANK %d. VERBOSITY LEVEL %u, PRE-EXT CHK PNT TM %u (s), CHECK PNT FILE \"%s\" ARG FILE \"%s\"\n", 
+                                  ma->rank, rtparams[RT_VERBOSE], rtparams[RT_PREEXIT_TIME], chkpntfname, (flist != NULL ? flist : "NA"));
+
+   /*-* start the monitor *-*/
+   mret = monitor_proc( ma->comm, ma->crank, ma->rank, rtparams[RT_PREEXIT_TIME], &chkpntidx, &nchkpntidx, rtparams[RT_VERBOSE], ma->verbout );
+
+   /* an early exit, or a normal one with units that failed after their retries */
+   if( (mret >= 1) && (chkpntidx != NULL) && (flist != NULL) )
+   {
+      /* We need to get the original list here; why don't we just get it from rank 0 ? We don't because it is messy, it can 
+         take a long time, dancing around deadlocks, etc.. attempting to interrupt the coordinator (stop it and get the list) 
+         while activitiy is going on. We leave the coordinator alone and let it die on it's own but only after we've written the 
+         incompleted work as given by the monitor. This can be an issue if one is using many 1000's of procs. */
+      if( (rtparams[RT_EXEC_COLUMN] == 1) && (exec_table_init(&etab, ma->procpgrm) < 0) )
+         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : monitor failed to set up the exec table.\n", SRC_FILE, __LINE__, ma->rank);
+      else if( work_store_open(&wstore, flist, ((rtparams[RT_EXEC_COLUMN] == 1) ? &etab : NULL), ((rtparams[RT_EXEC_COLUMN] == 1) ? PX_YES : PX_NO)) < 0)
+         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : monitor failed to load arg list on post proc diff.\n", SRC_FILE, __LINE__, ma->rank);
+      else
+      {
+         if(rtparams[RT_VERBOSE] >= 2)
+            fprintf(ma->verbout, "MONITOR, RANK %d. DUMPING CHECK PNT, %u items to consider...\n", ma->rank, nchkpntidx);
+
+         if( dump_work_list_by_index(chkpntfname, &wstore, chkpntidx, nchkpntidx) < 0)
+            fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : monitor failed to dump work list.\n", SRC_FILE, __LINE__, ma->rank);
+
+         work_store_close(&wstore);
+      }
+      exec_table_free(&etab);
+   }
+   else if(mret < 0)
+      fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : monitor_proc Failed! :(\n", SRC_FILE, __LINE__, ma->rank);
+   free(chkpntidx);
+   return NULL;
+}/* run_monitor */
+
+/*-------------------------------------------------------------------------------------
+* Runs rank 0's worker beside the coordinator (--coord-work)
+*/
+static void* run_worker(void* targs)
+{
+   WORKER_ARGS* wa = (WORKER_ARGS*) targs;
+
+   if(wa->verbose >= 1)
+      fprintf(wa->verbout, "CONTACT ESTB RANK %d. VERBOSITY LEVEL %u\n", wa->rank, wa->verbose);
+   wa->ret = work_proc(wa->comm, wa->rank, wa->procpgrm, wa->wparams, wa->verbose, wa->verbout);
+   return NULL;
+}/* run_worker */
+
 /*-------------------------------------------------------------------------------------
 */
 static void print_usage()
@@ -104,11 +392,68 @@ static void print_usage()
 	fprintf(stdout, "         <  .   >\n");
 	fprintf(stdout, "         <args_n>\n");
 	fprintf(stdout, "   -p | --proc <exec> :: The exec or script utility.\n");
+	fprintf(stdout, "   -e | --exec-column :: The first column of each arg line is the exec or script\n");
+	fprintf(stdout, "         utility for that line, -p is then optional. The file format is:\n");
+	fprintf(stdout, "         <exec_1> <args_1>\n");
 	fprintf(stdout, "   -w | --work-analyze :: Prints out job statistics\n");
+	fprintf(stdout, "   -k | --chunk <n> :: Send up to n units per dispatch message. The batch size shrinks\n");
+	fprintf(stdout, "           as the queue drains (guided self-scheduling). The default is 1.\n");
+	fprintf(stdout, "   -d | --prefetch <n> :: Keep up to n dispatch messages queued on each worker so the\n");
+	fprintf(stdout, "           next unit is local when the current one finishes. The default is 1.\n");
+	fprintf(stdout, "   -s | --slots <n> :: Each worker rank runs up to n units at once, so one rank per node\n");
+	fprintf(stdout, "           can drive all of its cores. The default is 1.\n");
+	fprintf(stdout, "   --no-shell :: Run the exec directly with the arg line split into words (quotes are\n");
+	fprintf(stdout, "           honored) rather than through %s -c. No globbing, variables or redirection.\n", SHL_PATH);
+	fprintf(stdout, "   --stream :: Read the arg file as the work is dispatched rather than loading it first.\n");
+	fprintf(stdout, "           An arg list on stdin is always read this way.\n");
+	fprintf(stdout, "   --window <n> :: With a streamed arg list hold at most n units in memory, reading\n");
+	fprintf(stdout, "           stops (and a pipe writer waits) while it is full. The default is %u.\n", PX_STREAM_WINDOW);
+	fprintf(stdout, "   --rma :: The workers claim units from a counter on the coordinator with one sided MPI\n");
+	fprintf(stdout, "           and read their args from the arg file themselves (it must be on a shared\n");
+	fprintf(stdout, "           file system). For long lists of short units.\n");
+	fprintf(stdout, "   --journal <path> :: Append a record of each completed unit to this file, synced to disk\n");
+	fprintf(stdout, "           in groups, so a killed job can be restarted with --resume.\n");
+	fprintf(stdout, "   --resume <path> :: Skip the units recorded in this journal and go on journaling to it\n");
+	fprintf(stdout, "           (unless --journal is given). A journal that does not exist yet is empty.\n");
+	fprintf(stdout, "   --lpt <column|files|history> :: Hand out the costliest units first. The cost is a number\n");
+	fprintf(stdout, "           in the first column (after the exec column with -e), the size of the files the\n");
+	fprintf(stdout, "           args name or the unit's mean run time in the --history file. Needs a loaded\n");
+	fprintf(stdout, "           --arg-file.\n");
+	fprintf(stdout, "   --history <path> :: Keep a running mean of each unit's run time (over %u runs) in this file\n", PX_HIST_WINDOW);
+	fprintf(stdout, "           across jobs. It is read at the start and rewritten at the end of the job.\n");
+	fprintf(stdout, "   --speculate <factor> :: Once every unit is sent, run a backup copy of a unit that has been\n");
+	fprintf(stdout, "           out factor times longer than the mean so far on an idle slot, the first copy to\n");
+	fprintf(stdout, "           finish wins. Only units whose line starts with the word \"%s\" are run twice.\n", PX_SPEC_MARK);
+	fprintf(stdout, "           Needs a loaded --arg-file.\n");
+	fprintf(stdout, "   --coord-work :: The coordinator (and the -n monitor) run as threads of rank 0, which also\n");
+	fprintf(stdout, "           runs units, so no rank is given up to them. Needs MPI_THREAD_MULTIPLE.\n");
+	fprintf(stdout, "   -N | --node-tree :: Run one node leader per node (shared memory domain) that takes\n");
+	fprintf(stdout, "           batches from the coordinator for the node's other ranks. For very large jobs.\n");
 	fprintf(stdout, "   -r | --random-starts <n-m> :: Randomize initial starts on\n");
 	fprintf(stdout, "                        interval n to m. Units are seconds.\n");
-	fprintf(stdout, "   -m | --max-time <n> :: The maximum runtime in seconds allowed for a arg unit. If\n");
-	fprintf(stdout, "        the work unit exceeds n seconds it is killed (if the platform has signals)\n");
+	fprintf(stdout, "   --launch-rate <n[:m]> :: Start at most n units per second over the whole job (0 for no\n");
+	fprintf(stdout, "           limit) and at most m per second on each node. The workers hold queued units back.\n");
+	fprintf(stdout, "   -m | --max-time <n> :: The maximum runtime in seconds allowed for a arg unit, e.g. 90 or 0.5.\n");
+	fprintf(stdout, "        If the work unit exceeds n seconds it is stopped (if the platform has signals)\n");
+	fprintf(stdout, "   --kill-grace <n> :: Seconds between the SIGTERM and the SIGKILL for a unit over -m, the\n");
+	fprintf(stdout, "           default is %.1f s. 0 sends SIGKILL right away.\n", PX_KILL_GRACE_MSECS / 1000.0);
+	fprintf(stdout, "   --retries <n> :: Run a failed unit again, after the rest, up to n times. Units that still\n");
+	fprintf(stdout, "           fail are left in the -n checkpoint file. Not used with --rma.\n");
+	fprintf(stdout, "   --retry-on <list> :: The failures retried, a comma separated list of exit codes (or n-m\n");
+	fprintf(stdout, "           ranges) and the words timeout (over -m) and signal. The default is all of them.\n");
+	fprintf(stdout, "   --retry-time <factor> :: Each retry gets factor times the -m of the one before.\n");
+	fprintf(stdout, "   --retry-elsewhere :: Send a retry to a worker (a node with -N) other than the last one.\n");
+	fprintf(stdout, "   --profile :: Time where the coordinator's time goes (receives, unpacking, the monitor, the journal,\n");
+	fprintf(stdout, "           packing, sends, reading the list and waiting) and print it at the end.\n");
+	fprintf(stdout, "   --status <path> :: Keep a one line JSON status of the run (units done, in flight and queued,\n");
+	fprintf(stdout, "           busy slots, kills, throughput and an ETA) in this file, rewritten each second,\n");
+	fprintf(stdout, "           and answer it on the Unix domain socket <path>.sock. Not used with --rma.\n");
+	fprintf(stdout, "   --control <path> :: Take commands on this Unix domain socket while the job runs, one line\n");
+	fprintf(stdout, "           each: pause, resume, drain [path], cancel <pattern>, front <pattern> and\n");
+	fprintf(stdout, "           slots <n> [rank]. See the man page. Not used with --rma.\n");
+	fprintf(stdout, "   --trace <path> :: Record each unit's dispatch, start and end on every rank and slot, and the\n");
+	fprintf(stdout, "           scheduling messages, in memory and write them at the end as one Chrome trace\n");
+	fprintf(stdout, "           (JSON) file for Perfetto or chrome://tracing, with the ranks' clocks lined up.\n");
 	fprintf(stdout, "   -n | --not-complete <path> :: A file that pxargs attempts to write out unfinished work\n");
 	fprintf(stdout, "           to (on master) at pre-exit. Option requires libpbs to be useful; see manpage for info.\n");
 	fprintf(stdout, "   -t <sec> :: suggested time, in seconds, to react before the job is due to get the exit\n");
@@ -138,6 +483,31 @@ int main(int argc, char** argv)
       {"version", 0, 0, 0},   
 	   {"max-time", 1, 0, 0},  
 	   {"not-complete", 1, 0, 0}, 
+      {"exec-column", 0, 0, 0},   
+      {"chunk", 1, 0, 0},   
+      {"prefetch", 1, 0, 0},   
+      {"node-tree", 0, 0, 0},   
+      {"slots", 1, 0, 0},   
+      {"no-shell", 0, 0, 0},   
+      {"stream", 0, 0, 0},   
+      {"window", 1, 0, 0},   
+      {"rma", 0, 0, 0},   
+      {"journal", 1, 0, 0},   
+      {"resume", 1, 0, 0},   
+      {"coord-work", 0, 0, 0},   
+      {"lpt", 1, 0, 0},   
+      {"history", 1, 0, 0},   
+      {"speculate", 1, 0, 0},   
+      {"kill-grace", 1, 0, 0},   
+      {"launch-rate", 1, 0, 0},   
+      {"retries", 1, 0, 0},   
+      {"retry-on", 1, 0, 0},   
+      {"retry-time", 1, 0, 0},   
+      {"retry-elsewhere", 0, 0, 0},   
+      {"profile", 0, 0, 0},   
+      {"status", 1, 0, 0},   
+      {"control", 1, 0, 0},   
+      {"trace", 1, 0, 0},   
       {0, 0, 0, 0}         /* terminate */
    };
 #endif
@@ -150,41 +520,118 @@ int main(int argc, char** argv)
    int ercode = 1;
    char* flist = NULL;
    char* procpgrm = NULL;
-   WORK_UNIT* wlist = NULL;
+   WORK_STORE wstore;
+   WORK_PARAMS wparams;
    unsigned int nlist = 0;
+   EXEC_TABLE etab;
+   SCHED_PARAMS sparams;
+   SCHED_STATS sstats;
    int randstart = -1;
    int randend = -1;
    char randstr[64];
-   char tempfname[PATH_MAX+1];
+   WORK_STREAM wstream;
+   RMA_SCHED rsched;
+   JOURNAL jrnl;
+   char* jrnlname = NULL;
+   char* resumename = NULL;
+   unsigned char* jdone = NULL;
+   unsigned int njdone = 0;
+   int streamlist = 0;
+   unsigned int window = 0;
+   int lptsrc = 0;
+   int retryonset = 0;
+   unsigned int nmark = 0;
+   HISTORY hist;
+   char* histname = NULL;
+   LIVE_STATUS live;
+   char* statname = NULL;
+   CONTROL ctrl;
+   char* ctrlname = NULL;
+   TRACE trace, wtrace;
+   char* tracename = NULL;
+   int trole;
    char* chkpntfname = NULL;
-   unsigned char* chkpntidx = NULL;
-   unsigned int nchkpntidx = 0;
    unsigned int rtparams[RT_LEN] ; 
    MPI_Group maingrp, crdmntgrp;
    MPI_Comm subcomm = MPI_COMM_NULL;
+   MPI_Comm dispcomm = MPI_COMM_NULL;
+   MPI_Comm shmcomm = MPI_COMM_NULL;
+   MPI_Comm nodecomm = MPI_COMM_NULL;
+   MPI_Comm treecomm = MPI_COMM_NULL;
+   int noderank = 0, nodesize = 0, treesize = 0;
+   unsigned int nodeslots = 0;
+   unsigned int* treeslots = NULL;
    int subgrp[2]= {0, 1};
    int subrank = 0;
-   int mret;
+   int mret, i;
+   unsigned long long profsum;
+   int thrdreq = MPI_THREAD_SINGLE, thrdprov = MPI_THREAD_SINGLE;
+#ifdef HAVE_GETOPT_LONG 
+   const char* optname;
+#endif
+   MONITOR_ARGS margs;
+   WORKER_ARGS wargs;
+   pthread_t monthrd, wrkthrd;
+   sigset_t chldmask, oldmask;
 
-   /* init mpi */
-   MPI_Init(&argc, &argv);
+   /* init mpi, --coord-work runs threads that make MPI calls on rank 0 and the --status and 
+      --control threads run beside the coordinator's MPI calls. The thread level is asked for 
+      before the options are parsed, so they are matched here as getopt_long will */
+#ifdef HAVE_GETOPT_LONG 
+   for(i = 1; (i < argc) && (strcmp(argv[i], "--") != 0); i++)
+   {
+      if( (optname = argv_longopt(argv[i], long_options)) == NULL)
+         continue;
+      if(strcmp(optname, "coord-work") == 0)
+         thrdreq = MPI_THREAD_MULTIPLE;
+      else if( ((strcmp(optname, "status") == 0) || (strcmp(optname, "control") == 0)) && (thrdreq < MPI_THREAD_FUNNELED) )
+         thrdreq = MPI_THREAD_FUNNELED;
+   }
+#endif
+   MPI_Init_thread(&argc, &argv, thrdreq, &thrdprov);
    /* set rank */
    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
    MPI_Comm_size(MPI_COMM_WORLD, &nsize);
 
    memset(rtparams, 0, sizeof(unsigned int) * RT_LEN);
+   memset(&etab, 0, sizeof(EXEC_TABLE));
+   memset(&sparams, 0, sizeof(SCHED_PARAMS));
+   memset(&sstats, 0, sizeof(SCHED_STATS));
+   memset(&wparams, 0, sizeof(WORK_PARAMS));
+   memset(&wstore, 0, sizeof(WORK_STORE));
+   memset(&wstream, 0, sizeof(WORK_STREAM));
+   memset(&rsched, 0, sizeof(RMA_SCHED));
+   memset(&jrnl, 0, sizeof(JOURNAL));
+   memset(&margs, 0, sizeof(MONITOR_ARGS));
+   memset(&wargs, 0, sizeof(WORKER_ARGS));
+   wstream.fd = -1;
+   jrnl.fd = -1;
+   sparams.chunkmax = 1;
+   sparams.depth = 1;
+   sparams.wslots = 1;
+   sparams.dispcomm = MPI_COMM_NULL;
+   sparams.speculate = 0.0;
+   sparams.retrytime = 1.0;
+   sparams.retryelse = PX_NO;
+   sparams.profile = PX_NO;
+   sparams.status = NULL;
+   sparams.control = NULL;
+   sparams.notcomplete = NULL;
+   sparams.trace = NULL;
+   wparams.incomm = MPI_COMM_NULL;
+   wparams.trace = NULL;
    rtparams[RT_PREEXIT_TIME] = DEFAULT_PREEXIT_SECONDS; 
+   rtparams[RT_KILL_GRACE] = PX_KILL_GRACE_MSECS;
    memset(&maingrp, 0, sizeof(MPI_Group));
    memset(&crdmntgrp, 0, sizeof(MPI_Group));
 
    if(rank == 0)
    {
       memset(randstr, 0, 64);
-      memset(tempfname, 0, PATH_MAX+1);
 #ifdef HAVE_GETOPT_LONG 
-      while( (c = getopt_long(argc, argv, "hva:p:wr:Vm:t:n:", long_options, &option_index)) != -1 )
+      while( (c = getopt_long(argc, argv, "hva:p:wr:Vm:t:n:ek:d:Ns:", long_options, &option_index)) != -1 )
 #else
-      while( (c = getopt(argc, argv, "hva:p:wr:Vm:t:n:")) != -1 )
+      while( (c = getopt(argc, argv, "hva:p:wr:Vm:t:n:ek:d:Ns:")) != -1 )
 #endif
       {
          switch (c)
@@ -218,7 +665,7 @@ int main(int argc, char** argv)
                   MPI_Abort(MPI_COMM_WORLD, 0);
                }
                else if(option_index == 7)
-                  rtparams[RT_MAXUNIT_TIME] = (unsigned int) atol(optarg);
+                  rtparams[RT_MAXUNIT_TIME] = parse_msecs(optarg);
                else if(option_index == 8)
                {
 #ifdef HAVE_LIBPBS 
@@ -229,6 +676,103 @@ int main(int argc, char** argv)
                   fprintf(stderr, "WARN: --not-complete option not enabled.\n");
 #endif
                }
+               else if(option_index == 9)
+                  rtparams[RT_EXEC_COLUMN] = 1;
+               else if(option_index == 10)
+                  sparams.chunkmax = (unsigned int) atol(optarg);
+               else if(option_index == 11)
+                  sparams.depth = (unsigned int) atol(optarg);
+               else if(option_index == 12)
+                  rtparams[RT_NODE_TREE] = 1;
+               else if(option_index == 13)
+                  sparams.wslots = (unsigned int) atol(optarg);
+               else if(option_index == 14)
+                  rtparams[RT_NO_SHELL] = 1;
+               else if(option_index == 15)
+                  streamlist = 1;
+               else if(option_index == 16)
+                  window = (unsigned int) atol(optarg);
+               else if(option_index == 17)
+                  rtparams[RT_RMA] = 1;
+               else if(option_index == 18)
+                  jrnlname = optarg;
+               else if(option_index == 19)
+                  resumename = optarg;
+               else if(option_index == 20)
+                  rtparams[RT_COORD_WORK] = 1;
+               else if(option_index == 21)
+               {
+                  if(strcmp(optarg, "column") == 0)
+                     lptsrc = PX_COST_COLUMN;
+                  else if(strcmp(optarg, "files") == 0)
+                     lptsrc = PX_COST_FILES;
+                  else if(strcmp(optarg, "history") == 0)
+                     lptsrc = PX_COST_HISTORY;
+                  else
+                  {
+                     fprintf(stderr, "Bad --lpt cost \"%s\" (column, files or history). Try -h for help.\n", optarg);
+                     MPI_Abort(MPI_COMM_WORLD, ercode);
+                  }
+               }
+               else if(option_index == 22)
+                  histname = optarg;
+               else if(option_index == 23)
+               {
+                  if( (sparams.speculate = atof(optarg)) <= 0.0)
+                  {
+                     fprintf(stderr, "Bad --speculate factor \"%s\". Try -h for help.\n", optarg);
+                     MPI_Abort(MPI_COMM_WORLD, ercode);
+                  }
+               }
+               else if(option_index == 24)
+                  rtparams[RT_KILL_GRACE] = parse_msecs(optarg);
+               else if(option_index == 25)
+               {
+                  if( parse_rates(optarg, &(rtparams[RT_LAUNCH_RATE]), &(rtparams[RT_LAUNCH_NODE])) < 0)
+                  {
+                     fprintf(stderr, "Bad --launch-rate \"%s\". Try -h for help.\n", optarg);
+                     MPI_Abort(MPI_COMM_WORLD, ercode);
+                  }
+               }
+               else if(option_index == 26)
+               {
+                  if( (atol(optarg) < 0) || (atol(optarg) > 255) )
+                  {
+                     fprintf(stderr, "Bad --retries count \"%s\" (0 to 255). Try -h for help.\n", optarg);
+                     MPI_Abort(MPI_COMM_WORLD, ercode);
+                  }
+                  sparams.retries = (unsigned int) atol(optarg);
+               }
+               else if(option_index == 27)
+               {
+                  if( parse_retry_on(optarg, sparams.retryon) < 0)
+                  {
+                     fprintf(stderr, "Bad --retry-on list \"%s\" (exit codes, timeout, signal). Try -h for help.\n", optarg);
+                     MPI_Abort(MPI_COMM_WORLD, ercode);
+                  }
+                  retryonset = 1;
+               }
+               else if(option_index == 28)
+               {
+                  if( (sparams.retrytime = atof(optarg)) < 1.0)
+                  {
+                     fprintf(stderr, "Bad --retry-time factor \"%s\" (1 or more). Try -h for help.\n", optarg);
+                     MPI_Abort(MPI_COMM_WORLD, ercode);
+                  }
+               }
+               else if(option_index == 29)
+                  sparams.retryelse = PX_YES;
+               else if(option_index == 30)
+                  sparams.profile = PX_YES;
+               else if(option_index == 31)
+                  statname = optarg;
+               else if(option_index == 32)
+                  ctrlname = optarg;
+               else if(option_index == 33)
+               {
+                  tracename = optarg;
+                  rtparams[RT_TRACE] = 1;
+               }
                break;
 #endif
 			   case 'a':
@@ -239,11 +783,26 @@ int main(int argc, char** argv)
                rtparams[RT_VERBOSE] += 1;
 				   break;
 			   case 'm':
-               rtparams[RT_MAXUNIT_TIME] = (unsigned int) atol(optarg);
+               rtparams[RT_MAXUNIT_TIME] = parse_msecs(optarg);
 				   break;
 			   case 'p':
                procpgrm = optarg;
 				   break;
+			   case 'e':
+               rtparams[RT_EXEC_COLUMN] = 1;
+				   break;
+			   case 'k':
+               sparams.chunkmax = (unsigned int) atol(optarg);
+				   break;
+			   case 'd':
+               sparams.depth = (unsigned int) atol(optarg);
+				   break;
+			   case 'N':
+               rtparams[RT_NODE_TREE] = 1;
+				   break;
+			   case 's':
+               sparams.wslots = (unsigned int) atol(optarg);
+				   break;
 			   case 'w':
                wrkinf = 1;
 				   break;
@@ -279,12 +838,38 @@ int main(int argc, char** argv)
       }
 
       /* basic options sanity check */
-      if(procpgrm == NULL)
+      if( (procpgrm == NULL) && (rtparams[RT_EXEC_COLUMN] == 0) )
       {
          fprintf(stderr, "No processing program or script given. Try -h for help.\n");
          MPI_Abort(MPI_COMM_WORLD, ercode);
       }
-      if(rtparams[RT_HAVE_MONITOR] == 1)
+      if(procpgrm == NULL)
+         procpgrm = "";
+      rtparams[RT_PROC_LEN] = (unsigned int) strlen(procpgrm) + 1;
+      rtparams[RT_CHUNKMAX] = sparams.chunkmax;
+      rtparams[RT_DEPTH] = sparams.depth;
+      if(sparams.wslots < 1)
+         sparams.wslots = 1;
+      rtparams[RT_SLOTS] = sparams.wslots;
+      if( exec_table_init(&etab, procpgrm) < 0)
+         MPI_Abort(MPI_COMM_WORLD, ercode);
+      if( (rtparams[RT_COORD_WORK] == 1) && (thrdprov < MPI_THREAD_MULTIPLE) )
+      {
+         fprintf(stderr, "WARN: --coord-work needs an MPI with MPI_THREAD_MULTIPLE, not used.\n");
+         rtparams[RT_COORD_WORK] = 0;
+      }
+      if( (rtparams[RT_COORD_WORK] == 1) && ((rtparams[RT_RMA] == 1) || (rtparams[RT_NODE_TREE] == 1)) )
+      {
+         fprintf(stderr, "WARN: --coord-work is not used with --rma or --node-tree.\n");
+         rtparams[RT_COORD_WORK] = 0;
+      }
+      /* with --coord-work every rank works, the coordinator and monitor are threads of rank 0 */
+      if(rtparams[RT_COORD_WORK] == 1)
+      {
+         nworkers = nsize;
+         wrankstart = 0;
+      }
+      else if(rtparams[RT_HAVE_MONITOR] == 1)
       {
          nworkers = nsize - 2;
          wrankstart = 2;
@@ -301,17 +886,84 @@ int main(int argc, char** argv)
          MPI_Abort(MPI_COMM_WORLD, ercode);
       }
       
+      /* Assume stdin if there is no file. stdin is read as the work is dispatched, a file
+         only if asked for since the monitor's check point needs the whole list. */
+      if( (streamlist == 1) && (flist != NULL) && (rtparams[RT_HAVE_MONITOR] == 1) )
+      {
+         fprintf(stderr, "WARN: --stream is not used with --not-complete, the arg list is loaded.\n");
+         streamlist = 0;
+      }
+      /* skipping the journaled units takes the loaded list */
+      if( (resumename != NULL) && (flist == NULL) )
+         fprintf(stderr, "WARN: --resume needs an --arg-file (not stdin), units are only journaled.\n");
+      else if( (resumename != NULL) && (streamlist == 1) )
+      {
+         fprintf(stderr, "WARN: --stream is not used with --resume, the arg list is loaded.\n");
+         streamlist = 0;
+      }
+      if(jrnlname == NULL)
+         jrnlname = resumename;
       if(flist == NULL)
+         streamlist = 1;
+      /* ordering takes the loaded list */
+      if( (lptsrc != 0) && (streamlist == 1) )
       {
-         /* Assume stdin and use a temp file for simplicity... Pipes don't work well 
-            in mpi environments so we have a intermediary copy for user convenience... */
-         if( fstream2tempfile(stdin, tempfname, PATH_MAX) < 0 )
-         {
-            fprintf(stderr, "\"%s\" @L %d RANK %d : tempfile error (for stdin).\n", SRC_FILE, __LINE__, rank);
-            MPI_Abort(MPI_COMM_WORLD, ercode);
-         }
-         flist = tempfname;
+         fprintf(stderr, "WARN: --lpt needs a loaded --arg-file (not stdin or --stream), not used.\n");
+         lptsrc = 0;
+      }
+      if( (lptsrc == PX_COST_HISTORY) && (histname == NULL) )
+      {
+         fprintf(stderr, "WARN: --lpt history needs a --history file, not used.\n");
+         lptsrc = 0;
+      }
+      /* the workers read the list themselves, so it has to be a file that is loaded */
+      if( (rtparams[RT_RMA] == 1) && (streamlist == 1) )
+      {
+         fprintf(stderr, "WARN: --rma needs a loaded --arg-file (not stdin or --stream), not used.\n");
+         rtparams[RT_RMA] = 0;
+      }
+      if( (rtparams[RT_RMA] == 1) && (rtparams[RT_NODE_TREE] == 1) )
+      {
+         fprintf(stderr, "WARN: --node-tree is not used with --rma.\n");
+         rtparams[RT_NODE_TREE] = 0;
+      }
+      /* the backups are sent and cancelled by the coordinator itself */
+      if( (sparams.speculate > 0.0) && ((streamlist == 1) || (rtparams[RT_RMA] == 1) || (rtparams[RT_NODE_TREE] == 1)) )
+      {
+         fprintf(stderr, "WARN: --speculate needs a loaded --arg-file and is not used with --rma or --node-tree.\n");
+         sparams.speculate = 0.0;
+      }
+      /* the workers of --rma claim their units from a shared counter, nothing can put a failed one back in the queue */
+      if( (sparams.retries > 0) && (rtparams[RT_RMA] == 1) )
+      {
+         fprintf(stderr, "WARN: --retries is not used with --rma.\n");
+         sparams.retries = 0;
+      }
+      if( (sparams.profile == PX_YES) && (rtparams[RT_RMA] == 1) )
+      {
+         fprintf(stderr, "WARN: --profile is not used with --rma, the workers claim their units themselves.\n");
+         sparams.profile = PX_NO;
+      }
+      if( (statname != NULL) && (rtparams[RT_RMA] == 1) )
+      {
+         fprintf(stderr, "WARN: --status is not used with --rma, the workers claim their units themselves.\n");
+         statname = NULL;
       }
+      if( (ctrlname != NULL) && (rtparams[RT_RMA] == 1) )
+      {
+         fprintf(stderr, "WARN: --control is not used with --rma, the workers claim their units themselves.\n");
+         ctrlname = NULL;
+      }
+      if( ((statname != NULL) || (ctrlname != NULL)) && (thrdprov < MPI_THREAD_FUNNELED) )
+      {
+         fprintf(stderr, "WARN: --status and --control need an MPI with MPI_THREAD_FUNNELED, not used.\n");
+         statname = NULL;
+         ctrlname = NULL;
+      }
+      /* with no --retry-on any failure is retried */
+      if( (sparams.retries > 0) && (retryonset == 0) )
+         memset(sparams.retryon, 0xff, PX_RETRY_BITS / 8);
+      sparams.maxumsecs = rtparams[RT_MAXUNIT_TIME];
       /* for timing */
       memset(&tvl1, 0 , sizeof(struct timeval));
       memset(&tvl2, 0 , sizeof(struct timeval));
@@ -320,31 +972,131 @@ int main(int argc, char** argv)
       if(rtparams[RT_VERBOSE] >= 1)
       {
          if(randstart >= 0)
-            fprintf(verbout, "COORDNTR INIT WITH %d WORKERS. ARG FILE \"%s\". PROC \"%s\". RAND INTERVAL %d-%d. MAX UNIT TIME %u. CHECK PNT FILE \"%s\"\n", 
-                              nworkers, flist, procpgrm, randstart, randend, rtparams[RT_MAXUNIT_TIME], (chkpntfname != NULL ? chkpntfname : "NA"));
+            fprintf(verbout, "COORDNTR INIT WITH %d WORKERS. ARG FILE \"%s\". PROC \"%s\". RAND INTERVAL %d-%d. MAX UNIT TIME %.3f. CHECK PNT FILE \"%s\"\n", 
+                              nworkers, (flist != NULL ? flist : "stdin"), procpgrm, randstart, randend, rtparams[RT_MAXUNIT_TIME] / 1000.0, (chkpntfname != NULL ? chkpntfname : "NA"));
          else
-            fprintf(verbout, "COORDNTR INIT WITH %d WORKERS. ARG FILE \"%s\". PROC \"%s\". MAX UNIT TIME %u. CHECK PNT FILE \"%s\"\n", 
-                              nworkers, flist, procpgrm, rtparams[RT_MAXUNIT_TIME], (chkpntfname != NULL ? chkpntfname : "NA"));
+            fprintf(verbout, "COORDNTR INIT WITH %d WORKERS. ARG FILE \"%s\". PROC \"%s\". MAX UNIT TIME %.3f. CHECK PNT FILE \"%s\"\n", 
+                              nworkers, (flist != NULL ? flist : "stdin"), procpgrm, rtparams[RT_MAXUNIT_TIME] / 1000.0, (chkpntfname != NULL ? chkpntfname : "NA"));
       }
       
-      /* pull in tiles of interest */
-      if( (wlist = load_work_list(flist, &nlist)) == NULL)
+      if(streamlist == 1)
+      {
+         /* units are read as they are dispatched, and printed as they finish for -w */
+         if( work_stream_open(&wstream, flist, window, ((rtparams[RT_EXEC_COLUMN] == 1) ? &etab : NULL)) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to open arg list.\n", SRC_FILE, __LINE__, rank);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         if( (rtparams[RT_VERBOSE] >= 3) || (wrkinf == 1) )
+            wstream.retout = verbout;
+      }
+      /* pull in tiles of interest, the file is mapped and indexed */
+      else if( work_store_open(&wstore, flist, &etab, ((rtparams[RT_EXEC_COLUMN] == 1) ? PX_YES : PX_NO)) < 0)
       {
          fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to load arg list.\n", SRC_FILE, __LINE__, rank);
          MPI_Abort(MPI_COMM_WORLD, ercode);
       }
+      else
+         nlist = wstore.n;
 
-      if(nlist == 0)
+      if( (streamlist == 0) && (nlist == 0) )
       {
          fprintf(stderr, "\"%s\" @L %d RANK %d : No work loaded. Check the arg list file.\n", SRC_FILE, __LINE__, rank);
          MPI_Abort(MPI_COMM_WORLD, ercode);
       }
 
-      if(rtparams[RT_VERBOSE] >= 3)
+      /* drop the units an earlier run completed, the rest keep their arg list positions for the journal */
+      if( (streamlist == 0) && (resumename != NULL) )
+      {
+         if( ((jdone = (unsigned char*) calloc(nlist, sizeof(unsigned char))) == NULL) ||
+             (journal_load(resumename, jdone, nlist, &njdone) < 0) || (work_store_skip(&wstore, jdone) < 0) )
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to resume from \"%s\".\n", SRC_FILE, __LINE__, rank, resumename);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         free(jdone);
+         if(rtparams[RT_VERBOSE] >= 1)
+            fprintf(verbout, "COORDNTR RESUMING FROM \"%s\", %u OF %u UNITS ALREADY DONE\n", resumename, njdone, nlist);
+         nlist = wstore.n;
+      }
+      /* the units that may be run twice, the mark comes off their args */
+      if(sparams.speculate > 0.0)
+      {
+         if( work_store_mark(&wstore, &nmark) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to mark the arg list.\n", SRC_FILE, __LINE__, rank);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         if(nmark == 0)
+            fprintf(stderr, "WARN: --speculate, no unit in the arg list starts with \"%s\", none are run twice.\n", PX_SPEC_MARK);
+         if(rtparams[RT_VERBOSE] >= 1)
+            fprintf(verbout, "COORDNTR SPECULATE AT %.2f TIMES THE MEAN, %u OF %u UNITS MAY RUN TWICE\n", sparams.speculate, nmark, wstore.n);
+      }
+      /* past run times, units that are new to it are recorded as they complete */
+      memset(&hist, 0, sizeof(HISTORY));
+      if(histname != NULL)
+      {
+         if( history_load(&hist, histname) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to load the history \"%s\".\n", SRC_FILE, __LINE__, rank, histname);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         if(rtparams[RT_VERBOSE] >= 1)
+            fprintf(verbout, "COORDNTR HISTORY \"%s\", %lu UNITS KNOWN\n", histname, (unsigned long)hist.n);
+      }
+      /* the costliest units go out first, the journal and monitor still see arg list positions */
+      if(lptsrc != 0)
+      {
+         if( work_store_order(&wstore, lptsrc, ((lptsrc == PX_COST_HISTORY) ? &hist : NULL)) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to order the arg list by cost.\n", SRC_FILE, __LINE__, rank);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         if(rtparams[RT_VERBOSE] >= 1)
+            fprintf(verbout, "COORDNTR LPT ORDER BY %s\n", ((lptsrc == PX_COST_COLUMN) ? "COST COLUMN" : 
+                                                          ((lptsrc == PX_COST_FILES) ? "FILE SIZES" : "HISTORY")));
+      }
+      if( (jrnlname != NULL) && (journal_open(&jrnl, jrnlname) < 0) )
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to open the journal.\n", SRC_FILE, __LINE__, rank);
+         MPI_Abort(MPI_COMM_WORLD, ercode);
+      }
+      if(statname != NULL)
+      {
+         if(status_open(&live, statname) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to open the status.\n", SRC_FILE, __LINE__, rank);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         sparams.status = &live;
+      }
+      if(ctrlname != NULL)
+      {
+         if(control_open(&ctrl, ctrlname) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to open the control socket.\n", SRC_FILE, __LINE__, rank);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         sparams.control = &ctrl;
+         sparams.notcomplete = chkpntfname;
+      }
+
+      if( (streamlist == 0) && (rtparams[RT_VERBOSE] >= 3) )
       {
          fprintf(verbout, "ARG LIST:\n");
-         fprint_worklist(verbout, wlist, nlist);
+         fprint_worklist(verbout, &wstore);
+      }
+
+      /* the workers wait out -r themselves, from the same draws */
+      if( (randstart >= 0) && (randend >= 0) )
+      {
+         rtparams[RT_RAND_SEED] = ((unsigned int) tvl1.tv_sec ^ (unsigned int) tvl1.tv_usec) | 1U;
+         rtparams[RT_RAND_START] = (unsigned int) randstart;
+         rtparams[RT_RAND_END] = (unsigned int) randend;
       }
+      if( (rtparams[RT_VERBOSE] >= 1) && ((rtparams[RT_LAUNCH_RATE] > 0) || (rtparams[RT_LAUNCH_NODE] > 0)) )
+         fprintf(verbout, "COORDNTR LAUNCH RATE %.3f PER SEC, %.3f PER SEC PER NODE (0 NO LIMIT)\n", 
+                          rtparams[RT_LAUNCH_RATE] / 1000.0, rtparams[RT_LAUNCH_NODE] / 1000.0);
    }/* rank 0 setup */
       
    /* prime comm, set basic rt params and have everybody get ready */
@@ -354,8 +1106,65 @@ int main(int argc, char** argv)
       MPI_Abort(MPI_COMM_WORLD, ercode);
    }
 
+   sparams.chunkmax = rtparams[RT_CHUNKMAX];
+   sparams.depth = rtparams[RT_DEPTH];
+   sparams.wslots = rtparams[RT_SLOTS];
+   wparams.nslots = rtparams[RT_SLOTS];
+   wparams.maxumsecs = rtparams[RT_MAXUNIT_TIME];
+   wparams.gracemsecs = rtparams[RT_KILL_GRACE];
+   wparams.noshell = (rtparams[RT_NO_SHELL] == 1) ? PX_YES : PX_NO;
+   wparams.nullin = PX_NO;
+   if(rtparams[RT_COORD_WORK] == 1)
+      wrankstart = 0;
+   else
+      wrankstart = (rtparams[RT_HAVE_MONITOR] == 1) ? 2 : 1;
+   wparams.rankstart = wrankstart;
+   wparams.startmsecs = 0;
+   if( (rtparams[RT_RAND_SEED] != 0) && (rank >= wrankstart) )
+      wparams.startmsecs = stagger_msecs(rtparams[RT_RAND_SEED], rank - wrankstart, rtparams[RT_RAND_START], rtparams[RT_RAND_END]);
+   if( (wparams.launchrate = launch_share(rtparams, rank, nsize, wrankstart)) < 0.0)
+      MPI_Abort(MPI_COMM_WORLD, ercode);
+
+   /* the -p program is the same for the whole job, send it once here rather than with each unit */
+   if(rank != 0)
+   {
+      if( (procpgrm = (char*) calloc(rtparams[RT_PROC_LEN], sizeof(char))) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : calloc failed : %s\n", SRC_FILE, __LINE__, rank, strerror(errno));
+         MPI_Abort(MPI_COMM_WORLD, ercode);
+      }
+   }
+   if( MPI_Bcast(procpgrm, (int)rtparams[RT_PROC_LEN], MPI_CHAR, 0, MPI_COMM_WORLD) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Bcast Failed! :(\n", SRC_FILE, __LINE__, rank);
+      MPI_Abort(MPI_COMM_WORLD, ercode);
+   }
+
+   /* Rank 0's worker takes its units on a duplicate of the world communicator so the 
+      coordinator keeps the completions on MPI_COMM_WORLD to itself */
+   if(rtparams[RT_COORD_WORK] == 1)
+   {
+      if( MPI_Comm_dup(MPI_COMM_WORLD, &dispcomm) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Comm_dup Failed! :(\n", SRC_FILE, __LINE__, rank);
+         MPI_Abort(MPI_COMM_WORLD, ercode);
+      }
+      sparams.dispcomm = dispcomm;
+      wparams.incomm = dispcomm;
+   }
+
+   /* A monitor thread on rank 0 hears from the coordinator on its own communicator */
+   if( (rtparams[RT_HAVE_MONITOR] == 1) && (rtparams[RT_COORD_WORK] == 1) )
+   {
+      if( (rank == 0) && (MPI_Comm_dup(MPI_COMM_SELF, &subcomm) != MPI_SUCCESS) )
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Comm_dup Failed! :(\n", SRC_FILE, __LINE__, rank);
+         MPI_Abort(MPI_COMM_WORLD, ercode);
+      }
+      subrank = 0;
+   }
    /* If there is a monitor, create another sub communicator */
-   if(rtparams[RT_HAVE_MONITOR] == 1) 
+   else if(rtparams[RT_HAVE_MONITOR] == 1) 
    {
       /* another communicator... */
       if( MPI_Comm_group(MPI_COMM_WORLD, &maingrp) != MPI_SUCCESS)
@@ -393,74 +1202,201 @@ int main(int argc, char** argv)
       }
    }
    
-   /*-*-*-* begin processing *-*-*-*-*/
-
-   if(rank == 0) /* master | producer */
+   /* For a node tree the workers of each node (shared memory domain) get a node communicator. Its
+      rank 0 is the node leader, the leaders and the coordinator get the tree communicator. A node 
+      with a single worker has no leader, the worker joins the tree as a plain worker. */
+   if(rtparams[RT_NODE_TREE] == 1) 
    {
-      if( coordinate_proc( wlist, nlist, procpgrm, nworkers, wrankstart, randstart, randend, 
-                           subcomm, subrank, rtparams[RT_VERBOSE], verbout) < 0  )
+      if( MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &shmcomm) != MPI_SUCCESS)
       {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : coordinate_proc Failed! :(\n", SRC_FILE, __LINE__, rank);
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Comm_split_type Failed! :(\n", SRC_FILE, __LINE__, rank);
+         MPI_Abort(MPI_COMM_WORLD, ercode);
+      }
+      if( MPI_Comm_split(shmcomm, ((rank >= wrankstart) ? 0 : MPI_UNDEFINED), rank, &nodecomm) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Comm_split Failed! :(\n", SRC_FILE, __LINE__, rank);
+         MPI_Abort(MPI_COMM_WORLD, ercode);
+      }
+      MPI_Comm_free(&shmcomm);
+      if(nodecomm != MPI_COMM_NULL)
+      {
+         MPI_Comm_rank(nodecomm, &noderank);
+         MPI_Comm_size(nodecomm, &nodesize);
+      }
+      if( MPI_Comm_split(MPI_COMM_WORLD, (((rank == 0) || ((nodecomm != MPI_COMM_NULL) && (noderank == 0))) ? 0 : MPI_UNDEFINED), 
+                         rank, &treecomm) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Comm_split Failed! :(\n", SRC_FILE, __LINE__, rank);
          MPI_Abort(MPI_COMM_WORLD, ercode);
       }
+      /* the coordinator sizes each member's batches by how many units it runs at once */
+      if(treecomm != MPI_COMM_NULL)
+      {
+         MPI_Comm_size(treecomm, &treesize);
+         nodeslots = ((nodesize > 1) ? (unsigned int)(nodesize - 1) : 1) * rtparams[RT_SLOTS];
+         if( (rank == 0) && ((treeslots = (unsigned int*) calloc(treesize, sizeof(unsigned int))) == NULL) )
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : calloc failed : %s\n", SRC_FILE, __LINE__, rank, strerror(errno));
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         if( MPI_Gather(&nodeslots, 1, MPI_UNSIGNED, treeslots, 1, MPI_UNSIGNED, 0, treecomm) != MPI_SUCCESS)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Gather Failed! :(\n", SRC_FILE, __LINE__, rank);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         if( (rank == 0) && (rtparams[RT_VERBOSE] >= 1) )
+            fprintf(verbout, "COORDNTR NODE TREE WITH %d MEMBERS FOR %d WORKERS\n", treesize - 1, nworkers);
+      }
+      /* neither the node nor the tree communicator has the monitor in it */
+      wparams.rankstart = 1;
    }
-   else if( (rank == 1) && (rtparams[RT_HAVE_MONITOR] == 1) ) /* monitor, if requested */ 
+   
+   /* With RMA scheduling rank 0's index and results are shared in windows, the workers 
+      map the arg list themselves (the path is at the same argv index on every rank) */
+   if(rtparams[RT_RMA] == 1)
    {
-      /* this set by the coordinator rank and the index was broadcast */
-      if( rtparams[RT_ARGS_OPTIDX] == 0)
+      if( rma_sched_open(&rsched, MPI_COMM_WORLD, rank, ((rank == 0) ? &wstore : NULL), ((rank == 0) ? &etab : NULL), 
+                         ((rank >= wrankstart) ? argv_optval(argv, rtparams[RT_ARGS_OPTIDX]) : NULL)) < 0)
       {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : ** WARN ** : monitor checkpointing does not currently work with unix pipes.\n", SRC_FILE, __LINE__, rank);
-         flist = NULL;
+         fprintf(stderr, "\"%s\" @L %d RANK %d : RMA set up Failed! :(\n", SRC_FILE, __LINE__, rank);
+         MPI_Abort(MPI_COMM_WORLD, ercode);
       }
+      if( (rank == 0) && (rtparams[RT_VERBOSE] >= 1) )
+         fprintf(verbout, "COORDNTR RMA SCHEDULING FOR %d WORKERS\n", nworkers);
+   }
+
+   /* every rank records its own part of the trace, rank 0's worker thread in a trace of its own */
+   if(rtparams[RT_TRACE] == 1)
+   {
+      if(rank == 0)
+         trole = PX_TRACE_COORD;
+      else if( (rank == 1) && (rtparams[RT_HAVE_MONITOR] == 1) && (rtparams[RT_COORD_WORK] == 0) )
+         trole = PX_TRACE_MONITOR;
+      else if( (rtparams[RT_RMA] == 0) && (nodecomm != MPI_COMM_NULL) && (noderank == 0) && (nodesize > 1) )
+         trole = PX_TRACE_LEADER;
       else
+         trole = PX_TRACE_WORKER;
+      if( (trace_open(&trace, MPI_COMM_WORLD, rank, trole) < 0) || 
+          ((rank == 0) && (rtparams[RT_COORD_WORK] == 1) && (trace_open(&wtrace, MPI_COMM_NULL, rank, PX_TRACE_WORKER) < 0)) )
       {
-         if( ( flist = strchr(argv[ rtparams[RT_ARGS_OPTIDX] ], '=')) != NULL)  
-            flist = &flist[1];
-         else
-            flist = argv[ rtparams[RT_ARGS_OPTIDX] ];  
+         fprintf(stderr, "\"%s\" @L %d RANK %d : Failed to set up the trace.\n", SRC_FILE, __LINE__, rank);
+         MPI_Abort(MPI_COMM_WORLD, ercode);
       }
+      sparams.trace = &trace;
+      wparams.trace = ((rank == 0) ? &wtrace : &trace);
+   }
 
-      if( (chkpntfname = strchr(argv[ rtparams[RT_CHKPNT_OPTIDX] ], '=')) != NULL)  /* maybe long opt */
-         chkpntfname = &chkpntfname[1];
-      else
-         chkpntfname = argv[ rtparams[RT_CHKPNT_OPTIDX] ];  /* standard opt */
-
-      if(rtparams[RT_VERBOSE] >= 1)
-         fprintf(verbout, "MONITOR INIT, RANK %d. VERBOSITY LEVEL %u, PRE-EXT CHK PNT TM %u (s), CHECK PNT FILE \"%s\" ARG FILE \"%s\"\n", 
-                                     rank, rtparams[RT_VERBOSE], rtparams[RT_PREEXIT_TIME], chkpntfname, (flist != NULL ? flist : "NA"));
+   /*-*-*-* begin processing *-*-*-*-*/
 
-      /*-* start the monitor *-*/
-      mret = monitor_proc( subcomm, subrank, rank, rtparams[RT_PREEXIT_TIME], &chkpntidx, &nchkpntidx, rtparams[RT_VERBOSE], verbout );
+   /* the monitor, on rank 1 or a thread of rank 0 */
+   margs.comm = subcomm;
+   margs.crank = subrank;
+   margs.rank = rank;
+   margs.rtparams = rtparams;
+   margs.argv = argv;
+   margs.procpgrm = procpgrm;
+   margs.verbout = verbout;
 
-      if( (mret == 1) && (chkpntidx != NULL) && (flist != NULL) )
+   if(rank == 0) /* master | producer */
+   {
+      /* With --coord-work rank 0 works too, its worker (and the monitor) are threads beside the
+         coordinator. Only the worker thread takes SIGCHLD, it waits for it (see work_proc) */
+      if(rtparams[RT_COORD_WORK] == 1)
       {
-         /* We need to get the original list here; why don't we just get it from rank 0 ? We don't because it is messy, it can 
-            take a long time, dancing around deadlocks, etc.. attempting to interrupt the coordinator (stop it and get the list) 
-            while activitiy is going on. We leave the coordinator alone and let it die on it's own but only after we've written the 
-            incompleted work as given by the monitor. This can be an issue if one is using many 1000's of procs. */
-         if( (wlist = load_work_list(flist, &nlist)) == NULL)
-            fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : monitor failed to load arg list on post proc diff.\n", SRC_FILE, __LINE__, rank);
-         else
+         wparams.nullin = PX_YES;
+         wargs.comm = MPI_COMM_WORLD;
+         wargs.rank = rank;
+         wargs.procpgrm = procpgrm;
+         wargs.wparams = &wparams;
+         wargs.verbose = rtparams[RT_VERBOSE];
+         wargs.verbout = verbout;
+         if( (mret = pthread_create(&wrkthrd, NULL, run_worker, (void*) &wargs)) != 0)
          {
-            if(rtparams[RT_VERBOSE] >= 2)
-               fprintf(verbout, "MONITOR, RANK %d. DUMPING CHECK PNT, %u items to consider...\n", rank, nchkpntidx);
-
-            if( dump_work_list_by_index(chkpntfname, wlist, nlist, chkpntidx, nchkpntidx) < 0)
-               fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : monitor failed to dump work list.\n", SRC_FILE, __LINE__, rank);
+            fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_create Failed (pthrd error %d)\n", SRC_FILE, __LINE__, rank, mret);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+         sigemptyset(&chldmask);
+         sigaddset(&chldmask, SIGCHLD);
+         pthread_sigmask(SIG_BLOCK, &chldmask, &oldmask);
+         if( (rtparams[RT_HAVE_MONITOR] == 1) && ((mret = pthread_create(&monthrd, NULL, run_monitor, (void*) &margs)) != 0) )
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_create Failed (pthrd error %d)\n", SRC_FILE, __LINE__, rank, mret);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+      }
 
-            free(wlist);
-            free(chkpntidx);
+      if(rtparams[RT_RMA] == 1)
+         mret = rma_coordinate_proc( &rsched, &wstore, subcomm, subrank, ((jrnlname != NULL) ? &jrnl : NULL), 
+                                      ((histname != NULL) ? &hist : NULL), rtparams[RT_VERBOSE], verbout);
+      else if(treecomm != MPI_COMM_NULL)
+      {
+         /* the tree members are treecomm ranks 1 to treesize-1 */
+         sparams.slots = &(treeslots[1]);
+         mret = coordinate_proc( &wstore, ((streamlist == 1) ? &wstream : NULL), &etab, treecomm, treesize - 1, 1, 
+                                 subcomm, subrank, ((jrnlname != NULL) ? &jrnl : NULL), ((histname != NULL) ? &hist : NULL), &sparams, &sstats, rtparams[RT_VERBOSE], verbout);
+      }
+      else
+         mret = coordinate_proc( &wstore, ((streamlist == 1) ? &wstream : NULL), &etab, MPI_COMM_WORLD, nworkers, wrankstart, 
+                                 subcomm, subrank, ((jrnlname != NULL) ? &jrnl : NULL), ((histname != NULL) ? &hist : NULL), &sparams, &sstats, rtparams[RT_VERBOSE], verbout);
+      if( (mret >= 0) && (rtparams[RT_COORD_WORK] == 1) )
+      {
+         /* the coordinator's ENDWORK ends both */
+         pthread_join(wrkthrd, NULL);
+         if(rtparams[RT_HAVE_MONITOR] == 1)
+            pthread_join(monthrd, NULL);
+         pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
+         if(wargs.ret < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : work_proc Failed! :(\n", SRC_FILE, __LINE__, rank);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
          }
       }
-      else if(mret < 0)
-         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : monitor_proc Failed! :(\n", SRC_FILE, __LINE__, rank);
+      if( (jrnlname != NULL) && (journal_close(&jrnl) < 0) )
+         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : failed to write the journal.\n", SRC_FILE, __LINE__, rank);
+      if( (statname != NULL) && (status_close(&live) < 0) )
+         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : failed to write the status.\n", SRC_FILE, __LINE__, rank);
+      if(ctrlname != NULL)
+         control_close(&ctrl);
+      if( (histname != NULL) && (mret >= 0) && (history_save(&hist, histname) < 0) )
+         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : failed to write the history.\n", SRC_FILE, __LINE__, rank);
+      history_free(&hist);
+      if(streamlist == 1)
+      {
+         nlist = wstream.nunits;
+         work_stream_close(&wstream);
+      }
+      if(mret < 0)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : coordinate_proc Failed! :(\n", SRC_FILE, __LINE__, rank);
+         MPI_Abort(MPI_COMM_WORLD, ercode);
+      }
    }
+   else if( (rank == 1) && (rtparams[RT_HAVE_MONITOR] == 1) && (rtparams[RT_COORD_WORK] == 0) ) /* monitor, if requested */ 
+      run_monitor(&margs);
    else /* slaves | consumer */
    {
       if(rtparams[RT_VERBOSE] >= 1)
          fprintf(verbout, "CONTACT ESTB RANK %d. VERBOSITY LEVEL %u\n", rank, rtparams[RT_VERBOSE]);
       
-      if(work_proc(rank, rtparams[RT_MAXUNIT_TIME], rtparams[RT_VERBOSE], verbout) < 0)
+      if(rtparams[RT_RMA] == 1)
+      {
+         if(rma_work_proc(&rsched, rank, &wparams, &sparams, (nsize - wrankstart), rtparams[RT_VERBOSE], verbout) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : rma_work_proc Failed! :(\n", SRC_FILE, __LINE__, rank);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+      }
+      else if( (nodecomm != MPI_COMM_NULL) && (noderank == 0) && (nodesize > 1) ) 
+      {
+         /* node leader */
+         if(subcoord_proc(treecomm, nodecomm, rank, procpgrm, &sparams, rtparams[RT_VERBOSE], verbout) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : subcoord_proc Failed! :(\n", SRC_FILE, __LINE__, rank);
+            MPI_Abort(MPI_COMM_WORLD, ercode);
+         }
+      }
+      else if(work_proc( ((nodecomm == MPI_COMM_NULL) ? MPI_COMM_WORLD : ((noderank == 0) ? treecomm : nodecomm)), 
+                         rank, procpgrm, &wparams, rtparams[RT_VERBOSE], verbout) < 0)
       {
          fprintf(stderr, "\"%s\" @L %d RANK %d : work_proc Failed! :(\n", SRC_FILE, __LINE__, rank);
          MPI_Abort(MPI_COMM_WORLD, ercode);
@@ -469,22 +1405,72 @@ int main(int argc, char** argv)
    
    /*-*-*-* end processing *-*-*-*-*/
 
+   if(rtparams[RT_RMA] == 1)
+      rma_sched_close(&rsched);
+
    fflush(verbout);
    /* completion hold */
    if( MPI_Barrier(MPI_COMM_WORLD) != MPI_SUCCESS)
       fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Barrier Failed! :(\n", SRC_FILE, __LINE__, rank); 
    fflush(verbout);
+
+   /* rank 0 takes in the ranks' traces and writes the one file */
+   if(rtparams[RT_TRACE] == 1)
+   {
+      if(trace_close(&trace, (((rank == 0) && (rtparams[RT_COORD_WORK] == 1)) ? &wtrace : NULL), tracename) < 0)
+         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : failed to write the trace.\n", SRC_FILE, __LINE__, rank);
+      else if( (rank == 0) && (rtparams[RT_VERBOSE] >= 1) )
+         fprintf(verbout, "COORDNTR TRACE WRITTEN TO \"%s\"\n", tracename);
+   }
    
    if(rank == 0)
    {
       /* show timing */
       if( (rtparams[RT_VERBOSE] >= 3) || (wrkinf ==1) )
       {
-         if(wrkinf == 0) 
+         if( (wrkinf == 0) && (streamlist == 0) ) 
             fprintf(verbout, "ARG LIST ON EXIT:\n");
             
-         fprint_worklist(verbout, wlist, nlist);
+         if(streamlist == 0) 
+            fprint_worklist(verbout, &wstore);
+         fprintf(verbout, "MESSAGES %lu dispatch, %lu completion : %.3f messages per unit (max chunk %u, prefetch %u, slots %u)\n", 
+                   sstats.dispatch_msgs, sstats.complete_msgs, 
+                   ((double)(sstats.dispatch_msgs + sstats.complete_msgs)) / ((double)((nlist > 0) ? nlist : 1)), sparams.chunkmax, sparams.depth, sparams.wslots);
+         if(sstats.backups > 0)
+            fprintf(verbout, "BACKUPS %lu run, %lu finished before the first copy\n", sstats.backups, sstats.backup_wins);
+         if(sparams.retries > 0)
+            fprintf(verbout, "RETRIES %lu run, %lu units failed after them\n", sstats.retried, sstats.failed);
+         /* CPU near the wall time is CPU bound, well under it with many blocks or voluntary switches is I/O bound */
+         if(sstats.nusage > 0)
+            fprintf(verbout, "RUSAGE %lu runs : CPU %.1f s user %.1f s sys, %.1f%% of %.1f s wall : MAX RSS %.1f MB (unit %u), mean %.1f MB : "
+                             "BLOCKS %llu in %llu out : CSW %llu vol %llu invol\n", sstats.nusage, 
+                    sstats.utime_ms / 1000.0, sstats.stime_ms / 1000.0, 
+                    ((sstats.wall_ms > 0) ? (100.0 * (double)(sstats.utime_ms + sstats.stime_ms) / (double)sstats.wall_ms) : 0.0), 
+                    sstats.wall_ms / 1000.0, sstats.maxrss_kb / 1024.0, sstats.maxrss_id, 
+                    (sstats.rss_kb / (double)sstats.nusage) / 1024.0, sstats.inblock, sstats.oublock, sstats.nvcsw, sstats.nivcsw);
+         if(sstats.nlife > 0)
+            fprintf(verbout, "LIFECYCLE %lu units, mean seconds : %.6f queued on the worker, %.6f run, %.6f held for the report, %.6f in messages and the coordinator\n", 
+                    sstats.nlife, (sstats.queue_ns / (double)sstats.nlife) / 1e9, (sstats.run_ns / (double)sstats.nlife) / 1e9, 
+                    (sstats.held_ns / (double)sstats.nlife) / 1e9, (sstats.transit_ns / (double)sstats.nlife) / 1e9);
       }
+      /* mostly idle, the coordinator keeps up and the workload sets the pace */
+      if( (sparams.profile == PX_YES) && (sstats.prof_ns > 0) )
+      {
+         for(i = 0, profsum = 0; i < PX_PROF_NPHASES; i++)
+            profsum += sstats.prof[i];
+         fprintf(verbout, "PROFILE coordinator %.3f s : recv %.1f%%, unpack %.1f%%, notify %.1f%%, record %.1f%%, pack %.1f%%, send %.1f%%, read %.1f%%, idle %.1f%%, other %.1f%%\n", 
+                 sstats.prof_ns / 1e9, PROF_PCT(sstats, PX_PROF_RECV), PROF_PCT(sstats, PX_PROF_UNPACK), PROF_PCT(sstats, PX_PROF_NOTIFY), 
+                 PROF_PCT(sstats, PX_PROF_RECORD), PROF_PCT(sstats, PX_PROF_PACK), PROF_PCT(sstats, PX_PROF_SEND), PROF_PCT(sstats, PX_PROF_READ), 
+                 PROF_PCT(sstats, PX_PROF_IDLE), ((profsum < sstats.prof_ns) ? (100.0 * (double)(sstats.prof_ns - profsum) / (double)sstats.prof_ns) : 0.0));
+         fprintf(verbout, "PROFILE the run is limited by the %s\n", ((PROF_PCT(sstats, PX_PROF_IDLE) >= 50.0) ? "workload (the coordinator is mostly idle)" : "scheduler (the coordinator is mostly busy)"));
+      }
+      if(sstats.failed > 0)
+         fprintf(stderr, "WARN: %lu units failed after %u retries%s.\n", sstats.failed, sparams.retries, 
+                 ((chkpntfname != NULL) ? ", they are left in the checkpoint file" : ""));
+      if(sstats.cancelled > 0)
+         fprintf(stderr, "WARN: %lu units were cancelled and not run.\n", sstats.cancelled);
+      if(sstats.drained == PX_YES)
+         fprintf(stderr, "WARN: the run was drained, %lu units are not complete.\n", sstats.notdone);
       if(rtparams[RT_VERBOSE] >= 1)
       {
          gettimeofday(&tvl2, NULL);
@@ -492,21 +1478,29 @@ int main(int argc, char** argv)
          fprintf(verbout, "WALL TM %lu seconds : %.2f minutes : %.2f hours (np %d, units %u)\n", 
                    (unsigned long int)secs, ((double)secs) / 60.0, (((double)secs) / 60.0) / 60.0, nsize, nlist); 
       }
-      /* clean up if needed */
-      if(tempfname[0] != '\0')
-      {
-         if( remove(tempfname) < 0)
-            fprintf(stderr, "\"%s\" @L %d : remove : %s\n", SRC_FILE, __LINE__, strerror(errno));
-      }
-      free(wlist);
+      work_store_close(&wstore);
    }
+   exec_table_free(&etab);
+   if(rank != 0)
+      free(procpgrm);
+
+   if(nodecomm != MPI_COMM_NULL)
+      MPI_Comm_free(&nodecomm);
+   if(treecomm != MPI_COMM_NULL)
+      MPI_Comm_free(&treecomm);
+   free(treeslots);
 
+   if(dispcomm != MPI_COMM_NULL)
+      MPI_Comm_free(&dispcomm);
    if(rtparams[RT_HAVE_MONITOR] == 1) 
    {
       if(subcomm != MPI_COMM_NULL)
        MPI_Comm_free(&subcomm);
-      MPI_Group_free(&maingrp);
-      MPI_Group_free(&crdmntgrp);
+      if(rtparams[RT_COORD_WORK] == 0)
+      {
+         MPI_Group_free(&maingrp);
+         MPI_Group_free(&crdmntgrp);
+      }
    }
 
    MPI_Finalize();
@@ -52,6 +52,29 @@
 #ifdef HAVE_SYS_WAIT_H 
  #include <sys/wait.h>
 #endif
+#ifdef HAVE_SPAWN_H 
+ #include <spawn.h>
+#endif
+#ifdef HAVE_POLL_H 
+ #include <poll.h>
+#endif
+#ifdef HAVE_FCNTL_H 
+ #include <fcntl.h>
+#endif
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_SYS_SYSCALL_H)
+ #include <sys/epoll.h>
+ #include <sys/syscall.h>
+#endif
+#ifdef HAVE_SYS_PRCTL_H 
+ #include <sys/prctl.h>
+#endif
+#ifdef HAVE_SYS_RESOURCE_H 
+ #include <sys/time.h>
+ #include <sys/resource.h>
+#endif
+#ifdef HAVE_FNMATCH_H 
+ #include <fnmatch.h>
+#endif
 
 #ifdef HAVE_PTHREAD_H 
  #include <pthread.h>
@@ -63,11 +86,13 @@
 
 #define MAX_PRINT_MINUTES 10080 /* 1 week in hours (this is only used for pretty printing...) */
 
+/* the wait status given to a unit that could not be started, as the shell exits on a missing command */
+#define PX_WSTAT_NOSTART (127 << 8)
+
 static const char* SRC_FILE = __FILE__;
 
-/* subprocess (child) that will be used in xpopen */
-static pid_t MODchldpid;
-static volatile int MODTexceed;
+/* for the children's environment */
+extern char** environ;
 
 /* These are for the pthreaded monitor */
 static int stopissed = 0; /* init to 0 is important here */
@@ -79,113 +104,223 @@ struct ptparams
    FILE* verbout;
 };
 
-#if defined(HAVE_SIGNAL_H) && defined(HAVE_SIGACTION) && defined(HAVE_ALARM) 
-/*--------------------------------------------------------------------------------------
-* Local module routine that will kill unruly, w.r.t. maxutime, child processes 
+#ifdef HAVE_SYS_RESOURCE_H 
+/*--------------------------------------------------------------------
+* Local module routine, puts what ru has used (less base, if not NULL) in wru.
+* The peak resident set is not a sum, it is taken as is (kB on Linux).
 */
-static void child_killpg(int sig) 
+static void work_usage(WORK_RUSAGE* wru, struct rusage* ru, struct rusage* base)
 {
-   MODTexceed = PX_YES;
-   kill(-MODchldpid, SIGKILL); /* this should kill the whole group under the worker */
-}/* child_killpg */
+   long long ut, st;
+
+   ut = ((long long)ru->ru_utime.tv_sec * 1000LL) + ((long long)ru->ru_utime.tv_usec / 1000LL);
+   st = ((long long)ru->ru_stime.tv_sec * 1000LL) + ((long long)ru->ru_stime.tv_usec / 1000LL);
+   wru->maxrss_kb = (ru->ru_maxrss > 0) ? (unsigned int)ru->ru_maxrss : 0;
+   wru->inblock = (unsigned int)ru->ru_inblock;
+   wru->oublock = (unsigned int)ru->ru_oublock;
+   wru->nvcsw = (unsigned int)ru->ru_nvcsw;
+   wru->nivcsw = (unsigned int)ru->ru_nivcsw;
+   if(base != NULL)
+   {
+      ut -= ((long long)base->ru_utime.tv_sec * 1000LL) + ((long long)base->ru_utime.tv_usec / 1000LL);
+      st -= ((long long)base->ru_stime.tv_sec * 1000LL) + ((long long)base->ru_stime.tv_usec / 1000LL);
+      wru->inblock -= (unsigned int)base->ru_inblock;
+      wru->oublock -= (unsigned int)base->ru_oublock;
+      wru->nvcsw -= (unsigned int)base->ru_nvcsw;
+      wru->nivcsw -= (unsigned int)base->ru_nivcsw;
+   }
+   wru->utime_ms = (ut > 0) ? (unsigned int)ut : 0;
+   wru->stime_ms = (st > 0) ? (unsigned int)st : 0;
+}/* work_usage */
+#endif
 
+#if defined(HAVE_SIGNAL_H) && defined(HAVE_SIGACTION) && defined(HAVE_SYS_WAIT_H) 
+ #define PX_CHILD_SLOTS 1
+ /* a worker waits on its children's pidfds in an epoll set where the kernel has them 
+    (Linux 5.3 and up, checked when the first child starts), else on SIGCHLD */
+ #if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_SYS_SYSCALL_H) && defined(SYS_pidfd_open)
+  #define PX_PIDFD 1
+ #endif
+ /* the orphans of a unit's shell come back to the worker to be reaped, so a stopped
+    unit's group is seen to be gone rather than left as zombies (Linux 3.4 and up) */
+ #if defined(HAVE_SYS_PRCTL_H) && defined(PR_SET_CHILD_SUBREAPER)
+  #define PX_SUBREAPER 1
+ #endif
+ /* the children are reaped with what they used */
+ #if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_WAIT4)
+  #define PX_RUSAGE 1
+ #endif
 /*------------------------------------------------------------------------------
 * DESCRIPTION:
-*   A local module routine for running a subprocess. This routine allows for 
-*   a timeout interrupt if the subprocess gets stuck and takes too long.
+*   A local module routine that starts a subprocess in its own process group, so 
+*   the whole group can be killed if it takes too long. The caller reaps it, see 
+*   work_reap. With argv NULL cmd is run by SHL_PATH -c, otherwise argv[0] is run
+*   directly (searched for in PATH) and cmd is not used. childmask is the signal 
+*   mask the command starts with, with nullin PX_YES its stdin is /dev/null. 
+*   posix_spawn is used where there is one, so the worker's (large, MPI registered) 
+*   address space is not copied for each unit. Returns the child's pid, < 0 on failure.
 */
-static int xpopen(char* cmd, unsigned int maxutime, unsigned int verbose, FILE* verbout)
+static pid_t xpspawn(char* cmd, char** argv, sigset_t* childmask, int nullin)
 {
-   struct sigaction sigst, oldsig;
-   pid_t wtpid;
-   int pstat; 
-
-   /* clear these */
-   MODchldpid = 0;
-   MODTexceed = PX_NO;
-
-   memset(&sigst, 0, sizeof(struct sigaction));
-   memset(&oldsig, 0, sizeof(struct sigaction));
+   char* shargv[4];
+   pid_t pid;
+#if defined(HAVE_SPAWN_H) && defined(HAVE_POSIX_SPAWN) 
+   posix_spawnattr_t attr;
+   posix_spawn_file_actions_t fact;
+   int rc;
+#else
+   int fd;
+#endif
 
-   sigemptyset(&sigst.sa_mask); 
-   sigst.sa_handler = child_killpg;
-   sigst.sa_flags = 0;
+   shargv[0] = SHL_STR;
+   shargv[1] = "-c";
+   shargv[2] = cmd;
+   shargv[3] = NULL;
 
-   if( sigaction(SIGALRM, &sigst, &oldsig) < 0)
+#if defined(HAVE_SPAWN_H) && defined(HAVE_POSIX_SPAWN) 
+   if( (rc = posix_spawnattr_init(&attr)) != 0)
    {
-      fprintf(stderr, "\"%s\" @L %d : sigaction failed to set SIGALRM : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      fprintf(stderr, "\"%s\" @L %d : posix_spawnattr_init failed : %s\n", SRC_FILE, __LINE__, strerror(rc));
       return -1;
    }
-   /* set max time if needed */
-   if(maxutime > 0) 
-      alarm(maxutime);
-
-   if( (MODchldpid = fork()) < 0)
+   /* a new group leader, with the usual signal mask */
+   posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK);
+   posix_spawnattr_setpgroup(&attr, 0);
+   posix_spawnattr_setsigmask(&attr, childmask);
+   posix_spawn_file_actions_init(&fact);
+   if(nullin == PX_YES)
+      posix_spawn_file_actions_addopen(&fact, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+   if(argv != NULL)
+      rc = posix_spawnp(&pid, argv[0], &fact, &attr, argv, environ);
+   else
+      rc = posix_spawn(&pid, SHL_PATH, &fact, &attr, shargv, environ);
+   posix_spawn_file_actions_destroy(&fact);
+   posix_spawnattr_destroy(&attr);
+   if(rc != 0)
+   {
+      fprintf(stderr, "\"%s\" @L %d : posix_spawn of \"%s\" failed : %s\n", SRC_FILE, __LINE__, 
+                                            ((argv != NULL) ? argv[0] : SHL_PATH), strerror(rc));
+      return -1;
+   }
+#else
+   if( (pid = fork()) < 0)
    {
       fprintf(stderr, "\"%s\" @L %d : fork failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
-      if(maxutime > 0) 
-         alarm(0);
-      if( sigaction(SIGALRM, &oldsig, NULL) < 0)
-         fprintf(stderr, "\"%s\" @L %d : sigaction failed to restore SIGALRM : %s\n", SRC_FILE, __LINE__, strerror(errno));
       return -1;
    }
-   
-   if(MODchldpid == 0) /* child */
+   if(pid == 0) /* child */
    {
+      sigprocmask(SIG_SETMASK, childmask, NULL);
       /* set a new group leader here... */
       if(setpgid(0, 0) < 0) 
       {
          fprintf(stderr, "\"%s\" @L %d : setpgid failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
-         exit(1); /* exit child */
+         _exit(1); /* exit child */
       } 
-
-      if( execl(SHL_PATH, SHL_STR, "-c", cmd, NULL) < 0)
+      if( (nullin == PX_YES) && ((fd = open("/dev/null", O_RDONLY)) >= 0) )
       {
-         fprintf(stderr, "\"%s\" @L %d : execl failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
-         _exit(127);
+         dup2(fd, STDIN_FILENO);
+         close(fd);
       }
+      if(argv != NULL)
+         execvp(argv[0], argv);
+      else
+         execv(SHL_PATH, shargv);
+      fprintf(stderr, "\"%s\" @L %d : exec failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      _exit(127);
    }
-   else /* parent */
+   /* and here too, so the group exists for a kill whichever side runs first */
+   setpgid(pid, pid);
+#endif
+   return pid;
+}/* xpspawn */
+
+/*------------------------------------------------------------------------------
+* Local module routine for --no-shell, splits a command line into argv in place.
+* Words are separated by blanks and quotes are removed. '...' is taken as is, a 
+* backslash escapes the next character (in "..." only ", \, $ and `, as sh does).
+* Nothing is expanded. Returns the word count, < 0 on failure.
+*/
+static int split_args(char* line, char*** argv, int* argvcap)
+{
+   char** nargv;
+   char *src, *dst;
+   char quote;
+   int argc = 0;
+
+   src = dst = line;
+   while(*src != '\0')
    {
-      while( (wtpid = waitpid(MODchldpid, &pstat, 0)) < 0)
+      while( (*src == ' ') || (*src == '\t') )
+         src++;
+      if(*src == '\0')
+         break;
+      if( (argc + 2) > *argvcap)
       {
-         if(errno != EINTR) 
+         if( (nargv = (char**) realloc(*argv, (argc + 16) * sizeof(char*))) == NULL)
          {
-            if(maxutime > 0) 
-               alarm(0);
-            if( sigaction(SIGALRM, &oldsig, NULL) < 0)
-               fprintf(stderr, "\"%s\" @L %d : sigaction failed to restore SIGALRM : %s\n", SRC_FILE, __LINE__, strerror(errno));
+            fprintf(stderr, "\"%s\" @L %d : realloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
             return -1;
          }
+         *argv = nargv;
+         *argvcap = argc + 16;
       }
-      /* clear and restore */
-      if(maxutime > 0) 
-         alarm(0);
-      if( sigaction(SIGALRM, &oldsig, NULL) < 0)
+      (*argv)[argc++] = dst;
+      quote = '\0';
+      while( (*src != '\0') && ((quote != '\0') || ((*src != ' ') && (*src != '\t'))) )
       {
-         fprintf(stderr, "\"%s\" @L %d : sigaction failed to restore SIGALRM : %s\n", SRC_FILE, __LINE__, strerror(errno));
-         return -1;
+         if( (quote == '\0') && ((*src == '\'') || (*src == '"')) )
+            quote = *src++;
+         else if( (quote != '\0') && (*src == quote) )
+         {
+            quote = '\0';
+            src++;
+         }
+         else if( (*src == '\\') && (quote != '\'') && (src[1] != '\0') && 
+                  ((quote == '\0') || (strchr("\"\\$`", src[1]) != NULL)) )
+         {
+            *dst++ = src[1];
+            src += 2;
+         }
+         else
+            *dst++ = *src++;
       }
+      if(*src != '\0')
+         src++;
+      *dst++ = '\0';
    }
-   return 0;
-}/* xpopen */
+   if(argc > 0)
+      (*argv)[argc] = NULL;
+   return argc;
+}/* split_args */
 #else
 /*--------------------------------------------------------------------
-* Local module routine (run pipe). Simple version, see above...
+* Local module routine (run pipe). Simple version for platforms without 
+* signals, the command runs to completion and is never killed. Returns
+* its wait status, < 0 if it could not be run, and what it used in wru.
 */
-static int xpopen(char* cmd, unsigned int maxutime, unsigned int verbose, FILE* verbout)
+static int xpopen(char* cmd, WORK_RUSAGE* wru, unsigned int verbose, FILE* verbout)
 {
-   /* maxutime isn't used here since platform/build doesn't support alarms, signals, etc... */
    FILE* pip = NULL;
-   MODTexceed = PX_NO;
+   int pstat;
+#if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_GETRUSAGE)
+   struct rusage ru0, ru1;
+
+   /* the command is the only child reaped in between */
+   getrusage(RUSAGE_CHILDREN, &ru0);
+#endif
    if( (pip = popen(cmd, "w")) == NULL)
    {
       fprintf(stderr, "%s @L %d : popen failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
       return -1;
    }
-   if( pclose(pip) < 0)
+   if( (pstat = pclose(pip)) < 0)
       fprintf(stderr, "%s @L %d : pclose failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
-   return 0;
+#if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_GETRUSAGE)
+   else if(getrusage(RUSAGE_CHILDREN, &ru1) == 0)
+      work_usage(wru, &ru1, &ru0);
+#endif
+   return pstat;
 }/* xpopen */
 #endif
 
@@ -262,54 +397,106 @@ void* pbs_poll(void* targs)
 }/* pbs_poll */
 
 /*--------------------------------------------------------------------
-* Local module routine, ez-now-time
+* See pxargs.h for details
 */
-static long now_tm_secs()
+long long now_tm_nsecs()
 {
    struct timeval tvl;
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+
+   if( clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+      return ((long long)ts.tv_sec * 1000000000LL) + (long long)ts.tv_nsec;
+#endif
    memset(&tvl, 0 , sizeof(struct timeval));
    gettimeofday(&tvl, NULL);
-   return ((long)tvl.tv_sec);
-}/* now_tm_secs */
+   return ((long long)tvl.tv_sec * 1000000000LL) + ((long long)tvl.tv_usec * 1000LL);
+}/* now_tm_nsecs */
+
+/*--------------------------------------------------------------------
+* Local module routine, milliseconds on the same clock, for the units' 
+* time limits
+*/
+static long long now_tm_msecs()
+{
+   return now_tm_nsecs() / 1000000LL;
+}/* now_tm_msecs */
+
+/*--------------------------------------------------------------------
+* Local module routine, grows a message buffer to at least need bytes
+*/
+static int grow_msgbuf(unsigned char** buf, int* bufsize, int need)
+{
+   unsigned char* nbuf;
+   if( (*buf != NULL) && (need <= *bufsize) )
+      return 0;
+   if( (nbuf = (unsigned char*) realloc(*buf, need)) == NULL)
+   {
+      fprintf(stderr, "\"%s\" @L %d : realloc failed (%d bytes) : %s\n", SRC_FILE, __LINE__, need, strerror(errno));
+      return -1;
+   }
+   *buf = nbuf;
+   *bufsize = need;
+   return 0;
+}/* grow_msgbuf */
 
 /*--------------------------------------------------------------------
-* Local module routine
+* Local module routine, probes for the next message from src with tag on 
+* comm, sizes buf to fit it and receives it. The number of packed bytes 
+* received is returned in msglen.
 */
-static void set_work_tm_secs(WORK_UNIT* worku) 
-{ 
-   worku->proc_secs = now_tm_secs();
-}/* set_work_tm_secs */
+static int mpi_recv_packed( int src, int tag, MPI_Comm comm, unsigned char** buf, 
+                            int* bufsize, int* msglen, MPI_Status* status )
+{
+   MPI_Status pstatus;
+
+   if( MPI_Probe(src, tag, comm, &pstatus) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Probe Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   if( MPI_Get_count(&pstatus, MPI_PACKED, msglen) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Get_count Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   /* zero length messages (e.g. ENDWORK) still need a buffer */
+   if( grow_msgbuf(buf, bufsize, ((*msglen > 0) ? *msglen : 1)) < 0)
+      return -1;
+   if( MPI_Recv(*buf, *msglen, MPI_PACKED, pstatus.MPI_SOURCE, pstatus.MPI_TAG, comm, status) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Recv Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   return 0;
+}/* mpi_recv_packed */
 
 /*--------------------------------------------------------------------
 * See pxargs.h for details
 */
-int mpi_sizeof_worku()
+int mpi_sizeof_worku(WORK_UNIT* worku)
 {
    int bufsize;
    int packsize = 0;
 
-   /* args */
-   MPI_Pack_size(PXARGLENMAX, MPI_CHAR, MPI_COMM_WORLD, &packsize);
+   /* version and field count */
+   MPI_Pack_size(2, MPI_UNSIGNED, MPI_COMM_WORLD, &packsize);
    bufsize = packsize; 
-   
-   /* 1 for long for timing... */ 
+
+   /* header fields */ 
    packsize = 0;
-   MPI_Pack_size(1, MPI_LONG, MPI_COMM_WORLD, &packsize);
+   MPI_Pack_size(WU_NFIELDS, MPI_LONG, MPI_COMM_WORLD, &packsize);
    bufsize += packsize; 
 
+   /* only the bytes in use for args and path */
    packsize = 0;
-   MPI_Pack_size(1, MPI_INT, MPI_COMM_WORLD, &packsize);
-   /* X 2 for all ints */ 
-   bufsize += packsize * 2; 
-   
-   /* 1 unsigned int */
-   packsize = 0;
-   MPI_Pack_size(1, MPI_UNSIGNED, MPI_COMM_WORLD, &packsize);
-   bufsize += packsize;
+   if(worku->pargs != NULL)
+      MPI_Pack_size((int)strlen(worku->pargs), MPI_CHAR, MPI_COMM_WORLD, &packsize);
+   bufsize += packsize; 
 
-   /* one file path */
    packsize = 0;
-   MPI_Pack_size(PATH_MAX, MPI_CHAR, MPI_COMM_WORLD, &packsize);
+   if(worku->procpath != NULL)
+      MPI_Pack_size((int)strlen(worku->procpath), MPI_CHAR, MPI_COMM_WORLD, &packsize);
    bufsize += packsize; 
 
    return bufsize;
@@ -318,118 +505,451 @@ int mpi_sizeof_worku()
 /*--------------------------------------------------------------------
 * See pxargs.h for details
 */
-void mpi_worku_serialize(WORK_UNIT* worku, void* buf, int bufsize)
+int mpi_worku_serialize(WORK_UNIT* worku, void* buf, int bufsize, int* position)
 {
-   int boffset = 0;
-   memset(buf, 0, bufsize);
-   MPI_Pack(worku->pargs, PXARGLENMAX, MPI_CHAR, buf, bufsize, &boffset, MPI_COMM_WORLD); 
-   MPI_Pack(&(worku->proc_secs), 1, MPI_LONG, buf, bufsize, &boffset, MPI_COMM_WORLD); 
-   MPI_Pack(&(worku->resrank), 1, MPI_INT, buf, bufsize, &boffset, MPI_COMM_WORLD); 
-   MPI_Pack(&(worku->id_tag), 1, MPI_UNSIGNED, buf, bufsize, &boffset, MPI_COMM_WORLD); 
-   MPI_Pack(&(worku->was_killed), 1, MPI_INT, buf, bufsize, &boffset, MPI_COMM_WORLD); 
-   MPI_Pack(worku->procpath, PATH_MAX, MPI_CHAR, buf, bufsize, &boffset, MPI_COMM_WORLD); 
-   return;
+   unsigned int vhdr[2];
+   long fields[WU_NFIELDS];
+
+   if( (*position + mpi_sizeof_worku(worku)) > bufsize)
+   {
+      fprintf(stderr, "\"%s\" @L %d : work unit %u does not fit the message buffer\n", SRC_FILE, __LINE__, worku->id_tag);
+      return -1;
+   }
+   vhdr[0] = WU_WIRE_VERSION;
+   vhdr[1] = WU_NFIELDS;
+   fields[WU_F_IDTAG] = (long)worku->id_tag;
+   fields[WU_F_RESRANK] = (long)worku->resrank;
+   fields[WU_F_KILLED] = (long)worku->was_killed;
+   fields[WU_F_PROCSECS] = worku->proc_secs;
+   fields[WU_F_ARGLEN] = (long)((worku->pargs != NULL) ? strlen(worku->pargs) : 0);
+   fields[WU_F_PATHLEN] = (long)((worku->procpath != NULL) ? strlen(worku->procpath) : 0);
+   fields[WU_F_EXECIDX] = (long)worku->exec_idx;
+   fields[WU_F_EXITCODE] = (long)worku->exit_code;
+   fields[WU_F_TERMSIG] = (long)worku->term_sig;
+   fields[WU_F_MAXMSECS] = (long)worku->maxumsecs;
+   fields[WU_F_WALLMS] = (long)worku->ru.wall_ms;
+   fields[WU_F_UTIMEMS] = (long)worku->ru.utime_ms;
+   fields[WU_F_STIMEMS] = (long)worku->ru.stime_ms;
+   fields[WU_F_MAXRSS] = (long)worku->ru.maxrss_kb;
+   fields[WU_F_INBLOCK] = (long)worku->ru.inblock;
+   fields[WU_F_OUBLOCK] = (long)worku->ru.oublock;
+   fields[WU_F_NVCSW] = (long)worku->ru.nvcsw;
+   fields[WU_F_NIVCSW] = (long)worku->ru.nivcsw;
+   fields[WU_F_TRECV] = (long)worku->tm.trecv;
+   fields[WU_F_TSTART] = (long)worku->tm.tstart;
+   fields[WU_F_TEXIT] = (long)worku->tm.texit;
+   fields[WU_F_TREPORT] = (long)worku->tm.treport;
+
+   MPI_Pack(vhdr, 2, MPI_UNSIGNED, buf, bufsize, position, MPI_COMM_WORLD); 
+   MPI_Pack(fields, WU_NFIELDS, MPI_LONG, buf, bufsize, position, MPI_COMM_WORLD); 
+   if(fields[WU_F_ARGLEN] > 0)
+      MPI_Pack(worku->pargs, (int)fields[WU_F_ARGLEN], MPI_CHAR, buf, bufsize, position, MPI_COMM_WORLD); 
+   if(fields[WU_F_PATHLEN] > 0)
+      MPI_Pack(worku->procpath, (int)fields[WU_F_PATHLEN], MPI_CHAR, buf, bufsize, position, MPI_COMM_WORLD); 
+   return 0;
 }/* mpi_worku_serialize */
 
 /*--------------------------------------------------------------------
 * See pxargs.h for details
 */
-void mpi_worku_unserialize(void* buf, int bufsize, WORK_UNIT* work)
+int mpi_worku_unserialize(void* buf, int bufsize, int* position, WORK_UNIT* work)
 {
-   int boffset = 0;
+   unsigned int vhdr[2];
+   long fields[WU_NFIELDS];
+   long skip;
+   unsigned int f;
+
    memset(work, 0, sizeof(WORK_UNIT));
-   MPI_Unpack(buf, bufsize, &boffset, work->pargs, PXARGLENMAX, MPI_CHAR, MPI_COMM_WORLD);
-   MPI_Unpack(buf, bufsize, &boffset, &(work->proc_secs), 1, MPI_LONG, MPI_COMM_WORLD);
-   MPI_Unpack(buf, bufsize, &boffset, &(work->resrank), 1, MPI_INT, MPI_COMM_WORLD);
-   MPI_Unpack(buf, bufsize, &boffset, &(work->id_tag), 1, MPI_UNSIGNED, MPI_COMM_WORLD);
-   MPI_Unpack(buf, bufsize, &boffset, &(work->was_killed), 1, MPI_INT, MPI_COMM_WORLD);
-   MPI_Unpack(buf, bufsize, &boffset, work->procpath, PATH_MAX, MPI_CHAR, MPI_COMM_WORLD);
-   return;
+   memset(fields, 0, sizeof(long) * WU_NFIELDS);
+   if( MPI_Unpack(buf, bufsize, position, vhdr, 2, MPI_UNSIGNED, MPI_COMM_WORLD) != MPI_SUCCESS)
+      return -1;
+   if( (vhdr[0] == 0) || (vhdr[0] > WU_WIRE_VERSION) )
+   {
+      fprintf(stderr, "\"%s\" @L %d : unknown work unit wire version %u\n", SRC_FILE, __LINE__, vhdr[0]);
+      return -1;
+   }
+   /* known fields, then skip any a newer sender appended */
+   for(f = 0; f < vhdr[1]; f++)
+   {
+      if( MPI_Unpack(buf, bufsize, position, ((f < WU_NFIELDS) ? &fields[f] : &skip), 1, MPI_LONG, MPI_COMM_WORLD) != MPI_SUCCESS)
+         return -1;
+   }
+   work->id_tag = (unsigned int)fields[WU_F_IDTAG];
+   work->resrank = (int)fields[WU_F_RESRANK];
+   work->was_killed = (int)fields[WU_F_KILLED];
+   work->proc_secs = fields[WU_F_PROCSECS];
+   work->exec_idx = (unsigned int)fields[WU_F_EXECIDX];
+   work->exit_code = (int)fields[WU_F_EXITCODE];
+   work->term_sig = (int)fields[WU_F_TERMSIG];
+   work->maxumsecs = (unsigned int)fields[WU_F_MAXMSECS];
+   work->ru.wall_ms = (unsigned int)fields[WU_F_WALLMS];
+   work->ru.utime_ms = (unsigned int)fields[WU_F_UTIMEMS];
+   work->ru.stime_ms = (unsigned int)fields[WU_F_STIMEMS];
+   work->ru.maxrss_kb = (unsigned int)fields[WU_F_MAXRSS];
+   work->ru.inblock = (unsigned int)fields[WU_F_INBLOCK];
+   work->ru.oublock = (unsigned int)fields[WU_F_OUBLOCK];
+   work->ru.nvcsw = (unsigned int)fields[WU_F_NVCSW];
+   work->ru.nivcsw = (unsigned int)fields[WU_F_NIVCSW];
+   work->tm.trecv = (long long)fields[WU_F_TRECV];
+   work->tm.tstart = (long long)fields[WU_F_TSTART];
+   work->tm.texit = (long long)fields[WU_F_TEXIT];
+   work->tm.treport = (long long)fields[WU_F_TREPORT];
+
+   if( (fields[WU_F_ARGLEN] < 0) || (fields[WU_F_PATHLEN] < 0) || (fields[WU_F_PATHLEN] >= PATH_MAX) || 
+       (work->exec_idx >= PXEXECMAX) )
+   {
+      fprintf(stderr, "\"%s\" @L %d : bad work unit lengths (%ld, %ld)\n", SRC_FILE, __LINE__, fields[WU_F_ARGLEN], fields[WU_F_PATHLEN]);
+      return -1;
+   }
+   if(fields[WU_F_ARGLEN] > 0)
+   {
+      if( (work->pargs = (char*) malloc(fields[WU_F_ARGLEN] + 1)) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d : malloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
+      }
+      if( MPI_Unpack(buf, bufsize, position, work->pargs, (int)fields[WU_F_ARGLEN], MPI_CHAR, MPI_COMM_WORLD) != MPI_SUCCESS)
+      {
+         free(work->pargs);
+         work->pargs = NULL;
+         return -1;
+      }
+      work->pargs[fields[WU_F_ARGLEN]] = '\0';
+   }
+   if(fields[WU_F_PATHLEN] > 0)
+   {
+      if( (work->procpath = (char*) malloc(fields[WU_F_PATHLEN] + 1)) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d : malloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         free(work->pargs);
+         work->pargs = NULL;
+         return -1;
+      }
+      if( MPI_Unpack(buf, bufsize, position, work->procpath, (int)fields[WU_F_PATHLEN], MPI_CHAR, MPI_COMM_WORLD) != MPI_SUCCESS)
+      {
+         free(work->pargs); free(work->procpath);
+         work->pargs = NULL;
+         work->procpath = NULL;
+         return -1;
+      }
+      work->procpath[fields[WU_F_PATHLEN]] = '\0';
+   }
+   return 0;
 }/* mpi_worku_unserialize */
 
 /*--------------------------------------------------------------------
 * See pxargs.h for details
 */
-WORK_UNIT* load_work_list(const char* fname, unsigned int* n)
+int mpi_sizeof_workmsg(WORK_UNIT** units, unsigned int n)
+{
+   int bufsize = 0;
+   unsigned int i;
+
+   /* unit count */
+   MPI_Pack_size(1, MPI_UNSIGNED, MPI_COMM_WORLD, &bufsize);
+   for(i = 0; i < n; i++)
+      bufsize += mpi_sizeof_worku(units[i]);
+   return bufsize;
+}/* mpi_sizeof_workmsg */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int mpi_workmsg_serialize(WORK_UNIT** units, unsigned int n, void* buf, int bufsize, int* position)
 {
-   WORK_UNIT* worku = NULL;
-   FILE* fin;
-   char lnbuf[PXARGLENMAX+8];
-   char *sep = "\r\n";
-   char* next;
-   char* tok;
    unsigned int i;
 
-   memset(lnbuf, 0, PXARGLENMAX+8);
+   if( MPI_Pack(&n, 1, MPI_UNSIGNED, buf, bufsize, position, MPI_COMM_WORLD) != MPI_SUCCESS)
+      return -1;
+   for(i = 0; i < n; i++)
+   {
+      if( mpi_worku_serialize(units[i], buf, bufsize, position) < 0)
+         return -1;
+   }
+   return 0;
+}/* mpi_workmsg_serialize */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int mpi_workmsg_nunits(void* buf, int bufsize, int* position, unsigned int* n)
+{
    *n = 0;
-   if( (fin = fopen(fname, "r")) == NULL)
+   if( MPI_Unpack(buf, bufsize, position, n, 1, MPI_UNSIGNED, MPI_COMM_WORLD) != MPI_SUCCESS)
+      return -1;
+   return 0;
+}/* mpi_workmsg_nunits */
+
+/*--------------------------------------------------------------------
+* Local module routine, passes ENDWORK on down a binomial tree over the 
+* coordinator (node 0, rank 0 of comm) and the workers (node i is rank 
+* rankstart+i-1), node is the caller's place in it. Each rank sends at most 
+* log2(nworkers+1) of them and the last worker has it after as many hops.
+*/
+static int mpi_endwork_tree(MPI_Comm comm, int rankstart, int nworkers, int node)
+{
+   MPI_Request reqs[sizeof(int) * CHAR_BIT];
+   unsigned int mask;
+   int nreq = 0, rc = 0;
+
+   /* node's children are node+mask for each power of two mask above node */
+   for(mask = 1; mask <= (unsigned int)nworkers; mask <<= 1)
    {
-      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
-      return NULL;
+      if( ((unsigned int)node >= mask) || (((unsigned int)node + mask) > (unsigned int)nworkers) )
+         continue;
+      if( MPI_Isend(0, 0, MPI_INT, rankstart + node + (int)mask - 1, ENDWORK, comm, &(reqs[nreq])) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d : MPI_Isend Failed! :(\n", SRC_FILE, __LINE__);
+         rc = -1;
+         break;
+      }
+      nreq++;
    }
-   /* just count here */
-   while((fgets(lnbuf, PXARGLENMAX, fin) != NULL)) 
-   {   
-      /* skip comments, etc... */ 
-      if( (lnbuf[0] == '\r') || (lnbuf[0] == '\n') || (lnbuf[0] == '#') ) 
-         continue; 
-      (*n) += 1;
+   if( MPI_Waitall(nreq, reqs, MPI_STATUSES_IGNORE) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Waitall Failed! :(\n", SRC_FILE, __LINE__);
+      rc = -1;
    }
-   rewind(fin);
+   return rc;
+}/* mpi_endwork_tree */
 
-   if( (worku = (WORK_UNIT*)calloc(*n, sizeof(WORK_UNIT))) == NULL)
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int exec_table_init(EXEC_TABLE* etab, const char* proc)
+{
+   memset(etab, 0, sizeof(EXEC_TABLE));
+   if( (etab->paths[0] = strdup((proc != NULL) ? proc : "")) == NULL)
    {
-      fprintf(stderr, "%s @L %d : calloc error for work unit list : %s\n", SRC_FILE, __LINE__, strerror(errno));
-      fclose(fin);
+      fprintf(stderr, "%s @L %d : strdup error for exec table : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
    }
-      
-   /* load here */
-   i = 0;
-   while((fgets(lnbuf, PXARGLENMAX, fin) != NULL) && (i < (*n)) )
-   {   
-      /* skip comments, etc... */ 
-      if( (lnbuf[0] == '\r') || (lnbuf[0] == '\n') || (lnbuf[0] == '#') ) 
-         continue; 
+   etab->n = 1;
+   return 0;
+}/* exec_table_init */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int exec_table_intern(EXEC_TABLE* etab, const char* path, size_t plen)
+{
+   unsigned int i;
 
-      if( (tok=STRTOK(lnbuf, sep, &next)) != NULL) 
-         strcpy(worku[i].pargs, tok);
-            
-      /* basic inits, see pxargs.h */
-      worku[i].proc_secs = 0;
-      worku[i].resrank = RANK_UNASSIGNED;
-      worku[i].id_tag = i;
-      worku[i].was_killed = PX_NO;
-      i++;
+   /* the table is small, a linear search is fine */
+   for(i = 0; i < etab->n; i++)
+   {
+      if( (strncmp(etab->paths[i], path, plen) == 0) && (etab->paths[i][plen] == '\0') )
+         return (int)i;
+   }
+   if(etab->n >= PXEXECMAX)
+   {
+      fprintf(stderr, "%s @L %d : too many distinct executables, max is %d\n", SRC_FILE, __LINE__, PXEXECMAX);
+      return -1;
+   }
+   if( (etab->paths[etab->n] = (char*) malloc(plen + 1)) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for exec table : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
    }
-   fclose(fin);
-   return worku;
-}/* load_work_list */
+   memcpy(etab->paths[etab->n], path, plen);
+   etab->paths[etab->n][plen] = '\0';
+   etab->n += 1;
+   return (int)(etab->n - 1);
+}/* exec_table_intern */
 
-/*-----------------------------------------------------------------------------------------------------
+/*--------------------------------------------------------------------
 * See pxargs.h for details
 */
-int dump_work_list_by_index( const char* fname, WORK_UNIT* wlist, unsigned int nlist, 
-                             unsigned char* windex, unsigned int nindex )
+void exec_table_free(EXEC_TABLE* etab)
 {
-   FILE* fout;
    unsigned int i;
+   for(i = 0; i < etab->n; i++)
+      free(etab->paths[i]);
+   memset(etab, 0, sizeof(EXEC_TABLE));
+}/* exec_table_free */
+
+/*--------------------------------------------------------------------
+* Local module routine, makes unit id from one arg list line. With etab the 
+* first column is the unit's executable. Returns 1 for a unit, 0 if the line 
+* is a comment or blank and < 0 on failure.
+*/
+static int parse_work_line(char* lnbuf, WORK_UNIT* worku, unsigned int id, EXEC_TABLE* etab)
+{
+   char *sep = "\r\n";
+   char* next;
+   char* tok;
+   size_t elen;
+   int eidx;
+
+   /* skip comments, etc... */ 
+   if( (lnbuf[0] == '\r') || (lnbuf[0] == '\n') || (lnbuf[0] == '#') || (lnbuf[0] == '\0') ) 
+      return 0; 
+
+   memset(worku, 0, sizeof(WORK_UNIT));
+   if( (tok=STRTOK(lnbuf, sep, &next)) != NULL) 
+   {
+      if(etab != NULL) 
+      {
+         /* split off the exec column, the rest are the args */
+         tok += strspn(tok, " \t");
+         elen = strcspn(tok, " \t");
+         if( (elen == 0) || ((eidx = exec_table_intern(etab, tok, elen)) < 0) )
+         {
+            fprintf(stderr, "%s @L %d : bad exec column for unit %u\n", SRC_FILE, __LINE__, id);
+            return -1;
+         }
+         worku->exec_idx = (unsigned int)eidx;
+         worku->procpath = etab->paths[eidx];
+         tok += elen;
+         tok += strspn(tok, " \t");
+      }
+      if( (worku->pargs = strdup(tok)) == NULL)
+      {
+         fprintf(stderr, "%s @L %d : strdup error for work unit args : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
+      }
+   }
+         
+   /* basic inits, see pxargs.h */
+   worku->proc_secs = 0;
+   worku->resrank = RANK_UNASSIGNED;
+   worku->id_tag = id;
+   worku->was_killed = PX_NO;
+   worku->exit_code = 0;
+   worku->term_sig = 0;
+   worku->maxumsecs = 0;
+   memset(&(worku->ru), 0, sizeof(WORK_RUSAGE));
+   memset(&(worku->tm), 0, sizeof(WORK_TIMES));
+   return 1;
+}/* parse_work_line */
 
-   if( (fout = fopen(fname, "w")) == NULL)
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int work_stream_open(WORK_STREAM* wstream, const char* fname, unsigned int window, EXEC_TABLE* etab)
+{
+   memset(wstream, 0, sizeof(WORK_STREAM));
+   wstream->fd = -1;
+   if(fname == NULL)
+      wstream->fd = STDIN_FILENO;
+   else if( (wstream->fd = open(fname, O_RDONLY)) < 0)
    {
       fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
       return -1;
    }
-   for(i = 0; (i < nindex) && (i < nlist); i++)
+   if( (wstream->buf = (char*) malloc(PX_STREAM_READ)) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for stream buffer : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      work_stream_close(wstream);
+      return -1;
+   }
+   wstream->cap = PX_STREAM_READ;
+   wstream->window = (window > 0) ? window : PX_STREAM_WINDOW;
+   wstream->etab = etab;
+   wstream->eof = PX_NO;
+   return 0;
+}/* work_stream_open */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void work_stream_close(WORK_STREAM* wstream)
+{
+   if( (wstream->fd >= 0) && (wstream->fd != STDIN_FILENO) )
+      close(wstream->fd);
+   wstream->fd = -1;
+   free(wstream->buf);
+   wstream->buf = NULL;
+}/* work_stream_close */
+
+/*--------------------------------------------------------------------
+* Local module routine, waits up to msecs for input on the stream, -1 waits 
+* until there is some. Returns 1 if a read will not block, 0 if not.
+*/
+static int work_stream_ready(WORK_STREAM* wstream, int msecs)
+{
+#ifdef HAVE_POLL_H
+   struct pollfd pfd;
+
+   pfd.fd = wstream->fd;
+   pfd.events = POLLIN;
+   pfd.revents = 0;
+   if(poll(&pfd, 1, msecs) == 0)
+      return 0;
+#endif
+   return 1;
+}/* work_stream_ready */
+
+/*--------------------------------------------------------------------
+* Local module routine, makes the next unit (id wstream->nunits) from the stream.
+* With block PX_NO only input that has already arrived is read. Returns 1 for a 
+* unit, 0 if no whole line is available yet, 2 at the end of the input and < 0 
+* on failure.
+*/
+static int work_stream_next(WORK_STREAM* wstream, WORK_UNIT* worku, int block)
+{
+   char* nl;
+   char* nbuf;
+   ssize_t nr;
+   int rc;
+
+   for(;;)
    {
-      if(windex[i] == 0)
+      /* a whole line (or the last one) in the buffer? */
+      nl = (wstream->pos < wstream->len) ? (char*) memchr(&(wstream->buf[wstream->pos]), '\n', wstream->len - wstream->pos) : NULL;
+      if( (nl != NULL) || ((wstream->eof == PX_YES) && (wstream->pos < wstream->len)) )
+      {
+         if(nl == NULL)
+            nl = &(wstream->buf[wstream->len]);
+         *nl = '\0';
+         rc = parse_work_line(&(wstream->buf[wstream->pos]), worku, wstream->nunits, wstream->etab);
+         wstream->pos = (size_t)(nl - wstream->buf) + 1;
+         if(wstream->pos > wstream->len)
+            wstream->pos = wstream->len;
+         if(rc < 0)
+            return -1;
+         if(rc == 1)
+         {
+            wstream->nunits += 1;
+            return 1;
+         }
+         continue;
+      }
+      if(wstream->eof == PX_YES)
+         return 2;
+
+      /* make room for more, a line can be longer than the buffer */
+      if(wstream->pos > 0)
+      {
+         memmove(wstream->buf, &(wstream->buf[wstream->pos]), wstream->len - wstream->pos);
+         wstream->len -= wstream->pos;
+         wstream->pos = 0;
+      }
+      if(wstream->len + 1 >= wstream->cap)
+      {
+         if( (nbuf = (char*) realloc(wstream->buf, wstream->cap * 2)) == NULL)
+         {
+            fprintf(stderr, "%s @L %d : realloc error for stream buffer : %s\n", SRC_FILE, __LINE__, strerror(errno));
+            return -1;
+         }
+         wstream->buf = nbuf;
+         wstream->cap *= 2;
+      }
+      if( (block == PX_NO) && (work_stream_ready(wstream, 0) == 0) )
+         return 0;
+      /* leave a byte for the terminator of a last line with no newline */
+      if( (nr = read(wstream->fd, &(wstream->buf[wstream->len]), wstream->cap - wstream->len - 1)) < 0)
       {
-         if(wlist[i].pargs[0] != '\0')
-            fprintf(fout, "%s\n", wlist[i].pargs);
+         if(errno == EINTR)
+            continue;
+         fprintf(stderr, "%s @L %d : read error for arg list : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
       }
+      if(nr == 0)
+         wstream->eof = PX_YES;
+      wstream->len += (size_t)nr;
    }
-   fclose(fout);
-   return 0;
-}/* dump_work_list_by_index */
+}/* work_stream_next */
 
 /*-----------------------------------------------------------------------------------------------------
 * See pxargs.h for details
@@ -441,8 +961,8 @@ void fprint_worku(FILE* fout, WORK_UNIT* worku)
       fprintf(fout, "WORKU NULL\n");
       return;
    }
-   fprintf(fout, "PROC PATH = \"%s\", ", ((worku->procpath[0] != '\0') ? worku->procpath : "UNASSIGNED"));
-   fprintf(fout, "PARGS  = \"%s\", ", worku->pargs);
+   fprintf(fout, "PROC PATH = \"%s\", ", (((worku->procpath != NULL) && (worku->procpath[0] != '\0')) ? worku->procpath : "UNASSIGNED"));
+   fprintf(fout, "PARGS  = \"%s\", ", ((worku->pargs != NULL) ? worku->pargs : ""));
 
    if(worku->resrank == RANK_UNASSIGNED)
       fprintf(fout, "RESPONSIBLE RANK = RANK_UNASSIGNED, ");
@@ -450,395 +970,3674 @@ void fprint_worku(FILE* fout, WORK_UNIT* worku)
       fprintf(fout, "RESPONSIBLE RANK = %d, ", worku->resrank);
 
    fprintf(fout, "ID TAG = %d, ", worku->id_tag);
-   if( worku->proc_secs < (60 * MAX_PRINT_MINUTES) )
+   if( (worku->tm.tstart > 0) && (worku->tm.texit >= worku->tm.tstart) )
+      fprintf(fout, "PROCESS TIME = %.6f seconds, ", (worku->tm.texit - worku->tm.tstart) / 1e9);
+   else if(worku->ru.wall_ms > 0)
+      fprintf(fout, "PROCESS TIME = %.3f seconds, ", worku->ru.wall_ms / 1000.0);
+   else if( worku->proc_secs < (60 * MAX_PRINT_MINUTES) )
       fprintf(fout, "PROCESS TIME = %.3f minutes, ", ((double)(worku->proc_secs)) / 60.0);
    else
       fprintf(fout, "PROCESS TIME = Undef minutes, ");
-   fprintf(fout, "TIME EXCEEDED = %s\n", ((worku->was_killed == PX_YES) ? "Yes" : "No"));
+   fprintf(fout, "TIME EXCEEDED = %s, ", ((worku->was_killed == PX_YES) ? "Yes" : "No"));
+   if(worku->term_sig != 0)
+      fprintf(fout, "EXIT STATUS = signal %d, ", worku->term_sig);
+   else
+      fprintf(fout, "EXIT STATUS = %d, ", worku->exit_code);
+   fprintf(fout, "CPU = %.3f user %.3f sys, MAX RSS = %u kB, BLOCKS = %u in %u out, CSW = %u vol %u invol", 
+           worku->ru.utime_ms / 1000.0, worku->ru.stime_ms / 1000.0, worku->ru.maxrss_kb, 
+           worku->ru.inblock, worku->ru.oublock, worku->ru.nvcsw, worku->ru.nivcsw);
+   /* the worker's times are subtracted from each other, the coordinator's likewise */
+   if( (worku->tm.trecv > 0) && (worku->tm.tstart > 0) && (worku->tm.texit > 0) && (worku->tm.treport > 0) && 
+       (worku->tm.tdisp > 0) && (worku->tm.tdone > 0) )
+      fprintf(fout, ", LIFECYCLE = %.6f queued %.6f run %.6f held %.6f transit (s)", 
+              (worku->tm.tstart - worku->tm.trecv) / 1e9, (worku->tm.texit - worku->tm.tstart) / 1e9, 
+              (worku->tm.treport - worku->tm.texit) / 1e9, 
+              ((worku->tm.tdone - worku->tm.tdisp) - (worku->tm.treport - worku->tm.trecv)) / 1e9);
+   fprintf(fout, "\n");
 }/* fprint_worku */
 
 /*-----------------------------------------------------------------------------------------------------
-* See pxargs.h for details
+* Local module type, the coordinator's view of one worker
 */
-void fprint_worklist(FILE* fout, WORK_UNIT* wlist, unsigned int n)
+typedef struct
 {
-   unsigned int i;
-   if(wlist == NULL)
-      return;
-   for(i = 0; i < n; i++)
-      fprint_worku(fout, &(wlist[i]));
-}/* fprint_worklist */
+   /* the worker's rank */
+   int rank;
+   /* units dispatched to the worker and not reported completed yet */
+   unsigned int inflight;
+   /* units the worker runs at once, 1 for a plain worker, the local worker count for a node leader,
+      and the most it may be given at runtime (--control) */
+   unsigned int slots;
+   unsigned int maxslots;
+   /* bit mask of the exec table entries the worker has been sent (entry 0 is broadcast) */
+   unsigned long long known;
+   /* the worker's rank in MPI_COMM_WORLD, for the trace */
+   int trank;
+} WORKER_STATE;
 
 /*-----------------------------------------------------------------------------------------------------
-* See pxargs.h for details
+* Local module type, coordinator state shared by the coord_* routines
 */
-int coordinate_proc( WORK_UNIT* wunits, unsigned int n, const char* proc, 
-                     int nworkers, int rankstart, int randstart, 
-                     int randend, MPI_Comm moncomm, int mnrank, 
-                     unsigned int verbose, FILE* verbout
-                   )
+typedef struct
 {
-   MPI_Status status, mstatus;
-   MPI_Request req; 
-   WORK_UNIT oneu; 
-   unsigned int i, j, recvd;
-   int waitfor = 0, bfsize;
-   const int mrank = 0; /* This is fixed to 0 for now */
-   unsigned char* mastmsg;
-#ifdef HAVE_NANOSLEEP 
-   struct timespec nanoreq;
+   /* a loaded arg list, else unit id is at wunits[id % wcap] and units base to n-1 are held */
+   WORK_STORE* wstore;
+   WORK_UNIT* wunits;
+   unsigned int wcap;
+   unsigned int base;
+   unsigned int n;
+   /* the next unit to dispatch and the number of units completed */
+   unsigned int next;
+   unsigned int done;
+   /* for a streamed arg list, and which held units are done */
+   WORK_STREAM* wstream;
+   unsigned char* finished;
+   EXEC_TABLE* etab;
+   /* the workers are ranks rankstart to rankstart+nworkers of comm, the dispatches go
+      out on dcomm (comm or its duplicate, see SCHED_PARAMS), poll to not wait in MPI */
+   MPI_Comm comm;
+   MPI_Comm dcomm;
+   int poll;
+   WORKER_STATE* workers;
+   int nworkers;
+   int rankstart;
+   /* the sum of the workers' slots */
+   unsigned int nslots;
+   SCHED_PARAMS* sparams;
+   SCHED_STATS* sstats;
+   /* scratch for building a dispatch batch, sparams->chunkmax long, and the 
+      args copied out of wstore for it */
+   WORK_UNIT* sendu;
+   WORK_UNIT** sendp;
+   char** senda;
+   size_t* sendacap;
+   unsigned int nsend;
+   /* message buffer, grown as needed */
+   unsigned char* msg;
+   int msgsize;
+   /* dispatch messages are sent nonblocking, sbufs[s] is in use until sreqs[s] is done,
+      the sfree stack has the ones that are known to be free */
+   MPI_Request* sreqs;
+   unsigned char** sbufs;
+   int* sbufsize;
+   int* sfree;
+   unsigned int nsbufs;
+   unsigned int nsfree;
+   /* a receive is kept posted for each worker's completions, worker j's lands in 
+      rbufs[j * rbufsize] (see PX_REPORT_MAX) */
+   MPI_Request* rreqs;
+   unsigned char* rbufs;
+   int rbufsize;
+   int* ridx;
+   MPI_Status* rstats;
+   /* monitor notification, ids are batched in monids[monfill] while the other
+      buffer may be in flight, monage is when the oldest pending id came in */
+   MPI_Comm moncomm;
+   int mnrank;
+   MPI_Request monreq;
+   unsigned int* monids[2];
+   unsigned int moncap[2];
+   unsigned int monfill;
+   unsigned int nmon;
+   double monage;
+   /* the journal of completed units and the run time history, NULL for none */
+   JOURNAL* jrnl;
+   HISTORY* hist;
+   /* speculative backups, fin is NULL unless store units may run twice (see SCHED_PARAMS 
+      speculate): when each unit was sent, the rank of its backup (RANK_UNASSIGNED for none),
+      which units are done (2 while waiting for a retry), the losing copies not reported yet, 
+      the first unit not done, the run time of the units done and when they were last looked 
+      at (MPI_Wtime) */
+   double* tsent;
+   int* backrank;
+   unsigned char* fin;
+   unsigned int nback;
+   unsigned int lo;
+   double secsum;
+   double speclast;
+   /* retries (see SCHED_PARAMS retries), NULL unless asked for: the FIFO of failed units 
+      waiting to be sent again (rlen of them from rhead, rcap long) and the retries of each 
+      unit so far, by id for a loaded list, else by window place */
+   unsigned int* retry;
+   unsigned int rhead;
+   unsigned int rlen;
+   unsigned int rcap;
+   unsigned char* tries;
+   /* NULL, or the phase times of SCHED_STATS prof (see SCHED_PARAMS profile) */
+   unsigned long long* prof;
+   /* runtime control (--control): no units are sent while paused, with drainto set the run
+      ends once the units out are in and the units not complete are written to that file */
+   int paused;
+   char* drainto;
+   /* NULL, or the rank's timeline trace (see SCHED_PARAMS trace) */
+   TRACE* trace;
+   unsigned int verbose;
+   FILE* verbout;
+} COORD_STATE;
 
-   memset(&nanoreq, 0, sizeof(struct timespec));
-#endif
+/* the unit did not run to a 0 exit */
+#define WU_FAILED(wu) (((wu)->was_killed == PX_YES) || ((wu)->term_sig != 0) || ((wu)->exit_code != 0))
 
-   if(moncomm != MPI_COMM_NULL) 
+/* a unit's place in the retry counts */
+#define COORD_TRY(cs, id) ((cs)->tries[((cs)->wstream != NULL) ? ((id) % (cs)->wcap) : (id)])
+
+/* a coordinator's unit by id */
+#define COORD_UNIT(cs, id) (&((cs)->wunits[(id) % (cs)->wcap]))
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, the start of a profiled phase, 0 if the coordinator is not profiled.
+*/
+static long long coord_tick(COORD_STATE* cs)
+{
+   return ((cs->prof != NULL) ? now_tm_nsecs() : 0);
+}/* coord_tick */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, charges the time since t0 (see coord_tick) to phase, a PX_PROF_* index. 
+* Returns the time now, the start of the next phase.
+*/
+static long long coord_tock(COORD_STATE* cs, int phase, long long t0)
+{
+   long long t;
+
+   if(cs->prof == NULL)
+      return 0;
+   t = now_tm_nsecs();
+   cs->prof[phase] += (unsigned long long)(t - t0);
+   return t;
+}/* coord_tock */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, looks up the workers' ranks in MPI_COMM_WORLD for the trace, they are 
+* only known by their rank in cs->comm otherwise.
+*/
+static int coord_trace_ranks(COORD_STATE* cs)
+{
+   MPI_Group grp, wgrp;
+   int j, rc = 0;
+
+   for(j = 0; j < cs->nworkers; j++)
+      cs->workers[j].trank = -1;
+   if(cs->trace == NULL)
+      return 0;
+   if( (MPI_Comm_group(cs->comm, &grp) != MPI_SUCCESS) || (MPI_Comm_group(MPI_COMM_WORLD, &wgrp) != MPI_SUCCESS) )
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Comm_group Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   for(j = 0; (rc == 0) && (j < cs->nworkers); j++)
+   {
+      if( MPI_Group_translate_ranks(grp, 1, &(cs->workers[j].rank), wgrp, &(cs->workers[j].trank)) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d : MPI_Group_translate_ranks Failed! :(\n", SRC_FILE, __LINE__);
+         rc = -1;
+      }
+   }
+   MPI_Group_free(&grp);
+   MPI_Group_free(&wgrp);
+   return rc;
+}/* coord_trace_ranks */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, frees the coordinator state buffers
+*/
+static void coord_state_free(COORD_STATE* cs)
+{
+   unsigned int id;
+
+   for(id = 0; (cs->senda != NULL) && (id < cs->nsend); id++)
+      free(cs->senda[id]);
+   free(cs->senda);
+   free(cs->sendacap);
+   /* a streamed list's window is the coordinator's */
+   if(cs->wstream != NULL)
+   {
+      for(id = cs->base; id < cs->n; id++)
+         free(COORD_UNIT(cs, id)->pargs);
+      free(cs->wunits);
+   }
+   for(id = 0; (cs->sbufs != NULL) && (id < cs->nsbufs); id++)
+      free(cs->sbufs[id]);
+   free(cs->sbufs);
+   free(cs->sbufsize);
+   free(cs->sreqs);
+   free(cs->sfree);
+   free(cs->rreqs);
+   free(cs->rbufs);
+   free(cs->ridx);
+   free(cs->rstats);
+   free(cs->monids[0]);
+   free(cs->monids[1]);
+   free(cs->finished);
+   free(cs->msg);
+   free(cs->workers);
+   free(cs->sendu);
+   free(cs->sendp);
+   free(cs->tsent);
+   free(cs->backrank);
+   free(cs->fin);
+   free(cs->retry);
+   free(cs->tries);
+   free(cs->drainto);
+}/* coord_state_free */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, the guided self-scheduling chunk size. Chunks are large while the 
+* queue is long and shrink to 1 unit as it drains so the tail stays balanced. The chunk is
+* per slot so a node leader gets one for each of its local workers.
+*/
+static unsigned int coord_chunk(COORD_STATE* cs, WORKER_STATE* w)
+{
+   unsigned int k, remain;
+
+   remain = cs->n - cs->next;
+   k = 1;
+   if(cs->sparams->chunkmax > 1)
+   {
+      /* with prefetch each slot holds up to depth chunks */
+      k = (unsigned int) ceil( (double)remain / (double)(PX_GSS_FACTOR * cs->nslots * cs->sparams->depth) );
+      if(k < 1)
+         k = 1;
+      if(k > cs->sparams->chunkmax)
+         k = cs->sparams->chunkmax;
+   }
+   k *= w->slots;
+   if(k > remain)
+      k = remain;
+   return k;
+}/* coord_chunk */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, a free dispatch send buffer of at least need bytes. The sends that are 
+* done are reclaimed once the free ones run out, the pool is doubled if fewer than half are.
+*/
+static int coord_sendbuf(COORD_STATE* cs, int need, unsigned int* slot)
+{
+   void* nptr;
+   unsigned int s, ncap;
+   int nc = 0, grow = PX_NO;
+
+   /* the indices of the sends that are done go straight on the free stack */
+   if( (cs->nsfree == 0) && (cs->nsbufs > 0) )
+   {
+      if( MPI_Testsome((int)cs->nsbufs, cs->sreqs, &nc, cs->sfree, MPI_STATUSES_IGNORE) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d : MPI_Testsome Failed! :(\n", SRC_FILE, __LINE__);
+         return -1;
+      }
+      cs->nsfree = (nc != MPI_UNDEFINED) ? (unsigned int)nc : 0;
+      /* keep the reclaim passes rare */
+      grow = ((2 * cs->nsfree) < cs->nsbufs) ? PX_YES : PX_NO;
+   }
+   if( (cs->nsfree == 0) || (grow == PX_YES) )
+   {
+      ncap = (cs->nsbufs > 0) ? (cs->nsbufs * 2) : 8;
+      if( (nptr = realloc(cs->sreqs, ncap * sizeof(MPI_Request))) != NULL)
+         cs->sreqs = (MPI_Request*) nptr;
+      if( (nptr != NULL) && ((nptr = realloc(cs->sbufs, ncap * sizeof(unsigned char*))) != NULL) )
+         cs->sbufs = (unsigned char**) nptr;
+      if( (nptr != NULL) && ((nptr = realloc(cs->sbufsize, ncap * sizeof(int))) != NULL) )
+         cs->sbufsize = (int*) nptr;
+      if( (nptr != NULL) && ((nptr = realloc(cs->sfree, ncap * sizeof(int))) != NULL) )
+         cs->sfree = (int*) nptr;
+      if(nptr == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d : realloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
+      }
+      for(s = cs->nsbufs; s < ncap; s++)
+      {
+         cs->sreqs[s] = MPI_REQUEST_NULL;
+         cs->sbufs[s] = NULL;
+         cs->sbufsize[s] = 0;
+         cs->sfree[cs->nsfree++] = (int)s;
+      }
+      cs->nsbufs = ncap;
+   }
+   *slot = (unsigned int)cs->sfree[--(cs->nsfree)];
+   return grow_msgbuf(&(cs->sbufs[*slot]), &(cs->sbufsize[*slot]), need);
+}/* coord_sendbuf */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, waits for the dispatch sends still in flight.
+*/
+static int coord_senddrain(COORD_STATE* cs)
+{
+   if( (cs->nsbufs > 0) && (MPI_Waitall((int)cs->nsbufs, cs->sreqs, MPI_STATUSES_IGNORE) != MPI_SUCCESS) )
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Waitall Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   return 0;
+}/* coord_senddrain */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, puts unit id in the u'th place of the batch being built for worker w. An 
+* executable path is only packed if the worker has not been sent that exec table entry yet, known
+* has the entries sent so far.
+*/
+static int coord_pack(COORD_STATE* cs, WORKER_STATE* w, unsigned int u, unsigned int id, unsigned long long* known)
+{
+   WORK_UNIT* wu;
+
+   if(cs->wstore != NULL)
+   {
+      /* the args are copied out of the mapped list only to be packed */
+      wu = &(cs->sendu[u]);
+      if( work_store_unit(cs->wstore, id, wu, &(cs->senda[u]), &(cs->sendacap[u])) < 0)
+         return -1;
+   }
+   else
+      wu = COORD_UNIT(cs, id);
+   wu->resrank = w->rank;
+   wu->procpath = cs->etab->paths[wu->exec_idx];
+   cs->sendu[u] = *wu;
+   if( (*known & (1ULL << wu->exec_idx)) != 0 )
+      cs->sendu[u].procpath = NULL;
+   *known |= (1ULL << wu->exec_idx);
+   cs->sendp[u] = &(cs->sendu[u]);
+
+   if(cs->verbose >= 2)
+      fprintf(cs->verbout, "Sending \"%s\" to rank[%d]\n", wu->procpath, w->rank);
+   return 0;
+}/* coord_pack */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, sends the k units coord_pack put in the batch to worker w.
+*/
+static int coord_sendbatch(COORD_STATE* cs, WORKER_STATE* w, unsigned int k)
+{
+   unsigned int s, u;
+   int boffset = 0;
+   long long t, now, tsend = 0;
+
+   /* nonblocking, a slow link only holds up its own worker */
+   if(cs->trace != NULL)
+      tsend = now_tm_nsecs();
+   t = coord_tick(cs);
+   if( coord_sendbuf(cs, mpi_sizeof_workmsg(cs->sendp, k), &s) < 0)
+      return -1;
+   t = coord_tock(cs, PX_PROF_SEND, t);
+   if( mpi_workmsg_serialize(cs->sendp, k, cs->sbufs[s], cs->sbufsize[s], &boffset) < 0)
+      return -1;
+   t = coord_tock(cs, PX_PROF_PACK, t);
+   if( MPI_Isend(cs->sbufs[s], boffset, MPI_PACKED, w->rank, DOWORK, cs->dcomm, &(cs->sreqs[s])) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Isend Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   coord_tock(cs, PX_PROF_SEND, t);
+   /* a node leader's units are not kept by id */
+   now = now_tm_nsecs();
+   for(u = 0; (u < k) && ((cs->wstore != NULL) || (cs->wstream != NULL)); u++)
+   {
+      if(cs->wstore != NULL)
+         cs->wstore->tm[cs->sendu[u].id_tag].tdisp = now;
+      else
+         COORD_UNIT(cs, cs->sendu[u].id_tag)->tm.tdisp = now;
+   }
+   if(cs->trace != NULL)
+   {
+      /* each unit's flow starts here, or passes through a node leader */
+      trace_event(cs->trace, PX_TRACE_SEND, tsend, now - tsend, k, w->trank, DOWORK, 0);
+      for(u = 0; u < k; u++)
+         trace_event(cs->trace, PX_TRACE_UNIT, tsend, 0, cs->sendu[u].id_tag, w->trank, 
+                     (((cs->wstore == NULL) && (cs->wstream == NULL)) ? PX_YES : PX_NO), 0);
+   }
+   w->inflight += k;
+   cs->sstats->dispatch_msgs += 1;
+   return 0;
+}/* coord_sendbatch */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, sends the oldest unit waiting for a retry to worker w if w has an idle slot,
+* with retryelse PX_YES only one that last ran on another worker. The retry's max run time goes up 
+* by retrytime for each retry so far. Returns 1 if a unit was sent, 0 if none, < 0 on failure.
+*/
+static int coord_redispatch(COORD_STATE* cs, WORKER_STATE* w)
+{
+   unsigned long long known;
+   unsigned int r, id;
+   int lastrank;
+   double msecs;
+
+   if( (cs->rlen == 0) || (w->inflight >= w->slots) )
+      return 0;
+   for(r = 0; r < cs->rlen; r++)
+   {
+      id = cs->retry[(cs->rhead + r) % cs->rcap];
+      lastrank = (cs->wstore != NULL) ? cs->wstore->resrank[id] : COORD_UNIT(cs, id)->resrank;
+      if( (cs->sparams->retryelse == PX_NO) || (cs->nworkers == 1) || (lastrank != w->rank) )
+         break;
+   }
+   if(r == cs->rlen)
+      return 0;
+   /* the head takes the place of the one sent, the order only matters for fairness */
+   cs->retry[(cs->rhead + r) % cs->rcap] = cs->retry[cs->rhead];
+   cs->rhead = (cs->rhead + 1) % cs->rcap;
+   cs->rlen -= 1;
+
+   known = w->known;
+   if( coord_pack(cs, w, 0, id, &known) < 0)
+      return -1;
+   msecs = (double)cs->sparams->maxumsecs * pow(cs->sparams->retrytime, (double)COORD_TRY(cs, id));
+   cs->sendu[0].maxumsecs = (msecs >= (double)UINT_MAX) ? UINT_MAX : (unsigned int)msecs;
+   if( coord_sendbatch(cs, w, 1) < 0)
+      return -1;
+   w->known = known;
+   if(cs->wstore != NULL)
+      cs->wstore->resrank[id] = w->rank;
+   if(cs->fin != NULL)
+   {
+      cs->tsent[id] = MPI_Wtime();
+      cs->fin[id] = 0;
+      if(id < cs->lo)
+         cs->lo = id;
+   }
+   if( (cs->verbose >= 2) && (cs->sendu[0].maxumsecs > 0) )
+      fprintf(cs->verbout, "Retry %u of unit %u to rank[%d] (max runtime %.3f)\n", (unsigned int)COORD_TRY(cs, id), id, w->rank, cs->sendu[0].maxumsecs / 1000.0);
+   else if(cs->verbose >= 2)
+      fprintf(cs->verbout, "Retry %u of unit %u to rank[%d]\n", (unsigned int)COORD_TRY(cs, id), id, w->rank);
+   return 1;
+}/* coord_redispatch */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, sends the next batch of units to a worker if its prefetch queue has
+* room (fewer than depth chunks outstanding). Once there are no more queued units than 
+* worker slots only idle slots are sent units, so the last units go to whoever is idle first 
+* rather than waiting in a busy worker's queue. The retries go out after the rest, see 
+* coord_redispatch. Returns the number of units sent, 0 if none, < 0 on failure.
+*/
+static int coord_dispatch(COORD_STATE* cs, WORKER_STATE* w)
+{
+   unsigned int k, u, target;
+   unsigned long long known;
+   double now = 0.0;
+   long long t;
+
+   if(cs->paused == PX_YES)
+      return 0;
+   if(cs->next >= cs->n)
+      return coord_redispatch(cs, w);
+   k = coord_chunk(cs, w);
+   if((cs->n - cs->next) <= cs->nslots)
+      target = w->slots;
+   else
+      target = k * cs->sparams->depth;
+   if(w->inflight >= target)
+      return 0;
+   if(k > (target - w->inflight))
+      k = target - w->inflight;
+   known = w->known;
+   if(cs->tsent != NULL)
+      now = MPI_Wtime();
+   t = coord_tick(cs);
+   for(u = 0; u < k; u++)
+   {
+      if( coord_pack(cs, w, u, cs->next + u, &known) < 0)
+         return -1;
+      if(cs->wstore != NULL)
+         cs->wstore->resrank[cs->next + u] = w->rank;
+      if(cs->tsent != NULL)
+         cs->tsent[cs->next + u] = now;
+   }
+   coord_tock(cs, PX_PROF_PACK, t);
+   if( coord_sendbatch(cs, w, k) < 0)
+      return -1;
+
+   w->known = known;
+   cs->next += k;
+   return (int)k;
+}/* coord_dispatch */
+
+/* more to read from a streamed arg list */
+#define STREAM_MORE(ws) (((ws)->eof == PX_NO) || ((ws)->pos < (ws)->len))
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, reads streamed units into the window while it has room. Only the first 
+* read may block and only if block is PX_YES. Returns the number of units added, < 0 on failure.
+*/
+static int coord_fill(COORD_STATE* cs, int block)
+{
+   int rc, nadd = 0;
+
+   while( STREAM_MORE(cs->wstream) && ((cs->n - cs->base) < cs->wcap) )
+   {
+      if( (rc = work_stream_next(cs->wstream, COORD_UNIT(cs, cs->n), ((nadd == 0) ? block : PX_NO))) < 0)
+         return -1;
+      if(rc != 1)
+         break;
+      cs->n += 1;
+      nadd++;
+   }
+   return nadd;
+}/* coord_fill */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, a streamed unit is done: it is printed if asked for and its args freed. The 
+* window moves past the oldest units once they are all done.
+*/
+static void coord_retire(COORD_STATE* cs, WORK_UNIT* wu)
+{
+   if(cs->wstream->retout != NULL)
+      fprint_worku(cs->wstream->retout, wu);
+   free(wu->pargs);
+   wu->pargs = NULL;
+   cs->finished[wu->id_tag % cs->wcap] = 1;
+   if(cs->tries != NULL)
+      cs->tries[wu->id_tag % cs->wcap] = 0;
+   while( (cs->base < cs->n) && (cs->finished[cs->base % cs->wcap] == 1) )
+   {
+      cs->finished[cs->base % cs->wcap] = 0;
+      cs->base += 1;
+   }
+}/* coord_retire */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, sends the pending completed unit ids to the monitor in one message 
+* if there are PX_MON_BATCH of them or the oldest is PX_MON_FLUSH_MSECS old, and only if the 
+* previous batch is out. With force PX_YES they are sent now, waiting on the previous batch.
+*/
+static int coord_monflush(COORD_STATE* cs, int force)
+{
+   MPI_Status mstatus;
+   int flag = 0;
+
+   if( (cs->moncomm == MPI_COMM_NULL) || (cs->nmon == 0) )
+      return 0;
+   if(force == PX_NO)
+   {
+      if( (cs->nmon < PX_MON_BATCH) && ((MPI_Wtime() - cs->monage) < (PX_MON_FLUSH_MSECS / 1000.0)) )
+         return 0;
+      if( MPI_Test(&(cs->monreq), &flag, &mstatus) != MPI_SUCCESS)
+         fprintf(stderr, "\"%s\" @L %d : WARN MPI_Test Failed! :(\n", SRC_FILE, __LINE__);
+      if(flag == 0)
+         return 0;
+   }
+   else if( MPI_Wait(&(cs->monreq), &mstatus) != MPI_SUCCESS)
+      fprintf(stderr, "\"%s\" @L %d : WARN MPI_Wait Failed! :(\n", SRC_FILE, __LINE__);
+
+   if( MPI_Isend(cs->monids[cs->monfill], (int)cs->nmon, MPI_UNSIGNED, cs->mnrank, COMPLETED_WORK, cs->moncomm, &(cs->monreq)) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_ISend Failed to monitor via sub comm.\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   /* fill the other buffer while this one is in flight */
+   cs->monfill ^= 1;
+   cs->nmon = 0;
+   return 0;
+}/* coord_monflush */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, queues a completed unit id for the monitor (if any), see coord_monflush.
+*/
+static int coord_notify(COORD_STATE* cs, unsigned int id)
+{
+   unsigned int* nptr;
+   unsigned int ncap, b;
+
+   if(cs->moncomm == MPI_COMM_NULL) 
+      return 0;
+   b = cs->monfill;
+   if(cs->nmon == cs->moncap[b])
+   {
+      ncap = (cs->moncap[b] > 0) ? (cs->moncap[b] * 2) : PX_MON_BATCH;
+      if( (nptr = (unsigned int*) realloc(cs->monids[b], ncap * sizeof(unsigned int))) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d : realloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
+      }
+      cs->monids[b] = nptr;
+      cs->moncap[b] = ncap;
+   }
+   if(cs->nmon == 0)
+      cs->monage = MPI_Wtime();
+   cs->monids[b][cs->nmon] = id;
+   cs->nmon += 1;
+   return coord_monflush(cs, PX_NO);
+}/* coord_notify */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, the monitor knows units by their arg list position, the units a
+* resumed store skipped (see work_store_skip) are done as far as it is concerned. The 
+* store may also be reordered (see work_store_order), so orig is in no particular order.
+*/
+static int coord_notify_skipped(COORD_STATE* cs, WORK_STORE* wstore)
+{
+   unsigned char* held;
+   unsigned int id, k;
+
+   if( (cs->moncomm == MPI_COMM_NULL) || (wstore->orig == NULL) || (wstore->n == wstore->norig) )
+      return 0;
+   if( (held = (unsigned char*) calloc(wstore->norig, sizeof(unsigned char))) == NULL)
+   {
+      fprintf(stderr, "\"%s\" @L %d : calloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   for(k = 0; k < wstore->n; k++)
+      held[wstore->orig[k]] = 1;
+   for(id = 0; id < wstore->norig; id++)
+   {
+      if( (held[id] == 0) && (coord_notify(cs, id) < 0) )
+      {
+         free(held);
+         return -1;
+      }
+   }
+   free(held);
+   return 0;
+}/* coord_notify_skipped */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, adds the run of store unit id to the history (if any).
+*/
+static int coord_history(HISTORY* hist, WORK_STORE* wstore, unsigned int id)
+{
+   if(hist == NULL)
+      return 0;
+   return history_record(hist, ((wstore->etab != NULL) ? wstore->etab->paths[wstore->exec_idx[id]] : NULL), 
+                         &(wstore->map[wstore->offs[id]]), (size_t)wstore->lens[id], 
+                         (double)wstore->proc_msecs[id] / 1000.0, (int)wstore->was_killed[id]);
+}/* coord_history */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, sends the worker of rank a message of one number with tag, nonblocking.
+*/
+static int coord_sendword(COORD_STATE* cs, int rank, int tag, unsigned int val)
+{
+   unsigned int s;
+   int need = 0, boffset = 0;
+
+   MPI_Pack_size(1, MPI_UNSIGNED, cs->dcomm, &need);
+   if( coord_sendbuf(cs, need, &s) < 0)
+      return -1;
+   if( (MPI_Pack(&val, 1, MPI_UNSIGNED, cs->sbufs[s], cs->sbufsize[s], &boffset, cs->dcomm) != MPI_SUCCESS) ||
+       (MPI_Isend(cs->sbufs[s], boffset, MPI_PACKED, rank, tag, cs->dcomm, &(cs->sreqs[s])) != MPI_SUCCESS) )
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Isend Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   if(cs->trace != NULL)
+      trace_event(cs->trace, PX_TRACE_CONTROL, now_tm_nsecs(), 0, val, cs->workers[rank - cs->rankstart].trank, tag, 0);
+   return 0;
+}/* coord_sendword */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, tells the worker of rank that its copy of store unit id lost, it drops the
+* unit if it is still queued or kills its process group if it is running, and reports it either way.
+*/
+static int coord_cancel(COORD_STATE* cs, int rank, unsigned int id)
+{
+   if( coord_sendword(cs, rank, CANCELWORK, id) < 0)
+      return -1;
+   if(cs->verbose >= 2)
+      fprintf(cs->verbout, "Cancelling the copy of unit %u on rank[%d]\n", id, rank);
+   return 0;
+}/* coord_cancel */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, once every unit is sent, sends a backup copy of each marked unit that has 
+* been out much longer than the mean run time so far to an idle slot of another worker. A unit gets 
+* one backup at most and the first copy to finish wins (see coord_complete). Looks every 
+* PX_SPEC_POLL_MSECS, returns the number of backups sent, < 0 on failure.
+*/
+static int coord_speculate(COORD_STATE* cs)
+{
+   WORKER_STATE* w;
+   unsigned long long known;
+   unsigned int id;
+   double now, limit;
+   int j, nidle = 0, nb = 0;
+
+   if( (cs->fin == NULL) || (cs->paused == PX_YES) || (cs->next < cs->n) || (cs->done == 0) || (cs->done >= cs->n) )
+      return 0;
+   now = MPI_Wtime();
+   if( (now - cs->speclast) < (PX_SPEC_POLL_MSECS / 1000.0) )
+      return 0;
+   cs->speclast = now;
+   for(j = 0; j < cs->nworkers; j++)
+   {
+      if(cs->workers[j].inflight < cs->workers[j].slots)
+         nidle++;
+   }
+   limit = cs->sparams->speculate * (cs->secsum / (double)cs->done);
+   if(limit < PX_SPEC_MIN_SECS)
+      limit = PX_SPEC_MIN_SECS;
+   /* the units are sent in id order, the oldest are looked at first */
+   while( (cs->lo < cs->n) && (cs->fin[cs->lo] != 0) )
+      cs->lo += 1;
+   for(id = cs->lo; (id < cs->n) && (nidle > 0); id++)
+   {
+      if( (cs->fin[id] != 0) || (cs->wstore->dupok[id] == 0) || (cs->backrank[id] != RANK_UNASSIGNED) || 
+          ((now - cs->tsent[id]) < limit) )
+         continue;
+      for(j = 0, w = NULL; (j < cs->nworkers) && (w == NULL); j++)
+      {
+         if( (cs->workers[j].inflight < cs->workers[j].slots) && (cs->workers[j].rank != cs->wstore->resrank[id]) )
+            w = &(cs->workers[j]);
+      }
+      if(w == NULL)
+         continue;
+      if(cs->verbose >= 2)
+         fprintf(cs->verbout, "Unit %u out for %.1f secs on rank[%d], backup to rank[%d]\n", id, now - cs->tsent[id], cs->wstore->resrank[id], w->rank);
+      known = w->known;
+      if( (coord_pack(cs, w, 0, id, &known) < 0) || (coord_sendbatch(cs, w, 1) < 0) )
+         return -1;
+      w->known = known;
+      cs->backrank[id] = w->rank;
+      cs->nback += 1;
+      cs->sstats->backups += 1;
+      nb++;
+      if(w->inflight >= w->slots)
+         nidle--;
+   }
+   return nb;
+}/* coord_speculate */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, the first copy of store unit id to finish came from worker w. If the unit had
+* a backup the other copy is cancelled and w is kept as the unit's rank. Returns PX_NO if this is the 
+* report of a losing copy, which is not a completion.
+*/
+static int coord_settle(COORD_STATE* cs, WORKER_STATE* w, unsigned int id)
+{
+   int other;
+
+   if(cs->fin[id] != 0)
+   {
+      cs->nback -= 1;
+      if(cs->verbose >= 2)
+         fprintf(cs->verbout, "received the losing copy of unit %u from rank[%d]\n", id, w->rank);
+      return PX_NO;
+   }
+   cs->fin[id] = 1;
+   if(cs->backrank[id] != RANK_UNASSIGNED)
+   {
+      other = (w->rank == cs->backrank[id]) ? cs->wstore->resrank[id] : cs->backrank[id];
+      if(w->rank == cs->backrank[id])
+         cs->sstats->backup_wins += 1;
+      cs->wstore->resrank[id] = w->rank;
+      if( coord_cancel(cs, other, id) < 0)
+         return -1;
+   }
+   return PX_YES;
+}/* coord_settle */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, adds what the run of unit wu used to the job's totals.
+*/
+static void coord_usage(SCHED_STATS* sstats, WORK_UNIT* wu)
+{
+   sstats->nusage += 1;
+   sstats->wall_ms += wu->ru.wall_ms;
+   sstats->utime_ms += wu->ru.utime_ms;
+   sstats->stime_ms += wu->ru.stime_ms;
+   sstats->rss_kb += wu->ru.maxrss_kb;
+   sstats->inblock += wu->ru.inblock;
+   sstats->oublock += wu->ru.oublock;
+   sstats->nvcsw += wu->ru.nvcsw;
+   sstats->nivcsw += wu->ru.nivcsw;
+   if(wu->ru.maxrss_kb > sstats->maxrss_kb)
+   {
+      sstats->maxrss_kb = wu->ru.maxrss_kb;
+      sstats->maxrss_id = wu->id_tag;
+   }
+}/* coord_usage */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, adds the lifecycle of a unit to the job's totals if all of it is known. 
+* The round trip less the worker's part is the time in messages and in the coordinator.
+*/
+static void coord_life(SCHED_STATS* sstats, WORK_TIMES* tm)
+{
+   long long trip, onworker;
+
+   if( (tm->tdisp <= 0) || (tm->tdone <= 0) || (tm->trecv <= 0) || (tm->tstart <= 0) || (tm->texit <= 0) || (tm->treport <= 0) )
+      return;
+   trip = tm->tdone - tm->tdisp;
+   onworker = tm->treport - tm->trecv;
+   sstats->nlife += 1;
+   sstats->queue_ns += (unsigned long long)(tm->tstart - tm->trecv);
+   sstats->run_ns += (unsigned long long)(tm->texit - tm->tstart);
+   sstats->held_ns += (unsigned long long)(tm->treport - tm->texit);
+   sstats->transit_ns += (unsigned long long)((trip > onworker) ? (trip - onworker) : 0);
+}/* coord_life */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, hands the live status (--status) the coordinator's counts, a copy 
+* under the status lock that its thread only holds as long.
+*/
+static void coord_status(COORD_STATE* cs)
+{
+   STATUS_SNAP snap;
+   int j;
+
+   if(cs->sparams->status == NULL)
+      return;
+   memset(&snap, 0, sizeof(STATUS_SNAP));
+   snap.units = cs->n;
+   snap.listdone = ((cs->wstream == NULL) || !STREAM_MORE(cs->wstream)) ? PX_YES : PX_NO;
+   snap.done = cs->done;
+   snap.retryq = cs->rlen;
+   snap.queued = ((cs->next < cs->n) ? (cs->n - cs->next) : 0) + cs->rlen;
+   snap.killed = cs->sstats->killed;
+   snap.failed = cs->sstats->failed;
+   snap.slots = cs->nslots;
+   for(j = 0; j < cs->nworkers; j++)
+   {
+      snap.inflight += cs->workers[j].inflight;
+      snap.busy += (cs->workers[j].inflight < cs->workers[j].slots) ? cs->workers[j].inflight : cs->workers[j].slots;
+   }
+   status_update(cs->sparams->status, &snap);
+}/* coord_status */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, PX_YES if the outcome of unit wu is a failure the retries are asked for 
+* (see PX_RETRY_BITS).
+*/
+static int coord_retryable(COORD_STATE* cs, WORK_UNIT* wu)
+{
+   unsigned int b;
+
+   if( !WU_FAILED(wu))
+      return PX_NO;
+   if(wu->was_killed == PX_YES)
+      b = PX_RETRY_TIMEOUT;
+   else if(wu->term_sig != 0)
+      b = PX_RETRY_SIGNAL;
+   else
+      b = (unsigned int)wu->exit_code & 0xff;
+   return (PX_RETRY_ISSET(cs->sparams->retryon, b) ? PX_YES : PX_NO);
+}/* coord_retryable */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, puts failed unit wu (reported by worker w) at the end of the queue if it 
+* has retries left. A unit with a backup out is not retried, its other copy was cancelled and 
+* still has to report. Returns PX_YES if the unit was queued again, which is not a completion.
+*/
+static int coord_retry(COORD_STATE* cs, WORKER_STATE* w, WORK_UNIT* wu)
+{
+   unsigned int id = wu->id_tag;
+
+   if( (cs->tries == NULL) || (coord_retryable(cs, wu) == PX_NO) || (COORD_TRY(cs, id) >= cs->sparams->retries) ||
+       ((cs->fin != NULL) && (cs->backrank[id] != RANK_UNASSIGNED)) )
+      return PX_NO;
+   /* no backups while it waits */
+   if(cs->fin != NULL)
+      cs->fin[id] = 2;
+   cs->retry[(cs->rhead + cs->rlen) % cs->rcap] = id;
+   cs->rlen += 1;
+   COORD_TRY(cs, id) += 1;
+   cs->sstats->retried += 1;
+   if(cs->verbose >= 2)
+      fprintf(cs->verbout, "unit %u failed on rank[%d] (exit %d, signal %d%s), queued to retry\n", id, w->rank, 
+              wu->exit_code, wu->term_sig, ((wu->was_killed == PX_YES) ? ", timed out" : ""));
+   return PX_YES;
+}/* coord_retry */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, records the units of a completion message (msg, msglen bytes) from 
+* worker w in the journal (if any) and notifies the monitor (if any) of each completed unit.
+* A failed unit is queued again if it has retries left (see coord_retry), once it has none 
+* the monitor is not told of it so it stays in the checkpoint.
+*/
+static int coord_complete(COORD_STATE* cs, WORKER_STATE* w, unsigned char* msg, int msglen)
+{
+   WORK_UNIT oneu; 
+   WORK_UNIT* wu;
+   unsigned int k, u, id;
+   int rank, rc, boffset = 0;
+   long long t, tdone;
+
+   t = coord_tick(cs);
+   tdone = now_tm_nsecs();
+   if( mpi_workmsg_nunits(msg, msglen, &boffset, &k) < 0)
+      return -1;
+   for(u = 0; u < k; u++)
+   {
+      if( mpi_worku_unserialize(msg, msglen, &boffset, &oneu) < 0)
+         return -1;
+      free(oneu.pargs); free(oneu.procpath);
+      t = coord_tock(cs, PX_PROF_UNPACK, t);
+      if( (oneu.id_tag < cs->base) || (oneu.id_tag >= cs->n) )
+      {
+         fprintf(stderr, "\"%s\" @L %d : bad unit id %u from rank[%d]\n", SRC_FILE, __LINE__, oneu.id_tag, w->rank);
+         return -1;
+      }
+      /* every run counts, a losing copy or a failure to retry used the resources as well */
+      coord_usage(cs->sstats, &oneu);
+      if(cs->wstore != NULL)
+      {
+         /* with backups a unit may be reported twice, only the first counts */
+         if( (cs->fin != NULL) && ((rc = coord_settle(cs, w, oneu.id_tag)) != PX_YES) )
+         {
+            if(rc < 0)
+               return -1;
+            continue;
+         }
+         if(oneu.was_killed == PX_YES)
+            cs->sstats->killed += 1;
+         if( coord_retry(cs, w, &oneu) == PX_YES)
+            continue;
+         /* the measured wall time, proc_secs is whole seconds */
+         cs->wstore->proc_msecs[oneu.id_tag] = oneu.ru.wall_ms; 
+         cs->secsum += (double)oneu.ru.wall_ms / 1000.0;
+         cs->wstore->was_killed[oneu.id_tag] = (unsigned char)oneu.was_killed;
+         cs->wstore->exitstat[oneu.id_tag] = (oneu.term_sig != 0) ? -(oneu.term_sig) : oneu.exit_code;
+         cs->wstore->ru[oneu.id_tag] = oneu.ru;
+         oneu.tm.tdisp = cs->wstore->tm[oneu.id_tag].tdisp;
+         oneu.tm.tdone = tdone;
+         cs->wstore->tm[oneu.id_tag] = oneu.tm;
+         coord_life(cs->sstats, &(oneu.tm));
+         id = WORK_STORE_ORIG(cs->wstore, oneu.id_tag);
+         rank = cs->wstore->resrank[oneu.id_tag];
+         if( coord_history(cs->hist, cs->wstore, oneu.id_tag) < 0)
+            return -1;
+      }
+      else
+      {
+         if(oneu.was_killed == PX_YES)
+            cs->sstats->killed += 1;
+         if( coord_retry(cs, w, &oneu) == PX_YES)
+            continue;
+         wu = COORD_UNIT(cs, oneu.id_tag);
+         wu->proc_secs = oneu.proc_secs; 
+         wu->was_killed = oneu.was_killed;
+         wu->exit_code = oneu.exit_code;
+         wu->term_sig = oneu.term_sig;
+         wu->ru = oneu.ru;
+         oneu.tm.tdisp = wu->tm.tdisp;
+         oneu.tm.tdone = tdone;
+         wu->tm = oneu.tm;
+         coord_life(cs->sstats, &(oneu.tm));
+         id = oneu.id_tag;
+         rank = wu->resrank;
+         /* a streamed unit's args are held until it is retired */
+         if( (cs->hist != NULL) && (history_record(cs->hist, cs->etab->paths[wu->exec_idx], wu->pargs, 
+                                                   ((wu->pargs != NULL) ? strlen(wu->pargs) : 0), (double)wu->ru.wall_ms / 1000.0, wu->was_killed) < 0) )
+            return -1;
+         if(cs->wstream != NULL)
+            coord_retire(cs, wu);
+      }
+      cs->done += 1;
+
+      /* future TODO: reset anything else that matters here */
+
+      if( journal_record(cs->jrnl, id, oneu.proc_secs, rank, oneu.was_killed, 
+                         ((oneu.term_sig != 0) ? -(oneu.term_sig) : oneu.exit_code)) < 0)
+      {
+         fprintf(stderr, "\"%s\" @L %d : failed to journal unit %u\n", SRC_FILE, __LINE__, id);
+         return -1;
+      }
+      t = coord_tock(cs, PX_PROF_RECORD, t);
+      /* notify monitor of unit completion, with retries a failure is left in its checkpoint */
+      if( (cs->tries != NULL) && WU_FAILED(&oneu) )
+         cs->sstats->failed += 1;
+      else if( coord_notify(cs, id) < 0)
+         return -1;
+      t = coord_tock(cs, PX_PROF_NOTIFY, t);
+      if(cs->verbose >= 2)
+         fprintf(cs->verbout, "received completed work from rank[%d] (id=%u)\n", w->rank, oneu.id_tag);
+   }
+   w->inflight = (k < w->inflight) ? (w->inflight - k) : 0;
+   cs->sstats->complete_msgs += 1;
+   if(cs->trace != NULL)
+      trace_event(cs->trace, PX_TRACE_COMPLETE, tdone, now_tm_nsecs() - tdone, k, w->trank, COMPLETED_WORK, 0);
+   return 0;
+}/* coord_complete */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, sets up the completion receives, one per worker sized for the most 
+* units it can report in one message: PX_REPORT_MAX or all it can hold if that is fewer.
+*/
+static int coord_recv_init(COORD_STATE* cs, unsigned int maxslots)
+{
+   WORK_UNIT oneu;
+   unsigned int hold;
+   int j, hdrsize = 0;
+
+   memset(&oneu, 0, sizeof(WORK_UNIT));
+   hold = cs->sparams->chunkmax * maxslots * cs->sparams->depth;
+   if(hold > PX_REPORT_MAX)
+      hold = PX_REPORT_MAX;
+   /* the workers send back no args or paths */
+   MPI_Pack_size(1, MPI_UNSIGNED, MPI_COMM_WORLD, &hdrsize);
+   cs->rbufsize = hdrsize + ((int)hold * mpi_sizeof_worku(&oneu));
+   cs->rreqs = (MPI_Request*) malloc(cs->nworkers * sizeof(MPI_Request));
+   cs->rbufs = (unsigned char*) malloc((size_t)cs->nworkers * (size_t)cs->rbufsize);
+   cs->ridx = (int*) malloc(cs->nworkers * sizeof(int));
+   cs->rstats = (MPI_Status*) malloc(cs->nworkers * sizeof(MPI_Status));
+   if( (cs->rreqs == NULL) || (cs->rbufs == NULL) || (cs->ridx == NULL) || (cs->rstats == NULL) )
+   {
+      fprintf(stderr, "\"%s\" @L %d : malloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   for(j = 0; j < cs->nworkers; j++)
+      cs->rreqs[j] = MPI_REQUEST_NULL;
+   return 0;
+}/* coord_recv_init */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, posts the receive for worker j's next completion message.
+*/
+static int coord_recv_post(COORD_STATE* cs, int j)
+{
+   if( MPI_Irecv(&(cs->rbufs[(size_t)j * (size_t)cs->rbufsize]), cs->rbufsize, MPI_PACKED, cs->workers[j].rank, 
+                 COMPLETED_WORK, cs->comm, &(cs->rreqs[j])) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Irecv Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   return 0;
+}/* coord_recv_post */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, the completion receives that are done, waiting for one if block is PX_YES.
+* Their worker indices are cs->ridx[0] to cs->ridx[n-1], n is returned (< 0 on failure).
+*/
+static int coord_recv_some(COORD_STATE* cs, int block)
+{
+   int nc = 0, mrc, poll = PX_NO;
+   double tend = 0.0;
+   long long t = coord_tick(cs);
+   long long twait = ((cs->trace != NULL) && (block == PX_YES)) ? now_tm_nsecs() : 0;
+#ifdef HAVE_NANOSLEEP 
+   struct timespec nanoreq;
+
+   memset(&nanoreq, 0, sizeof(struct timespec));
+   nanoreq.tv_nsec = 100000; /* poll, 0.1 ms */
+   poll = cs->poll;
+   /* a command on the control socket is not held up by the wait */
+   if(cs->sparams->control != NULL)
+      poll = PX_YES;
+   /* with backups to look for the wait is cut short, see coord_speculate */
+   if( (cs->fin != NULL) && (cs->next >= cs->n) && (cs->done < cs->n) )
+   {
+      poll = PX_YES;
+      tend = MPI_Wtime() + (PX_SPEC_POLL_MSECS / 1000.0);
+   }
+#endif
+
+   if( (block == PX_YES) && (poll == PX_NO) )
+      mrc = MPI_Waitsome(cs->nworkers, cs->rreqs, &nc, cs->ridx, cs->rstats);
+   else
+      mrc = MPI_Testsome(cs->nworkers, cs->rreqs, &nc, cs->ridx, cs->rstats);
+#ifdef HAVE_NANOSLEEP 
+   /* sharing the rank with a worker, sleep between tests rather than spin in MPI_Waitsome */
+   while( (block == PX_YES) && (poll == PX_YES) && (mrc == MPI_SUCCESS) && (nc == 0) && ((tend == 0.0) || (MPI_Wtime() < tend)) && 
+          (control_pending(cs->sparams->control) == PX_NO) )
+   {
+      nanosleep(&nanoreq, NULL);
+      mrc = MPI_Testsome(cs->nworkers, cs->rreqs, &nc, cs->ridx, cs->rstats);
+   }
+#endif
+   if(mrc != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d : MPI_Waitsome Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   /* a wait is time the workers kept the coordinator idle */
+   coord_tock(cs, ((block == PX_YES) ? PX_PROF_IDLE : PX_PROF_RECV), t);
+   if(twait > 0)
+      trace_event(cs->trace, PX_TRACE_WAIT, twait, now_tm_nsecs() - twait, 0, -1, 0, 0);
+   return ((nc == MPI_UNDEFINED) ? 0 : nc);
+}/* coord_recv_some */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, takes the completion message of worker j (the i'th receive coord_recv_some 
+* found done), reposts its receive and tops up the worker's prefetch queue.
+*/
+static int coord_recv_take(COORD_STATE* cs, int i)
+{
+   WORKER_STATE* w;
+   int j, msglen = 0, rc;
+   long long t;
+
+   j = cs->ridx[i];
+   w = &(cs->workers[j]);
+   t = coord_tick(cs);
+   if( MPI_Get_count(&(cs->rstats[i]), MPI_PACKED, &msglen) != MPI_SUCCESS)
+      return -1;
+   coord_tock(cs, PX_PROF_RECV, t);
+   if( coord_complete(cs, w, &(cs->rbufs[(size_t)j * (size_t)cs->rbufsize]), msglen) < 0)
+   {
+      fprintf(stderr, "\"%s\" @L %d : bad completion message from rank[%d]\n", SRC_FILE, __LINE__, w->rank);
+      return -1;
+   }
+   t = coord_tick(cs);
+   if( coord_recv_post(cs, j) < 0)
+      return -1;
+   coord_tock(cs, PX_PROF_RECV, t);
+   /* send out next piece, topping up the worker's prefetch queue */
+   while( (rc = coord_dispatch(cs, w)) > 0)
+      ;
+   /* a retry kept from w (see coord_redispatch) goes to whoever is idle */
+   for(j = 0; (rc == 0) && (cs->rlen > 0) && (j < cs->nworkers); j++)
+   {
+      while( (rc = coord_dispatch(cs, &(cs->workers[j]))) > 0)
+         ;
+   }
+   return rc;
+}/* coord_recv_take */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, the end of a run: the posted receives are cancelled, the dispatch sends 
+* finished and ENDWORK is passed down a tree of the workers.
+*/
+static int coord_shutdown(COORD_STATE* cs)
+{
+   int j;
+
+   for(j = 0; (cs->rreqs != NULL) && (j < cs->nworkers); j++)
+   {
+      if(cs->rreqs[j] == MPI_REQUEST_NULL)
+         continue;
+      MPI_Cancel(&(cs->rreqs[j]));
+      MPI_Wait(&(cs->rreqs[j]), MPI_STATUS_IGNORE);
+   }
+   if( coord_senddrain(cs) < 0)
+      return -1;
+   if(cs->trace != NULL)
+      trace_event(cs->trace, PX_TRACE_CONTROL, now_tm_nsecs(), 0, 0, -1, ENDWORK, 0);
+   return mpi_endwork_tree(cs->dcomm, cs->rankstart, cs->nworkers, 0);
+}/* coord_shutdown */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, the units sent out and not reported yet.
+*/
+static unsigned int coord_inflight(COORD_STATE* cs)
+{
+   unsigned int nout = 0;
+   int j;
+
+   for(j = 0; j < cs->nworkers; j++)
+      nout += cs->workers[j].inflight;
+   return nout;
+}/* coord_inflight */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, tops up every worker's prefetch queue. Returns < 0 on failure.
+*/
+static int coord_topup(COORD_STATE* cs)
+{
+   int j, rc = 0;
+
+   for(j = 0; (rc >= 0) && (j < cs->nworkers); j++)
+   {
+      while( (rc = coord_dispatch(cs, &(cs->workers[j]))) > 0)
+         ;
+   }
+   return rc;
+}/* coord_topup */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, PX_YES if the line of unit id matches the shell wildcard pat (a substring
+* without fnmatch), PX_NO if not and < 0 on failure. The line is the one in the arg list, as 
+* dump_work_list_as_listed writes it for a loaded list (with its exec, cost and "+" columns) and 
+* as coord_fprint_line does for a streamed one, it is built in *lbuf.
+*/
+static int coord_match(COORD_STATE* cs, unsigned int id, const char* pat, char** lbuf, size_t* lcap)
+{
+   WORK_UNIT* wu;
+   const char* args;
+   char* nbuf;
+   size_t plen = 0, alen, start;
+   unsigned int eidx = 0;
+
+   if(cs->wstore != NULL)
+   {
+      /* the args only ever lose their front, the line starts after the newline before them */
+      for(start = cs->wstore->offs[id]; (start > 0) && (cs->wstore->map[start-1] != '\n'); start--)
+         ;
+      args = &(cs->wstore->map[start]);
+      alen = cs->wstore->offs[id] + (size_t) cs->wstore->lens[id] - start;
+   }
+   else
+   {
+      wu = COORD_UNIT(cs, id);
+      args = (wu->pargs != NULL) ? wu->pargs : "";
+      alen = strlen(args);
+      /* a line's exec may be the -p program, entry 0, it is matched too */
+      eidx = wu->exec_idx;
+      if( (cs->wstream != NULL) && (cs->wstream->etab != NULL) && (eidx < cs->wstream->etab->n) )
+         plen = strlen(cs->wstream->etab->paths[eidx]) + 1;
+   }
+   if(plen + alen + 1 > *lcap)
+   {
+      if( (nbuf = (char*) realloc(*lbuf, plen + alen + 1)) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d : realloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
+      }
+      *lbuf = nbuf;
+      *lcap = plen + alen + 1;
+   }
+   if(plen > 0)
+      sprintf(*lbuf, "%s ", cs->wstream->etab->paths[eidx]);
+   memcpy(&((*lbuf)[plen]), args, alen);
+   (*lbuf)[plen + alen] = '\0';
+#ifdef HAVE_FNMATCH_H 
+   return (fnmatch(pat, *lbuf, 0) == 0) ? PX_YES : PX_NO;
+#else
+   return (strstr(*lbuf, pat) != NULL) ? PX_YES : PX_NO;
+#endif
+}/* coord_match */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, moves the queued units (not sent yet) that match pat to the front of the
+* queue with front PX_YES, else to the back, the others keep their order. Returns the number of
+* units that match, < 0 on failure.
+*/
+static int coord_reorder(COORD_STATE* cs, const char* pat, int front)
+{
+   WORK_UNIT* tmp;
+   unsigned int* ids;
+   unsigned char* hit;
+   char* lbuf = NULL;
+   size_t lcap = 0;
+   unsigned int m, u, k = 0, nhit = 0;
+   int rc = 0;
+
+   if(cs->next >= cs->n)
+      return 0;
+   m = cs->n - cs->next;
+   ids = (unsigned int*) malloc(m * sizeof(unsigned int));
+   hit = (unsigned char*) malloc(m * sizeof(unsigned char));
+   if( (ids == NULL) || (hit == NULL) )
+   {
+      fprintf(stderr, "\"%s\" @L %d : malloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      free(ids); free(hit);
+      return -1;
+   }
+   for(u = 0; (rc >= 0) && (u < m); u++)
+   {
+      if( (rc = coord_match(cs, cs->next + u, pat, &lbuf, &lcap)) == PX_YES)
+         nhit++;
+      hit[u] = (unsigned char) rc;
+   }
+   free(lbuf);
+   for(u = 0; (rc >= 0) && (u < m); u++)
+   {
+      if( (hit[u] == PX_YES) == (front == PX_YES) )
+         ids[k++] = cs->next + u;
+   }
+   for(u = 0; (rc >= 0) && (u < m); u++)
+   {
+      if( (hit[u] == PX_YES) != (front == PX_YES) )
+         ids[k++] = cs->next + u;
+   }
+   if( (rc >= 0) && (nhit > 0) && (nhit < m) )
+   {
+      if(cs->wstore != NULL)
+         rc = work_store_permute(cs->wstore, cs->next, ids, m);
+      else if( (tmp = (WORK_UNIT*) malloc(m * sizeof(WORK_UNIT))) != NULL)
+      {
+         /* a streamed unit's id is its place in the window */
+         for(u = 0; u < m; u++)
+            tmp[u] = *COORD_UNIT(cs, ids[u]);
+         for(u = 0; u < m; u++)
+         {
+            *COORD_UNIT(cs, cs->next + u) = tmp[u];
+            COORD_UNIT(cs, cs->next + u)->id_tag = cs->next + u;
+         }
+         free(tmp);
+      }
+      else
+      {
+         fprintf(stderr, "\"%s\" @L %d : malloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         rc = -1;
+      }
+   }
+   free(ids);
+   free(hit);
+   return ((rc < 0) ? -1 : (int)nhit);
+}/* coord_reorder */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, drops the last k queued units from the run. A loaded list keeps them past 
+* the end, so they are among the units not complete, a streamed list's are freed and the window 
+* reads on in their place.
+*/
+static void coord_drop(COORD_STATE* cs, unsigned int k)
+{
+   unsigned int id;
+
+   if(cs->wstream != NULL)
+   {
+      for(id = cs->n - k; id < cs->n; id++)
+      {
+         free(COORD_UNIT(cs, id)->pargs);
+         COORD_UNIT(cs, id)->pargs = NULL;
+      }
+      cs->wstream->nunits -= k;
+   }
+   cs->n -= k;
+   cs->sstats->cancelled += k;
+}/* coord_drop */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, a worker (rank, or all of them with rank < 0) is to run n units at once, 
+* at most the slots it started with. Returns the number of workers changed, < 0 on failure.
+*/
+static int coord_resize(COORD_STATE* cs, unsigned int n, int rank)
+{
+   WORKER_STATE* w;
+   int j, nw = 0;
+
+   for(j = 0; j < cs->nworkers; j++)
+   {
+      w = &(cs->workers[j]);
+      if( (rank >= 0) && (w->rank != rank) )
+         continue;
+      cs->nslots -= w->slots;
+      w->slots = (n < w->maxslots) ? n : w->maxslots;
+      cs->nslots += w->slots;
+      if( coord_sendword(cs, w->rank, SLOTSWORK, w->slots) < 0)
+         return -1;
+      nw++;
+   }
+   return nw;
+}/* coord_resize */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, a unit's line as in the arg list.
+*/
+static void coord_fprint_line(FILE* fout, COORD_STATE* cs, WORK_UNIT* wu)
+{
+   /* a line's exec may be the -p program, entry 0, keep it too */
+   if( (cs->wstream != NULL) && (cs->wstream->etab != NULL) && (wu->exec_idx < cs->wstream->etab->n) )
+      fprintf(fout, "%s ", cs->wstream->etab->paths[wu->exec_idx]);
+   fprintf(fout, "%s\n", ((wu->pargs != NULL) ? wu->pargs : ""));
+}/* coord_fprint_line */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, at the end of a drain writes the units not complete to cs->drainto: with a
+* loaded list those not sent, cancelled or waiting for a retry and those that failed after their 
+* retries (as the -n checkpoint has them). With a streamed list those held that are not done and 
+* the rest of the input, which is read to its end.
+*/
+static int coord_drain_write(COORD_STATE* cs)
+{
+   WORK_UNIT oneu;
+   FILE* fout;
+   unsigned char* windex;
+   unsigned int id, r;
+   int rc;
+
+   cs->sstats->drained = PX_YES;
+   if(cs->wstore != NULL)
+   {
+      if( (windex = (unsigned char*) calloc(cs->wstore->n + 1, sizeof(unsigned char))) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d : calloc failed : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
+      }
+      for(id = 0; id < cs->next; id++)
+         windex[id] = ((cs->tries != NULL) && ((cs->wstore->was_killed[id] != 0) || (cs->wstore->exitstat[id] != 0))) ? 0 : 1;
+      for(r = 0; r < cs->rlen; r++)
+         windex[cs->retry[(cs->rhead + r) % cs->rcap]] = 0;
+      for(id = 0; id < cs->wstore->n; id++)
+         cs->sstats->notdone += (windex[id] == 0) ? 1 : 0;
+      /* as the lines were, the cost column and "+" mark are off the store's args */
+      rc = dump_work_list_as_listed(cs->drainto, cs->wstore, windex);
+      free(windex);
+      return rc;
+   }
+   if( (fout = fopen(cs->drainto, "w")) == NULL)
+   {
+      fprintf(stderr, "\"%s\" @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, cs->drainto, strerror(errno));
+      return -1;
+   }
+   for(id = cs->base; id < cs->n; id++)
+   {
+      if(cs->finished[id % cs->wcap] != 0)
+         continue;
+      coord_fprint_line(fout, cs, COORD_UNIT(cs, id));
+      cs->sstats->notdone += 1;
+   }
+   while( (rc = work_stream_next(cs->wstream, &oneu, PX_YES)) == 1)
+   {
+      coord_fprint_line(fout, cs, &oneu);
+      free(oneu.pargs);
+      cs->sstats->notdone += 1;
+   }
+   if( (fclose(fout) != 0) || (rc < 0) )
+      return -1;
+   return 0;
+}/* coord_drain_write */
+
+/*-----------------------------------------------------------------------------------------------------
+* Local module routine, carries out a command from the control socket (see control_open), if one 
+* is waiting, and replies to it. Returns < 0 on failure.
+*/
+static int coord_control(COORD_STATE* cs)
+{
+   CONTROL_CMD cmd;
+   char reply[2 * PX_CTRL_LNMAX];
+   const char* path;
+   int rc;
+
+   if(control_take(cs->sparams->control, &cmd) == 0)
+      return 0;
+   rc = 0;
+   if(cmd.op == PX_CTRL_PAUSE)
+   {
+      cs->paused = PX_YES;
+      snprintf(reply, sizeof(reply), "paused, %u units out", coord_inflight(cs));
+   }
+   else if(cmd.op == PX_CTRL_RESUME)
+   {
+      if(cs->drainto != NULL)
+         snprintf(reply, sizeof(reply), "error: the run is draining");
+      else
+      {
+         cs->paused = PX_NO;
+         rc = coord_topup(cs);
+         snprintf(reply, sizeof(reply), "resumed, %u units out", coord_inflight(cs));
+      }
+   }
+   else if(cmd.op == PX_CTRL_DRAIN)
+   {
+      path = (cmd.arg[0] != '\0') ? cmd.arg : cs->sparams->notcomplete;
+      if(cs->drainto != NULL)
+         snprintf(reply, sizeof(reply), "error: the run is draining to \"%s\"", cs->drainto);
+      else if(path == NULL)
+         snprintf(reply, sizeof(reply), "error: drain needs a path for the units not complete (there is no -n file)");
+      else if( (cs->drainto = strdup(path)) == NULL)
+         rc = -1;
+      else
+      {
+         cs->paused = PX_YES;
+         snprintf(reply, sizeof(reply), "draining, %u units out, the units not complete go to \"%s\"", coord_inflight(cs), path);
+      }
+   }
+   else if(cmd.op == PX_CTRL_CANCEL)
+   {
+      if( (rc = coord_reorder(cs, cmd.arg, PX_NO)) >= 0)
+      {
+         coord_drop(cs, (unsigned int)rc);
+         snprintf(reply, sizeof(reply), "cancelled %d queued units", rc);
+      }
+   }
+   else if(cmd.op == PX_CTRL_FRONT)
+   {
+      if( (rc = coord_reorder(cs, cmd.arg, PX_YES)) >= 0)
+         snprintf(reply, sizeof(reply), "moved %d queued units to the front", rc);
+   }
+   else if(cmd.op == PX_CTRL_SLOTS)
+   {
+      if( ((rc = coord_resize(cs, cmd.n, cmd.rank)) > 0) && ((rc = coord_topup(cs)) >= 0) )
+         snprintf(reply, sizeof(reply), "%u slots in all", cs->nslots);
+      else if(rc == 0)
+         snprintf(reply, sizeof(reply), "error: no worker of rank %d", cmd.rank);
+   }
+   if(rc < 0)
+   {
+      control_reply(cs->sparams->control, "error: the coordinator failed");
+      return -1;
+   }
+   control_reply(cs->sparams->control, reply);
+   if(cs->verbose >= 1)
+      fprintf(cs->verbout, "COORDNTR CONTROL : %s\n", reply);
+   return 0;
+}/* coord_control */
+
+/*-----------------------------------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int coordinate_proc( WORK_STORE* wstore, WORK_STREAM* wstream, 
+                     EXEC_TABLE* etab, MPI_Comm wcomm, int nworkers, int rankstart, 
+                     MPI_Comm moncomm, int mnrank, JOURNAL* jrnl, HISTORY* hist, 
+                     SCHED_PARAMS* sparams, SCHED_STATS* sstats,
+                     unsigned int verbose, FILE* verbout
+                   )
+{
+   MPI_Status mstatus;
+   COORD_STATE cs;
+   unsigned int n, u, nmon, maxslots = 1;
+   int i, j, rc, nc, nadd;
+   long long t, tprof;
+   const int mrank = 0; /* This is fixed to 0 for now */
+
+   memset(&cs, 0, sizeof(COORD_STATE));
+   memset(sstats, 0, sizeof(SCHED_STATS));
+   cs.monreq = MPI_REQUEST_NULL;
+   n = (wstream == NULL) ? wstore->n : 0;
+   cs.wstore = (wstream == NULL) ? wstore : NULL;
+   cs.wcap = 1;
+   cs.n = n;
+   cs.wstream = wstream;
+   cs.etab = etab;
+   cs.comm = wcomm;
+   cs.dcomm = (sparams->dispcomm != MPI_COMM_NULL) ? sparams->dispcomm : wcomm;
+   cs.poll = (sparams->dispcomm != MPI_COMM_NULL) ? PX_YES : PX_NO;
+   cs.nworkers = nworkers;
+   cs.rankstart = rankstart;
+   cs.sparams = sparams;
+   cs.sstats = sstats;
+   cs.moncomm = moncomm;
+   cs.mnrank = mnrank;
+   cs.jrnl = jrnl;
+   cs.hist = hist;
+   cs.verbose = verbose;
+   cs.verbout = verbout;
+   cs.prof = (sparams->profile == PX_YES) ? sstats->prof : NULL;
+   cs.trace = sparams->trace;
+   if(sparams->chunkmax < 1)
+      sparams->chunkmax = 1;
+   if(sparams->depth < 1)
+      sparams->depth = 1;
+   if(sparams->wslots < 1)
+      sparams->wslots = 1;
+
+   if( (cs.workers = (WORKER_STATE*) calloc(nworkers, sizeof(WORKER_STATE))) == NULL)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : calloc failed : %s\n", SRC_FILE, __LINE__, mrank, strerror(errno));
+      return -1;
+   }
+   for(j = 0; j < nworkers; j++)
+   {
+      cs.workers[j].rank = rankstart + j;
+      cs.workers[j].known = 1ULL;
+      cs.workers[j].slots = ((sparams->slots != NULL) && (sparams->slots[j] > 0)) ? sparams->slots[j] : sparams->wslots;
+      cs.workers[j].maxslots = cs.workers[j].slots;
+      cs.nslots += cs.workers[j].slots;
+      if(cs.workers[j].slots > maxslots)
+         maxslots = cs.workers[j].slots;
+   }
+   if( coord_trace_ranks(&cs) < 0)
+   {
+      coord_state_free(&cs);
+      return -1;
+   }
+   /* a batch is at most a chunk per slot */
+   cs.nsend = sparams->chunkmax * maxslots;
+   cs.sendu = (WORK_UNIT*) calloc(cs.nsend, sizeof(WORK_UNIT));
+   cs.sendp = (WORK_UNIT**) calloc(cs.nsend, sizeof(WORK_UNIT*));
+   if(cs.wstore != NULL)
+   {
+      cs.senda = (char**) calloc(cs.nsend, sizeof(char*));
+      cs.sendacap = (size_t*) calloc(cs.nsend, sizeof(size_t));
+   }
+   else
+   {
+      /* the streamed units live in a window of their own */
+      cs.wcap = wstream->window;
+      cs.n = 0;
+      cs.wunits = (WORK_UNIT*) calloc(cs.wcap, sizeof(WORK_UNIT));
+      cs.finished = (unsigned char*) calloc(cs.wcap, sizeof(unsigned char));
+   }
+   /* the marked units of a loaded list may get backups */
+   if( (cs.wstore != NULL) && (wstore->dupok != NULL) && (sparams->speculate > 0.0) )
+   {
+      cs.tsent = (double*) calloc(n + 1, sizeof(double));
+      cs.backrank = (int*) malloc((n + 1) * sizeof(int));
+      cs.fin = (unsigned char*) calloc(n + 1, sizeof(unsigned char));
+      for(u = 0; (cs.backrank != NULL) && (u < n); u++)
+         cs.backrank[u] = RANK_UNASSIGNED;
+   }
+   /* a unit waits for at most one retry at a time */
+   if(sparams->retries > 0)
+   {
+      cs.rcap = (wstream == NULL) ? (n + 1) : cs.wcap;
+      cs.retry = (unsigned int*) malloc(cs.rcap * sizeof(unsigned int));
+      cs.tries = (unsigned char*) calloc(cs.rcap, sizeof(unsigned char));
+   }
+   if( (cs.sendu == NULL) || (cs.sendp == NULL) || ((cs.wstore != NULL) && ((cs.senda == NULL) || (cs.sendacap == NULL))) || 
+       ((wstream != NULL) && ((cs.wunits == NULL) || (cs.finished == NULL))) ||
+       ((sparams->retries > 0) && ((cs.retry == NULL) || (cs.tries == NULL))) ||
+       ((cs.wstore != NULL) && (wstore->dupok != NULL) && (sparams->speculate > 0.0) && ((cs.tsent == NULL) || (cs.backrank == NULL) || (cs.fin == NULL))) )
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : calloc failed : %s\n", SRC_FILE, __LINE__, mrank, strerror(errno));
+      coord_state_free(&cs);
+      return -1;
+   }
+
+   if( (moncomm != MPI_COMM_NULL) && (wstream == NULL) ) 
+   {
+      /* the monitor checkpoints the whole arg list, resumed or not */
+      nmon = (wstore->orig != NULL) ? wstore->norig : n;
+      if(verbose >= 2) 
+         fprintf(verbout, "COORDNTR WRLD Rank %d, NOTIFYING MONITOR[Rank %d] of the number of units (%u)\n", mrank, mnrank, nmon);
+      
+      if( (MPI_Isend(&nmon, 1, MPI_UNSIGNED, mnrank, UNIT_TAG, moncomm, &(cs.monreq)) != MPI_SUCCESS) || 
+          (coord_notify_skipped(&cs, wstore) < 0) )
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_ISend Failed to monitor via sub comm.\n", SRC_FILE, __LINE__, mrank);
+         coord_state_free(&cs);
+         return -1;
+      }
+   }
+
+   /* wait for the first of a streamed list */
+   if( (wstream != NULL) && (coord_fill(&cs, PX_YES) < 0) )
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : failed to read the arg list\n", SRC_FILE, __LINE__, mrank);
+      coord_state_free(&cs);
+      return -1;
+   }
+
+   /* completions are received into buffers posted up front */
+   if( coord_recv_init(&cs, maxslots) < 0)
+   {
+      coord_state_free(&cs);
+      return -1;
+   }
+   for(j = 0; j < nworkers; j++)
+   {
+      if( coord_recv_post(&cs, j) < 0)
+      {
+         coord_state_free(&cs);
+         return -1;
+      }
+   }
+
+   /* Do initial divvy, random starts and the launch rate are kept by the workers (see work_start) */
+   tprof = coord_tick(&cs);
+   for(j = 0; (j < nworkers) && (cs.next < cs.n); j++)
+   {
+      /* fill the worker's prefetch queue */
+      while( (rc = coord_dispatch(&cs, &(cs.workers[j]))) > 0)
+         ;
+      if(rc < 0)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Isend Failed! :(\n", SRC_FILE, __LINE__, mrank);
+         coord_state_free(&cs);
+         return -1;
+      }
+   }
+
+   /* Go until we're done. A receive is posted for every worker and all of the sends are nonblocking,
+      so each pass takes whatever completions are in and a slow worker only holds up itself */
+   while( (cs.done < cs.n) || (cs.nback > 0) || ((wstream != NULL) && STREAM_MORE(wstream)) )
+   {
+      nc = 0;
+      /* the last pass's completions and dispatches, before anything may wait */
+      coord_status(&cs);
+      /* a command on the control socket, a drained run ends once the units out are in */
+      if( coord_control(&cs) < 0)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : failed on a control command\n", SRC_FILE, __LINE__, mrank);
+         coord_state_free(&cs);
+         return -1;
+      }
+      if( (cs.drainto != NULL) && (coord_inflight(&cs) == 0) )
+         break;
+      /* backups for the units that hold up the end of the run */
+      if( coord_speculate(&cs) < 0)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Isend Failed! :(\n", SRC_FILE, __LINE__, mrank);
+         coord_state_free(&cs);
+         return -1;
+      }
+      if( (wstream != NULL) && (cs.drainto == NULL) )
+      {
+         /* read on while the window has room, block only if there is nothing else to wait for 
+            (and no control socket to answer) */
+         t = coord_tick(&cs);
+         if( (nadd = coord_fill(&cs, (((cs.done == cs.n) && (sparams->control == NULL)) ? PX_YES : PX_NO))) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : failed to read the arg list\n", SRC_FILE, __LINE__, mrank);
+            coord_state_free(&cs);
+            return -1;
+         }
+         coord_tock(&cs, PX_PROF_READ, t);
+         for(j = 0; (nadd > 0) && (j < nworkers) && (cs.next < cs.n); j++)
+         {
+            while( (rc = coord_dispatch(&cs, &(cs.workers[j]))) > 0)
+               ;
+            if(rc < 0)
+            {
+               fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Isend Failed! :(\n", SRC_FILE, __LINE__, mrank);
+               coord_state_free(&cs);
+               return -1;
+            }
+         }
+         if(cs.done == cs.n)
+         {
+            if( (nadd == 0) && (sparams->control != NULL) )
+               work_stream_ready(wstream, PX_STREAM_POLL_MSECS);
+            continue;
+         }
+         /* with input still to come don't sit in the wait, look back at the input now and then */
+         if( STREAM_MORE(wstream) && ((cs.n - cs.base) < cs.wcap) )
+         {
+            if( (nc = coord_recv_some(&cs, PX_NO)) < 0)
+            {
+               coord_state_free(&cs);
+               return -1;
+            }
+            if(nc == 0)
+            {
+               t = coord_tick(&cs);
+               work_stream_ready(wstream, PX_STREAM_POLL_MSECS);
+               coord_tock(&cs, PX_PROF_IDLE, t);
+               continue;
+            }
+         }
+      }
+
+      /* a batch for the monitor that could not go out with its last unit */
+      t = coord_tick(&cs);
+      if( coord_monflush(&cs, PX_NO) < 0)
+      {
+         coord_state_free(&cs);
+         return -1;
+      }
+      coord_tock(&cs, PX_PROF_NOTIFY, t);
+      /* journal records are synced as a group, now if there is nothing to do but wait */
+      if( (nc == 0) && (jrnl != NULL) && (jrnl->npend > 0) )
+      {
+         rc = 0;
+         if( (nc = coord_recv_some(&cs, PX_NO)) >= 0)
+         {
+            t = coord_tick(&cs);
+            rc = journal_flush(jrnl, ((nc == 0) ? PX_YES : PX_NO));
+            coord_tock(&cs, PX_PROF_RECORD, t);
+         }
+         if( (nc < 0) || (rc < 0) )
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : failed to write the journal\n", SRC_FILE, __LINE__, mrank);
+            coord_state_free(&cs);
+            return -1;
+         }
+      }
+
+      /* anybody finished? */
+      if( (nc == 0) && ((nc = coord_recv_some(&cs, PX_YES)) < 0) )
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Waitsome Failed! :(\n", SRC_FILE, __LINE__, mrank);
+         coord_state_free(&cs);
+         return -1;
+      }
+      for(i = 0; i < nc; i++)
+      {
+         if( coord_recv_take(&cs, i) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : failed on completion from rank[%d]\n", SRC_FILE, __LINE__, mrank, cs.workers[cs.ridx[i]].rank);
+            coord_state_free(&cs);
+            return -1;
+         }
+      }
+   }
+   
+   if(cs.prof != NULL)
+      sstats->prof_ns = (unsigned long long)(now_tm_nsecs() - tprof);
+   coord_status(&cs);
+   if( (cs.drainto != NULL) && (coord_drain_write(&cs) < 0) )
+      fprintf(stderr, "\"%s\" @L %d RANK %d : WARN : failed to write the units not complete to \"%s\"\n", SRC_FILE, __LINE__, mrank, cs.drainto);
+   else if(cs.drainto != NULL)
+      fprintf(verbout, "DRAINED %lu units not complete, written to \"%s\"\n", sstats->notdone, cs.drainto);
+
+   /* tell workers we're done */
+   if( coord_shutdown(&cs) < 0)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : shutdown Failed! :(\n", SRC_FILE, __LINE__, mrank);
+      coord_state_free(&cs);
+      return -1;
+   }
+   
+   /* tell the monitor we're done, after the last batch */
+   if(moncomm != MPI_COMM_NULL) 
+   {
+      fprintf(verbout, "Sending exit to monitor...\n");
+      if( coord_monflush(&cs, PX_YES) < 0)
+      {
+         coord_state_free(&cs);
+         return -1;
+      }
+      if( MPI_Wait(&(cs.monreq), &mstatus) != MPI_SUCCESS)
+         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN MPI_Wait Failed! :(\n", SRC_FILE, __LINE__, mrank);
+      if( MPI_Isend(0, 0, MPI_UNSIGNED, mnrank, ENDWORK, moncomm, &(cs.monreq)) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed to monitor via sub comm.\n", SRC_FILE, __LINE__, mrank);
+         coord_state_free(&cs);
+         return -1;
+      }
+   }
+   coord_state_free(&cs);
+   return 0;
+}/* coordinate_proc */
+
+/*-------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int monitor_proc( MPI_Comm coorcomm, int crank, int wrank, 
+                  unsigned int preexit, unsigned char** itemidx, 
+                  unsigned int* ni, unsigned int verbose, 
+                  FILE* verbout )
+{
+   MPI_Status status;
+   unsigned int* ids = NULL;
+   unsigned int* nptr;
+   unsigned int u, curiflg = 0;
+   int per = 0, stp = 0, nids = 0, idcap = 0, flag = 0;
+   struct ptparams p;
+   pthread_t pthrd;
+   pthread_attr_t attr;
+#ifdef HAVE_NANOSLEEP 
+   struct timespec nanoreq;
+
+   memset(&nanoreq, 0, sizeof(struct timespec));
+   nanoreq.tv_nsec = PX_MON_POLL_MSECS * 1000000L;
+#endif
+
+   *ni = 0;
+   *itemidx = NULL;
+   status.MPI_TAG = DOWORK; /* init */
+   p.preexit = preexit; 
+   p.verbose = verbose; 
+   p.verbout = verbout;
+
+   if(verbose >= 2)
+      fprintf(verbout, "MONITOR WRLD Rank %d, COORDNTR Sub Rank %d\n", wrank, crank);
+   
+   if( (per = pthread_mutex_init(&mtexstop, NULL)) != 0)
+   {   
+      fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_mutex_init Failed (pthrd error %d)\n", SRC_FILE, __LINE__, wrank, per);
+      return -1;
+   }   
+   if( (per = pthread_attr_init(&attr)) != 0)
+   {   
+      fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_attr_init Failed (pthrd error %d)\n", SRC_FILE, __LINE__, wrank, per);
+      return -1;
+   }   
+   if( (per = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED)) != 0)
+   {   
+      fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_attr_setdetachstate Failed (pthrd error %d)\n", SRC_FILE, __LINE__, wrank, per);
+      pthread_attr_destroy(&attr);
+      return -1;
+   }
+   if( (per = pthread_create(&pthrd, &attr, pbs_poll, (void*) &p)) != 0)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_create Failed (pthrd error %d)\n", SRC_FILE, __LINE__, wrank, per);
+      pthread_attr_destroy(&attr);
+      return -1;
+   }
+   pthread_attr_destroy(&attr);
+
+   /* begin checkpointing and pbs poll loop... */
+   while(status.MPI_TAG != ENDWORK) 
+   {
+      pthread_mutex_lock(&mtexstop);
+      stp = stopissed; 
+      pthread_mutex_unlock(&mtexstop);
+      if(stp == 1)
+      {
+         if(verbose >= 1) 
+            fprintf(verbout, "MONITOR, shutdown threat issued, MONITOR exiting...\n");
+         free(ids);
+         return 1;
+      }
+
+      /* it's assumed at least one message will come otherwise this will wait, and wait, and wait ... 
+         The wait is a poll so the stop is seen without a message and the monitor does not spin
+         in MPI when it is a thread of rank 0. Completed ids come in batches so the buffer is 
+         sized per message */
+      if( MPI_Iprobe(crank, MPI_ANY_TAG, coorcomm, &flag, &status) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Iprobe Failed! :(\n", SRC_FILE, __LINE__, wrank);
+         free(ids);
+         return -1;
+      }
+      if(flag == 0)
+      {
+#ifdef HAVE_NANOSLEEP 
+         nanosleep(&nanoreq, NULL);
+#endif
+         status.MPI_TAG = DOWORK;
+         continue;
+      }
+      if( MPI_Get_count(&status, MPI_UNSIGNED, &nids) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Get_count Failed! :(\n", SRC_FILE, __LINE__, wrank);
+         free(ids);
+         return -1;
+      }
+      if(nids > idcap)
+      {
+         if( (nptr = (unsigned int*) realloc(ids, (size_t)nids * sizeof(unsigned int))) == NULL)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : realloc failed : %s\n", SRC_FILE, __LINE__, wrank, strerror(errno));
+            free(ids);
+            return -1;
+         }
+         ids = nptr;
+         idcap = nids;
+      }
+      if( MPI_Recv(ids, nids, MPI_UNSIGNED, crank, status.MPI_TAG, coorcomm, &status) != MPI_SUCCESS)
+         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN MPI_Recv Failed! :(\n", SRC_FILE, __LINE__, wrank);
+      curiflg = (nids > 0) ? ids[0] : 0;
+         
+      if(status.MPI_TAG == COMPLETED_WORK) 
+      {
+         if(verbose >= 3) 
+            fprintf(verbout, "MONITOR received %d ids for completed units from rank %d\n", nids, status.MPI_SOURCE);
+         /* mark complete */
+         for(u = 0; (*itemidx != NULL) && (u < (unsigned int)nids); u++)
+         {
+            if(ids[u] < *ni)
+               (*itemidx)[ids[u]] = 1;
+         }
+      }
+      else if(status.MPI_TAG == UNIT_TAG)
+      {
+         if(verbose >= 3) 
+            fprintf(verbout, "MONITOR received n items (%u) notice from rank %d\n", curiflg, status.MPI_SOURCE);
+         *ni = curiflg;
+
+         if( ( *itemidx = (unsigned char*) calloc( (size_t)(*ni), sizeof(unsigned char)) ) == NULL)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : calloc failed : %s\n", SRC_FILE, __LINE__, wrank, strerror(errno));
+            free(ids);
+            return -1;
+         }
+      }
+      else if(status.MPI_TAG == ENDWORK) 
+      {
+         if(verbose >= 2) 
+            fprintf(verbout, "MONITOR received a normal exit signal\n");
+         stopissed = 2; /* locking this here not that critical */
+      }
+   }
+   free(ids);
+   /* the units that failed for good were never reported */
+   for(u = 0; (*itemidx != NULL) && (u < *ni); u++)
+   {
+      if((*itemidx)[u] == 0)
+         return 2;
+   }
+   return 0;
+}/* monitor_proc */
+
+/*-------------------------------------------------------------------------
+* Local module routine, takes the exec table entry a unit may carry and points
+* the unit at its executable. Returns < 0 if the executable is unknown.
+*/
+static int work_set_exec(EXEC_TABLE* wtab, WORK_UNIT* oneu)
+{
+   /* a new exec table entry comes with the unit, keep it */
+   if(oneu->procpath != NULL)
+   {
+      free(wtab->paths[oneu->exec_idx]);
+      wtab->paths[oneu->exec_idx] = oneu->procpath;
+      if(oneu->exec_idx >= wtab->n)
+         wtab->n = oneu->exec_idx + 1;
+   }
+   if( (oneu->procpath = wtab->paths[oneu->exec_idx]) == NULL)
+      return -1;
+   return 0;
+}/* work_set_exec */
+
+
+/*-------------------------------------------------------------------------
+* Local module type, a unit queued on a worker
+*/
+typedef struct
+{
+   WORK_UNIT unit;
+   /* the last unit of a dispatch message, its batch is reported when it completes */
+   int batch_end;
+} WORK_QITEM;
+
+/*-------------------------------------------------------------------------
+* Local module type, a unit running on a worker
+*/
+typedef struct
+{
+   /* the child's pid (and process group), 0 when the slot is free */
+   pid_t pid;
+   WORK_UNIT unit;
+   int batch_end;
+   /* the start time and the time the child's group gets its next signal (milliseconds, see
+      now_tm_msecs), 0 for no limit. killed is PX_YES once it was signalled, hardkill once
+      that was SIGKILL */
+   long long tstart;
+   long long tkill;
+   int killed;
+   int hardkill;
+   /* PX_YES once a leader stopped with SIGTERM has exited (pstat is its wait status), 
+      the slot is held until the rest of its group has as well or the grace is up */
+   int reaped;
+   int pstat;
+   /* the child's pidfd in the worker's epoll set, -1 for none */
+   int pidfd;
+} WORK_SLOT;
+
+/*-------------------------------------------------------------------------
+* Local module type, worker state shared by the work_* routines
+*/
+typedef struct
+{
+   int rank;
+   /* the coordinator is rank 0 of comm, the workers rankstart and up, units 
+      come in on incomm (comm or its duplicate, see WORK_PARAMS) */
+   MPI_Comm comm;
+   MPI_Comm incomm;
+   int rankstart;
+   /* exec table, entry 0 is the broadcast program */
+   EXEC_TABLE wtab;
+   /* units received and not started yet (FIFO), the prefetch queue */
+   WORK_QITEM* q;
+   unsigned int qhead;
+   unsigned int qlen;
+   unsigned int qcap;
+   /* units running at once, nrun of the nslots are in use, at most maxrun of them (SLOTSWORK,
+      0 for all) */
+   WORK_SLOT* slots;
+   unsigned int nslots;
+   unsigned int nrun;
+   unsigned int maxrun;
+   /* a batch's last unit finished, report */
+   int report_due;
+#ifdef PX_CHILD_SLOTS
+   /* SIGCHLD is blocked on the worker and waited for, children get childmask */
+   sigset_t waitmask;
+   sigset_t childmask;
+#endif
+   /* finished units not reported yet */
+   WORK_UNIT* res;
+   WORK_UNIT** resp;
+   unsigned int nres;
+   unsigned int rescap;
+   /* receive buffer */
+   unsigned char* rmsg;
+   int rmsgsize;
+   /* completion send buffer, in use until sendreq completes */
+   unsigned char* smsg;
+   int smsgsize;
+   MPI_Request sendreq;
+   /* command line buffer, and its words for --no-shell */
+   char* cmdbuf;
+   int cmdsize;
+   char** argv;
+   int argvcap;
+   int noshell;
+   int nullin;
+   /* the time limit of a unit and how long after SIGTERM its group gets SIGKILL (milliseconds) */
+   unsigned int maxumsecs;
+   unsigned int gracemsecs;
+   /* the epoll set of the running children's pidfds, -1 to wait on SIGCHLD */
+   int epfd;
+   /* the launch limiter, a unit starts no sooner than tlaunch (now_tm_msecs, 0 for 
+      no limit) and each start moves it on by launchmsecs */
+   double tlaunch;
+   double launchmsecs;
+   /* NULL, or the rank's timeline trace (see WORK_PARAMS trace) */
+   TRACE* trace;
+   unsigned int verbose;
+   FILE* verbout;
+} WORK_STATE;
+
+/* the units a worker may run at once */
+#define WORK_NRUNMAX(ws) ((((ws)->maxrun > 0) && ((ws)->maxrun < (ws)->nslots)) ? (ws)->maxrun : (ws)->nslots)
+
+/*-------------------------------------------------------------------------
+* Local module routine, worker clean up
+*/
+static void work_state_free(WORK_STATE* ws)
+{
+   unsigned int u;
+   for(u = 0; u < ws->qlen; u++)
+      free(ws->q[(ws->qhead + u) % ws->qcap].unit.pargs);
+   for(u = 0; u < ws->nslots; u++)
+   {
+      if(ws->slots[u].pid > 0)
+      {
+#ifdef PX_CHILD_SLOTS
+         kill(-(ws->slots[u].pid), SIGKILL);
+#endif
+         if(ws->slots[u].pidfd >= 0)
+            close(ws->slots[u].pidfd);
+         free(ws->slots[u].unit.pargs);
+      }
+   }
+   if(ws->epfd >= 0)
+      close(ws->epfd);
+   free(ws->slots);
+   free(ws->q);
+   free(ws->res);
+   free(ws->resp);
+   free(ws->rmsg);
+   free(ws->smsg);
+   free(ws->cmdbuf);
+   free(ws->argv);
+   exec_table_free(&(ws->wtab));
+}/* work_state_free */
+
+/*-------------------------------------------------------------------------
+* Local module routine, appends a unit to the worker's queue
+*/
+static int work_queue_push(WORK_STATE* ws, WORK_UNIT* oneu, int batch_end)
+{
+   WORK_QITEM* nq;
+   WORK_QITEM* qi;
+   unsigned int u, ncap;
+
+   if(ws->qlen == ws->qcap)
+   {
+      ncap = (ws->qcap > 0) ? (ws->qcap * 2) : 8;
+      if( (nq = (WORK_QITEM*) malloc(ncap * sizeof(WORK_QITEM))) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : malloc failed : %s\n", SRC_FILE, __LINE__, ws->rank, strerror(errno));
+         return -1;
+      }
+      /* unwrap the ring into the new queue */
+      for(u = 0; u < ws->qlen; u++)
+         nq[u] = ws->q[(ws->qhead + u) % ws->qcap];
+      free(ws->q);
+      ws->q = nq;
+      ws->qhead = 0;
+      ws->qcap = ncap;
+   }
+   qi = &(ws->q[(ws->qhead + ws->qlen) % ws->qcap]);
+   qi->unit = *oneu;
+   qi->batch_end = batch_end;
+   /* a retry comes with the times of the last run */
+   memset(&(qi->unit.tm), 0, sizeof(WORK_TIMES));
+   qi->unit.tm.trecv = now_tm_nsecs();
+   ws->qlen += 1;
+   return 0;
+}/* work_queue_push */
+
+/*-------------------------------------------------------------------------
+* Local module routine, keeps a finished unit for the next report
+*/
+static int work_result_push(WORK_STATE* ws, WORK_UNIT* oneu)
+{
+   void* nptr;
+   unsigned int ncap;
+
+   if(ws->nres == ws->rescap)
+   {
+      ncap = (ws->rescap > 0) ? (ws->rescap * 2) : 8;
+      if( (nptr = realloc(ws->res, ncap * sizeof(WORK_UNIT))) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : realloc failed : %s\n", SRC_FILE, __LINE__, ws->rank, strerror(errno));
+         return -1;
+      }
+      ws->res = (WORK_UNIT*) nptr;
+      if( (nptr = realloc(ws->resp, ncap * sizeof(WORK_UNIT*))) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : realloc failed : %s\n", SRC_FILE, __LINE__, ws->rank, strerror(errno));
+         return -1;
+      }
+      ws->resp = (WORK_UNIT**) nptr;
+      ws->rescap = ncap;
+   }
+   ws->res[ws->nres] = *oneu;
+   ws->nres += 1;
+   return 0;
+}/* work_result_push */
+
+/*-------------------------------------------------------------------------
+* Local module routine, the other copy of unit id finished first (see --speculate). 
+* If the unit is still queued it is dropped and reported as killed, if it is running 
+* its process group is killed and it is reported when reaped. A unit that is already 
+* done is left alone, its report is on the way.
+*/
+static int work_cancel(WORK_STATE* ws, unsigned int id)
+{
+   WORK_QITEM item;
+   unsigned int u, k;
+
+   for(u = 0; u < ws->nslots; u++)
+   {
+      if( (ws->slots[u].pid > 0) && (ws->slots[u].unit.id_tag == id) )
+      {
+         if(ws->verbose >= 2)
+            fprintf(ws->verbout, "Rank %d killing unit %u (slot %u), its other copy finished\n", ws->rank, id, u);
+#ifdef PX_CHILD_SLOTS
+         if(ws->slots[u].hardkill == PX_NO)
+            kill(-(ws->slots[u].pid), SIGKILL);
+#endif
+         ws->slots[u].killed = PX_YES;
+         ws->slots[u].hardkill = PX_YES;
+         ws->slots[u].tkill = 0;
+         return 0;
+      }
+   }
+   for(u = 0; u < ws->qlen; u++)
+   {
+      if(ws->q[(ws->qhead + u) % ws->qcap].unit.id_tag != id)
+         continue;
+      item = ws->q[(ws->qhead + u) % ws->qcap];
+      /* close the gap, the queue keeps its order */
+      for(k = u; (k + 1) < ws->qlen; k++)
+         ws->q[(ws->qhead + k) % ws->qcap] = ws->q[(ws->qhead + k + 1) % ws->qcap];
+      ws->qlen -= 1;
+      free(item.unit.pargs);
+      item.unit.pargs = NULL;
+      item.unit.procpath = NULL;
+      item.unit.proc_secs = 0;
+      item.unit.was_killed = PX_YES;
+      item.unit.exit_code = -1;
+      item.unit.term_sig = 0;
+      ws->report_due = PX_YES;
+      return work_result_push(ws, &(item.unit));
+   }
+   return 0;
+}/* work_cancel */
+
+/*-------------------------------------------------------------------------
+* Local module routine, receives a message from the coordinator and queues its units,
+* or drops the unit a CANCELWORK names (see work_cancel). If block is PX_NO and nothing 
+* has arrived it returns right away. Returns 1 if a message was taken, 0 if nothing was 
+* received, 2 on ENDWORK and < 0 on failure.
+*/
+static int work_recv(WORK_STATE* ws, int block)
+{
+   MPI_Status status;
+   WORK_UNIT oneu;
+   unsigned int k, u, id;
+   int crank = 0, csize = 0, flag = 0, msglen = 0, boffset = 0;
+   long long trecv = 0;
+
+   if(block == PX_NO)
+   {
+      if( MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, ws->incomm, &flag, &status) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Iprobe Failed! :(\n", SRC_FILE, __LINE__, ws->rank);
+         return -1;
+      }
+      if(flag == 0)
+         return 0;
+   }
+   /* Receive a message from the master (ENDWORK may come from another worker), the buffer 
+      is sized per message */
+   if( mpi_recv_packed(MPI_ANY_SOURCE, MPI_ANY_TAG, ws->incomm, &(ws->rmsg), &(ws->rmsgsize), &msglen, &status) < 0)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Recv Failed! :(\n", SRC_FILE, __LINE__, ws->rank);
+      return -1;
+   }
+   if(ws->trace != NULL)
+      trecv = now_tm_nsecs();
+
+   /* Check the tag of the received message. */
+   if (status.MPI_TAG == ENDWORK) 
+   {
+      trace_event(ws->trace, PX_TRACE_RECV, trecv, 0, 0, -1, ENDWORK, 0);
+      if(ws->verbose >= 2)
+         fprintf(ws->verbout, "Rank %d received exit signal\n", ws->rank);
+      /* pass it on to this worker's part of the tree */
+      MPI_Comm_rank(ws->incomm, &crank);
+      MPI_Comm_size(ws->incomm, &csize);
+      if( mpi_endwork_tree(ws->incomm, ws->rankstart, csize - ws->rankstart, crank - ws->rankstart + 1) < 0)
+         return -1;
+      return 2;
+   }
+   if(status.MPI_TAG == CANCELWORK)
+   {
+      if( MPI_Unpack(ws->rmsg, msglen, &boffset, &id, 1, MPI_UNSIGNED, ws->incomm) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : bad cancel message\n", SRC_FILE, __LINE__, ws->rank);
+         return -1;
+      }
+      trace_event(ws->trace, PX_TRACE_RECV, trecv, 0, id, -1, CANCELWORK, 0);
+      return ((work_cancel(ws, id) < 0) ? -1 : 1);
+   }
+   if(status.MPI_TAG == SLOTSWORK)
+   {
+      if( MPI_Unpack(ws->rmsg, msglen, &boffset, &(ws->maxrun), 1, MPI_UNSIGNED, ws->incomm) != MPI_SUCCESS)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : bad slots message\n", SRC_FILE, __LINE__, ws->rank);
+         return -1;
+      }
+      trace_event(ws->trace, PX_TRACE_RECV, trecv, 0, ws->maxrun, -1, SLOTSWORK, 0);
+      if(ws->verbose >= 2)
+         fprintf(ws->verbout, "Rank %d runs up to %u units at once\n", ws->rank, ws->maxrun);
+      return 1;
+   }
+
+   /* a dispatch message carries a batch of one or more units */
+   if( mpi_workmsg_nunits(ws->rmsg, msglen, &boffset, &k) < 0)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : bad work message\n", SRC_FILE, __LINE__, ws->rank);
+      return -1;
+   }
+   trace_event(ws->trace, PX_TRACE_RECV, trecv, 0, k, -1, DOWORK, 0);
+   for(u = 0; u < k; u++)
+   {
+      if( mpi_worku_unserialize(ws->rmsg, msglen, &boffset, &oneu) < 0)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : bad work unit message\n", SRC_FILE, __LINE__, ws->rank);
+         return -1;
+      }
+      if( work_set_exec(&(ws->wtab), &oneu) < 0)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : no executable for exec index %u\n", SRC_FILE, __LINE__, ws->rank, oneu.exec_idx);
+         free(oneu.pargs);
+         return -1;
+      }
+      if( work_queue_push(ws, &oneu, ((u == (k - 1)) ? PX_YES : PX_NO)) < 0)
+      {
+         free(oneu.pargs);
+         return -1;
+      }
+   }
+   return 1;
+}/* work_recv */
+
+/*-------------------------------------------------------------------------
+* Local module routine, reports the finished units to the coordinator, up to 
+* PX_REPORT_MAX of them, the rest are kept for the next report. The send is
+* nonblocking so the worker can go on to a prefetched unit right away.
+*/
+static int work_report(WORK_STATE* ws)
+{
+   MPI_Status status;
+   long long now;
+   unsigned int u, k;
+   int boffset = 0;
+
+   if(ws->nres == 0)
+      return 0;
+   /* the previous report has to be out before the buffer is reused */
+   if( MPI_Wait(&(ws->sendreq), &status) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Wait Failed! :(\n", SRC_FILE, __LINE__, ws->rank);
+      return -1;
+   }
+   /* the coordinator's receive for this worker holds PX_REPORT_MAX units */
+   k = (ws->nres < PX_REPORT_MAX) ? ws->nres : PX_REPORT_MAX;
+   now = now_tm_nsecs();
+   for(u = 0; u < k; u++)
+   {
+      ws->res[u].tm.treport = now;
+      ws->resp[u] = &(ws->res[u]);
+   }
+   if( grow_msgbuf(&(ws->smsg), &(ws->smsgsize), mpi_sizeof_workmsg(ws->resp, k)) < 0)
+      return -1;
+   if( mpi_workmsg_serialize(ws->resp, k, ws->smsg, ws->smsgsize, &boffset) < 0)
+      return -1;
+   if( MPI_Isend(ws->smsg, boffset, MPI_PACKED, 0, COMPLETED_WORK, ws->comm, &(ws->sendreq)) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Isend Failed! :(\n", SRC_FILE, __LINE__, ws->rank);
+      return -1;
+   }
+   trace_event(ws->trace, PX_TRACE_REPORT, now, 0, k, -1, COMPLETED_WORK, 0);
+   memmove(ws->res, &(ws->res[k]), (ws->nres - k) * sizeof(WORK_UNIT));
+   ws->nres -= k;
+   return 0;
+}/* work_report */
+
+/*-------------------------------------------------------------------------
+* Local module routine, records the outcome of the unit in slot s, pstat is 
+* its wait status, and keeps it for the next report. The args are released 
+* since the coordinator already has them.
+*/
+static int work_finish(WORK_STATE* ws, WORK_SLOT* s, int pstat)
+{
+   /* timed here since a unit may wait in a batch before it runs */
+   s->unit.tm.texit = now_tm_nsecs();
+   s->unit.ru.wall_ms = (unsigned int)((s->unit.tm.texit / 1000000LL) - s->tstart);
+   s->unit.proc_secs = (long)(s->unit.ru.wall_ms / 1000U);
+   s->unit.was_killed = s->killed;
+#ifdef HAVE_SYS_WAIT_H
+   s->unit.exit_code = WIFEXITED(pstat) ? WEXITSTATUS(pstat) : -1;
+   s->unit.term_sig = WIFSIGNALED(pstat) ? WTERMSIG(pstat) : 0;
+#else
+   s->unit.exit_code = ((pstat & 0x7f) == 0) ? ((pstat >> 8) & 0xff) : -1;
+   s->unit.term_sig = pstat & 0x7f;
+#endif
+   if(s->pidfd >= 0)
+   {
+      close(s->pidfd);
+      s->pidfd = -1;
+   }
+   trace_event(ws->trace, PX_TRACE_RUN, s->unit.tm.tstart, s->unit.tm.texit - s->unit.tm.tstart, s->unit.id_tag, s->unit.was_killed, 
+               ((s->unit.term_sig != 0) ? -(s->unit.term_sig) : s->unit.exit_code), (unsigned int)(s - ws->slots));
+   /* future TODO: set anything else that matters here that may need to be sent back */
+
+   /* the coordinator has the args and path so don't send them back */
+   free(s->unit.pargs);
+   s->unit.pargs = NULL;
+   s->unit.procpath = NULL;
+   if(s->batch_end == PX_YES)
+      ws->report_due = PX_YES;
+   s->pid = 0;
+   ws->nrun -= 1;
+   return work_result_push(ws, &(s->unit));
+}/* work_finish */
+
+/*-------------------------------------------------------------------------
+* Local module routine, sets up the launch limiter. The first launch is after 
+* the -r wait plus a share of the launch interval spread over the ranks (the 
+* golden ratio sequence), so the workers do not all start at once.
+*/
+static void work_launch_init(WORK_STATE* ws, WORK_PARAMS* wparams)
+{
+   double phase;
+
+   ws->tlaunch = 0.0;
+   ws->launchmsecs = (wparams->launchrate > 0.0) ? (1000.0 / wparams->launchrate) : 0.0;
+   if( (ws->launchmsecs <= 0.0) && (wparams->startmsecs == 0) )
+      return;
+   phase = (double)ws->rank * 0.6180339887;
+   phase -= (double)((long long)phase);
+   ws->tlaunch = (double)now_tm_msecs() + (double)wparams->startmsecs + (phase * ws->launchmsecs) + 1.0;
+   if(ws->verbose >= 3)
+      fprintf(ws->verbout, "Rank %d first launch in %.3f secs (launch rate %.3f per sec)\n", ws->rank, 
+              (ws->tlaunch - (double)now_tm_msecs()) / 1000.0, wparams->launchrate);
+}/* work_launch_init */
+
+/*-------------------------------------------------------------------------
+* Local module routine, adds the child in slot s to the worker's epoll set so 
+* work_wait wakes as soon as it exits. Without pidfds (an older kernel) the 
+* worker goes back to waiting on SIGCHLD for all of its children.
+*/
+static void work_watch(WORK_STATE* ws, WORK_SLOT* s)
+{
+#ifdef PX_PIDFD
+   struct epoll_event ev;
+   unsigned int u;
+
+   if(ws->epfd < 0)
+      return;
+   memset(&ev, 0, sizeof(struct epoll_event));
+   ev.events = EPOLLIN;
+   ev.data.u32 = (unsigned int)(s - ws->slots);
+   if( ((s->pidfd = (int) syscall(SYS_pidfd_open, s->pid, 0)) >= 0) && (epoll_ctl(ws->epfd, EPOLL_CTL_ADD, s->pidfd, &ev) == 0) )
+      return;
+   if(ws->verbose >= 2)
+      fprintf(ws->verbout, "Rank %d has no pidfds (%s), waiting on SIGCHLD\n", ws->rank, strerror(errno));
+   for(u = 0; u < ws->nslots; u++)
+   {
+      if( (ws->slots[u].pid > 0) && (ws->slots[u].pidfd >= 0) )
+      {
+         close(ws->slots[u].pidfd);
+         ws->slots[u].pidfd = -1;
+      }
+   }
+   close(ws->epfd);
+   ws->epfd = -1;
+#endif
+}/* work_watch */
+
+/*-------------------------------------------------------------------------
+* Local module routine, starts the unit at the head of the queue in a free slot
+*/
+static int work_start(WORK_STATE* ws)
+{
+   WORK_SLOT* s = NULL;
+   WORK_UNIT* oneu;
+   char* nbuf;
+   double now;
+   unsigned int u, maxumsecs;
+   int need;
+#ifndef PX_CHILD_SLOTS
+   int pstat;
+#endif
+
+   if(ws->nrun >= WORK_NRUNMAX(ws))
+      return 0;
+   for(u = 0; (u < ws->nslots) && (s == NULL); u++)
+   {
+      if(ws->slots[u].pid == 0)
+         s = &(ws->slots[u]);
+   }
+   if( (s == NULL) || (ws->qlen == 0) )
+      return 0;
+   /* a token bucket that holds one start, the queued units wait here rather than the 
+      coordinator sleeping, and the worker goes on taking in work meanwhile */
+   if(ws->tlaunch > 0.0)
+   {
+      if( (now = (double) now_tm_msecs()) < ws->tlaunch)
+         return 0;
+      if(ws->launchmsecs <= 0.0)
+         ws->tlaunch = 0.0;
+      else
+         ws->tlaunch = ((now - ws->tlaunch) < ws->launchmsecs) ? (ws->tlaunch + ws->launchmsecs) : (now + ws->launchmsecs);
+   }
+   s->unit = ws->q[ws->qhead].unit;
+   s->batch_end = ws->q[ws->qhead].batch_end;
+   ws->qhead = (ws->qhead + 1) % ws->qcap;
+   ws->qlen -= 1;
+   oneu = &(s->unit);
+   maxumsecs = (oneu->maxumsecs > 0) ? oneu->maxumsecs : ws->maxumsecs;
+
+   need = (int)strlen(oneu->procpath) + ((oneu->pargs != NULL) ? (int)strlen(oneu->pargs) : 0) + 2;
+   if(need > ws->cmdsize)
+   {
+      if( (nbuf = (char*) realloc(ws->cmdbuf, need)) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : realloc failed : %s\n", SRC_FILE, __LINE__, ws->rank, strerror(errno));
+         free(oneu->pargs);
+         return -1;
+      }
+      ws->cmdbuf = nbuf;
+      ws->cmdsize = need;
+   }
+   snprintf(ws->cmdbuf, ws->cmdsize, "%s %s", oneu->procpath, ((oneu->pargs != NULL) ? oneu->pargs : "")); 
+   if(ws->verbose == 2)
+      fprintf(ws->verbout, "Rank %d received \"%s\" \"%s\"\n", ws->rank, oneu->procpath, ((oneu->pargs != NULL) ? oneu->pargs : ""));
+   else if(ws->verbose >= 3)
+   {
+      fprintf(ws->verbout, "Rank %d received WORK UNIT: ", ws->rank);
+      fprint_worku(ws->verbout, oneu);
+      if(maxumsecs > 0)
+         fprintf(ws->verbout, "Rank %d running \"%s\" (max runtime %.3f, slot %u)\n", ws->rank, ws->cmdbuf, maxumsecs / 1000.0, (unsigned int)(s - ws->slots));
+      else
+         fprintf(ws->verbout, "Rank %d running \"%s\" (slot %u)\n", ws->rank, ws->cmdbuf, (unsigned int)(s - ws->slots));
+   }
+
+   /*-------------------------------*/
+   /* send to program/script        */
+   /*-------------------------------*/
+   s->unit.tm.tstart = now_tm_nsecs();
+   s->tstart = s->unit.tm.tstart / 1000000LL;
+   s->tkill = (maxumsecs > 0) ? (s->tstart + (long long)maxumsecs) : 0;
+   s->killed = PX_NO;
+   s->hardkill = PX_NO;
+   s->reaped = PX_NO;
+   s->pidfd = -1;
+   memset(&(s->unit.ru), 0, sizeof(WORK_RUSAGE));
+   ws->nrun += 1;
+#ifdef PX_CHILD_SLOTS
+   if(ws->noshell == PX_YES)
+   {
+      /* the program gets the words as its args, no shell in between */
+      if( split_args(ws->cmdbuf, &(ws->argv), &(ws->argvcap)) > 0)
+         s->pid = xpspawn(NULL, ws->argv, &(ws->childmask), ws->nullin);
+   }
+   else
+      s->pid = xpspawn(ws->cmdbuf, NULL, &(ws->childmask), ws->nullin);
+   if(s->pid > 0)
+   {
+      work_watch(ws, s);
+      return 1;
+   }
+#else
+   /* no signals, the command runs here and now */
+   s->pid = 1;
+   if( (pstat = xpopen(ws->cmdbuf, &(s->unit.ru), ws->verbose, ws->verbout)) >= 0)
+      return ((work_finish(ws, s, pstat) < 0) ? -1 : 1);
+#endif
+   fprintf(stderr, "%s @L %d RANK %d : Command \"%s\" failed to start\n", SRC_FILE, __LINE__, ws->rank, ws->cmdbuf);
+   return ((work_finish(ws, s, PX_WSTAT_NOSTART) < 0) ? -1 : 1);
+}/* work_start */
+
+/*-------------------------------------------------------------------------
+* Local module routine, reaps the children that have exited without waiting 
+* and stops the ones past their time limit (the whole process group), with 
+* SIGTERM and gracemsecs later SIGKILL (right away if gracemsecs is 0).
+* Returns the number of units finished, < 0 on failure.
+*/
+static int work_reap(WORK_STATE* ws)
+{
+   int nfin = 0;
+#ifdef PX_CHILD_SLOTS
+   WORK_SLOT* s;
+   pid_t pid;
+   unsigned int u;
+   int pstat;
+   long long now;
+#ifdef PX_RUSAGE
+   struct rusage ru;
+#endif
+
+   while(ws->nrun > 0)
+   {
+#ifdef PX_RUSAGE
+      if( (pid = wait4(-1, &pstat, WNOHANG, &ru)) == 0)
+#else
+      if( (pid = waitpid(-1, &pstat, WNOHANG)) == 0)
+#endif
+         break;
+      if(pid < 0)
+      {
+         if(errno == EINTR)
+            continue;
+         if(errno == ECHILD) /* only stopped groups left, see below */
+            break;
+         fprintf(stderr, "\"%s\" @L %d RANK %d : waitpid failed : %s\n", SRC_FILE, __LINE__, ws->rank, strerror(errno));
+         return -1;
+      }
+      for(u = 0; u < ws->nslots; u++)
+      {
+         s = &(ws->slots[u]);
+         if( (s->pid == pid) && (s->reaped == PX_NO) )
+         {
+#ifdef PX_RUSAGE
+            work_usage(&(s->unit.ru), &ru, NULL);
+#endif
+            /* the rest of a stopped unit's group may still be cleaning up */
+            if( (s->killed == PX_YES) && (s->hardkill == PX_NO) )
+            {
+               s->reaped = PX_YES;
+               s->pstat = pstat;
+               if(s->pidfd >= 0)
+               {
+                  close(s->pidfd);
+                  s->pidfd = -1;
+               }
+               break;
+            }
+            if( work_finish(ws, s, pstat) < 0)
+               return -1;
+            nfin++;
+            break;
+         }
+      }
+   }
+
+   now = now_tm_msecs();
+   for(u = 0; u < ws->nslots; u++)
+   {
+      s = &(ws->slots[u]);
+      if(s->pid <= 0)
+         continue;
+      if(s->reaped == PX_YES)
+      {
+         if( (s->tkill > 0) && (now < s->tkill) && (kill(-(s->pid), 0) == 0) )
+            continue;
+         kill(-(s->pid), SIGKILL);
+         if( work_finish(ws, s, s->pstat) < 0)
+            return -1;
+         nfin++;
+         continue;
+      }
+      if( (s->tkill == 0) || (now < s->tkill) )
+         continue;
+      if( (s->killed == PX_NO) && (ws->gracemsecs > 0) )
+      {
+         if(ws->verbose >= 2)
+            fprintf(ws->verbout, "Rank %d stopping unit %u (slot %u), over %.3f seconds\n", ws->rank, s->unit.id_tag, u, (now - s->tstart) / 1000.0);
+         kill(-(s->pid), SIGTERM);
+         s->tkill = now + (long long)ws->gracemsecs;
+      }
+      else
+      {
+         if(ws->verbose >= 2)
+            fprintf(ws->verbout, "Rank %d killing unit %u (slot %u), over %.3f seconds\n", ws->rank, s->unit.id_tag, u, (now - s->tstart) / 1000.0);
+         kill(-(s->pid), SIGKILL); /* this should kill the whole group under the worker */
+         s->hardkill = PX_YES;
+         s->tkill = 0;
+      }
+      s->killed = PX_YES;
+   }
+#endif
+   return nfin;
+}/* work_reap */
+
+/*-------------------------------------------------------------------------
+* Local module routine, waits up to PX_SLOT_POLL_MSECS, and no later than the 
+* next time limit or launch, for a child to exit
+*/
+static void work_wait(WORK_STATE* ws)
+{
+#ifdef PX_CHILD_SLOTS
+   struct timespec ts;
+ #ifdef PX_PIDFD
+   struct epoll_event evs[8];
+ #endif
+   long long now, left;
+   unsigned int u;
+   int msecs = PX_SLOT_POLL_MSECS;
+
+   now = now_tm_msecs();
+   for(u = 0; u < ws->nslots; u++)
+   {
+      if( (ws->slots[u].pid > 0) && (ws->slots[u].tkill > 0) && ((left = ws->slots[u].tkill - now) < (long long)msecs) )
+         msecs = (left > 0) ? (int)left : 0;
+   }
+   /* or the next launch for a unit held back with a slot free */
+   if( (ws->tlaunch > 0.0) && (ws->qlen > 0) && (ws->nrun < WORK_NRUNMAX(ws)) && 
+       ((left = (long long)(ws->tlaunch - (double)now) + 1) < (long long)msecs) )
+      msecs = (left > 0) ? (int)left : 0;
+ #ifdef PX_PIDFD
+   if(ws->epfd >= 0)
+   {
+      epoll_wait(ws->epfd, evs, 8, msecs);
+      return;
+   }
+ #endif
+   ts.tv_sec = 0;
+   ts.tv_nsec = (long)msecs * 1000000L;
+ #ifdef HAVE_SIGTIMEDWAIT
+   sigtimedwait(&(ws->waitmask), NULL, &ts);
+ #elif defined(HAVE_NANOSLEEP)
+   nanosleep(&ts, NULL);
+ #endif
+#endif
+}/* work_wait */
+
+/*-------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int work_proc( MPI_Comm comm, int rank, const char* proc, WORK_PARAMS* wparams, 
+               unsigned int verbose, FILE* verbout )
+{
+   MPI_Status status;
+   const unsigned int maxwork = PXMAXARGS; 
+   unsigned int i = 0;
+   int rc;
+   WORK_STATE ws;
+   
+   memset(&ws, 0, sizeof(WORK_STATE));
+   ws.epfd = -1;
+   ws.rank = rank;
+   ws.comm = comm;
+   ws.incomm = (wparams->incomm != MPI_COMM_NULL) ? wparams->incomm : comm;
+   ws.rankstart = wparams->rankstart;
+   ws.sendreq = MPI_REQUEST_NULL;
+   ws.nslots = (wparams->nslots > 0) ? wparams->nslots : 1;
+   ws.maxumsecs = wparams->maxumsecs;
+   ws.gracemsecs = wparams->gracemsecs;
+   ws.noshell = wparams->noshell;
+   ws.nullin = wparams->nullin;
+   ws.trace = wparams->trace;
+   ws.verbose = verbose;
+   ws.verbout = verbout;
+   work_launch_init(&ws, wparams);
+
+   /* entry 0 is the broadcast program, the rest arrive with the first unit that uses them */
+   if( exec_table_init(&(ws.wtab), proc) < 0)
+      return -1;
+   if( (ws.slots = (WORK_SLOT*) calloc(ws.nslots, sizeof(WORK_SLOT))) == NULL)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : calloc failed : %s\n", SRC_FILE, __LINE__, rank, strerror(errno));
+      work_state_free(&ws);
+      return -1;
+   }
+#ifdef PX_CHILD_SLOTS
+   /* hold SIGCHLD so an exiting child wakes work_wait, the children get the old mask back */
+   sigemptyset(&(ws.waitmask));
+   sigaddset(&(ws.waitmask), SIGCHLD);
+   sigprocmask(SIG_BLOCK, &(ws.waitmask), &(ws.childmask));
+#endif
+#ifdef PX_PIDFD
+   /* a pidfd for each child, work_wait falls back to SIGCHLD without one */
+   ws.epfd = epoll_create1(EPOLL_CLOEXEC);
+#endif
+#ifdef PX_SUBREAPER
+   prctl(PR_SET_CHILD_SUBREAPER, 1);
+#endif
+
+   while(i <= maxwork) 
+   {
+      /* only block for work when nothing is queued, running or left to report, otherwise take
+         in what has already arrived so the coordinator's refills of the prefetch queue are drained */
+      while( (rc = work_recv(&ws, (((ws.qlen == 0) && (ws.nrun == 0) && (ws.nres == 0)) ? PX_YES : PX_NO))) == 1)
+         ;
+      if(rc < 0)
+         break;
+      if(rc == 2) 
+      {
+         if( (ws.qlen > 0) || (ws.nrun > 0) )
+            fprintf(stderr, "\"%s\" @L %d RANK %d : WARN exit signal with %u units queued, %u running\n", SRC_FILE, __LINE__, rank, ws.qlen, ws.nrun);
+         rc = 0;
+         break;
+      }
+
+      /* fill the free slots */
+      while( (rc = work_start(&ws)) == 1)
+         i++;
+      if(rc < 0)
+         break;
+
+      /* collect what finished, waiting a little if nothing has yet (or for the next launch) */
+      if( ((rc = work_reap(&ws)) == 0) && ((ws.nrun > 0) || (ws.qlen > 0)) )
+      {
+         work_wait(&ws);
+         rc = work_reap(&ws);
+      }
+      if(rc < 0)
+         break;
+
+      /* report back in one message once a batch's last unit is done, or sooner if
+         slots are idle for lack of queued units */
+      if( (ws.nres > 0) && ((ws.report_due == PX_YES) || ((ws.nrun < WORK_NRUNMAX(&ws)) && (ws.qlen < (WORK_NRUNMAX(&ws) - ws.nrun)))) )
+      {
+         if( (rc = work_report(&ws)) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed! :(\n", SRC_FILE, __LINE__, rank);
+            break;
+         }
+         /* more than one message worth goes out on the next pass */
+         ws.report_due = (ws.nres > 0) ? PX_YES : PX_NO;
+      }
+   }
+
+#ifdef PX_CHILD_SLOTS
+   sigprocmask(SIG_SETMASK, &(ws.childmask), NULL);
+#endif
+   if( MPI_Wait(&(ws.sendreq), &status) != MPI_SUCCESS)
+      fprintf(stderr, "\"%s\" @L %d RANK %d : WARN MPI_Wait Failed! :(\n", SRC_FILE, __LINE__, rank);
+   work_state_free(&ws);
+   return ((rc < 0) ? -1 : 0);
+}/* work_proc */
+
+
+
+/*-------------------------------------------------------------------------
+* Local module routine, moves the units a node leader received from the 
+* coordinator into its dispatch list. The units already sent down are dropped 
+* first, their args were released when they were dispatched.
+*/
+static int lead_take(COORD_STATE* cs, unsigned int* cap, WORK_STATE* ws)
+{
+   WORK_UNIT* nptr;
+   unsigned int ncap;
+
+   if(cs->next > 0)
+   {
+      memmove(cs->wunits, &(cs->wunits[cs->next]), (cs->n - cs->next) * sizeof(WORK_UNIT));
+      cs->n -= cs->next;
+      cs->next = 0;
+   }
+   if( (cs->n + ws->qlen) > *cap)
+   {
+      ncap = (cs->n + ws->qlen) * 2;
+      if( (nptr = (WORK_UNIT*) realloc(cs->wunits, ncap * sizeof(WORK_UNIT))) == NULL)
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : realloc failed : %s\n", SRC_FILE, __LINE__, ws->rank, strerror(errno));
+         return -1;
+      }
+      cs->wunits = nptr;
+      *cap = ncap;
+   }
+   while(ws->qlen > 0)
+   {
+      cs->wunits[cs->n] = ws->q[ws->qhead].unit;
+      cs->n += 1;
+      ws->qhead = (ws->qhead + 1) % ws->qcap;
+      ws->qlen -= 1;
+   }
+   return 0;
+}/* lead_take */
+
+/*-------------------------------------------------------------------------
+* Local module routine, takes a completion message from a local worker and 
+* keeps its units for the next report to the coordinator.
+*/
+static int lead_complete(COORD_STATE* cs, WORK_STATE* ws, WORKER_STATE* w, int msglen)
+{
+   WORK_UNIT oneu; 
+   unsigned int k, u;
+   int boffset = 0;
+   long long t = 0;
+
+   if(cs->trace != NULL)
+      t = now_tm_nsecs();
+   if( mpi_workmsg_nunits(cs->msg, msglen, &boffset, &k) < 0)
+      return -1;
+   for(u = 0; u < k; u++)
+   {
+      if( mpi_worku_unserialize(cs->msg, msglen, &boffset, &oneu) < 0)
+         return -1;
+      free(oneu.pargs); free(oneu.procpath);
+      oneu.pargs = NULL;
+      oneu.procpath = NULL;
+      if( work_result_push(ws, &oneu) < 0)
+         return -1;
+      cs->done += 1;
+      if(cs->verbose >= 3)
+         fprintf(cs->verbout, "Leader rank %d received completed work from node rank[%d] (id=%u)\n", ws->rank, w->rank, oneu.id_tag);
+   }
+   w->inflight = (k < w->inflight) ? (w->inflight - k) : 0;
+   if(cs->trace != NULL)
+      trace_event(cs->trace, PX_TRACE_COMPLETE, t, now_tm_nsecs() - t, k, w->trank, COMPLETED_WORK, 0);
+   return 0;
+}/* lead_complete */
+
+/*-------------------------------------------------------------------------
+* Local module routine, top up the local workers from the leader's dispatch list
+*/
+static int lead_dispatch(COORD_STATE* cs)
+{
+   unsigned int u;
+   int j, k;
+
+   for(j = 0; (j < cs->nworkers) && (cs->next < cs->n); j++)
+   {
+      while( (k = coord_dispatch(cs, &(cs->workers[j]))) > 0)
+      {
+         /* the worker reports by id, the args are not needed here anymore */
+         for(u = cs->next - (unsigned int)k; u < cs->next; u++)
+         {
+            free(cs->wunits[u].pargs);
+            cs->wunits[u].pargs = NULL;
+         }
+      }
+      if(k < 0)
+         return -1;
+   }
+   return 0;
+}/* lead_dispatch */
+
+/*-------------------------------------------------------------------------
+* Local module routine, the node is to run n units at once (SLOTSWORK), the local 
+* workers are given slots in order and the rest get none until it grows again
+*/
+static void lead_resize(COORD_STATE* cs, unsigned int n)
+{
+   int j;
+
+   cs->nslots = 0;
+   for(j = 0; j < cs->nworkers; j++)
+   {
+      cs->workers[j].slots = (n < cs->sparams->wslots) ? n : cs->sparams->wslots;
+      n -= cs->workers[j].slots;
+      cs->nslots += cs->workers[j].slots;
+   }
+}/* lead_resize */
+
+/*-------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int subcoord_proc( MPI_Comm upcomm, MPI_Comm nodecomm, int rank, const char* proc, 
+                   SCHED_PARAMS* sparams, unsigned int verbose, FILE* verbout )
+{
+   MPI_Status status;
+   COORD_STATE cs;
+   WORK_STATE ws;
+   SCHED_STATS lstats;
+   unsigned int ucap = 0, taken = 0, nodeslots;
+   int j, rc, nsize = 0, flag = 0, busy, endwork = PX_NO, msglen = 0;
+#ifdef HAVE_NANOSLEEP 
+   struct timespec nanoreq;
+
+   memset(&nanoreq, 0, sizeof(struct timespec));
+   nanoreq.tv_nsec = 100000; /* idle poll, 0.1 ms */
+#endif
+
+   memset(&ws, 0, sizeof(WORK_STATE));
+   ws.epfd = -1;
+   memset(&cs, 0, sizeof(COORD_STATE));
+   memset(&lstats, 0, sizeof(SCHED_STATS));
+
+   /* toward the coordinator the leader is a worker ... */
+   ws.rank = rank;
+   ws.comm = upcomm;
+   ws.incomm = upcomm;
+   ws.rankstart = 1;
+   ws.sendreq = MPI_REQUEST_NULL;
+   ws.verbose = verbose;
+   ws.verbout = verbout;
+   if( exec_table_init(&(ws.wtab), proc) < 0)
+      return -1;
+
+   /* ... and toward its node it is a coordinator for node ranks 1 to nsize-1 */
+   MPI_Comm_size(nodecomm, &nsize);
+   cs.etab = &(ws.wtab);
+   /* the leader's list is not a window, ids index it directly */
+   cs.wcap = UINT_MAX;
+   cs.comm = nodecomm;
+   cs.dcomm = nodecomm;
+   cs.poll = PX_NO;
+   cs.nworkers = nsize - 1;
+   cs.rankstart = 1;
+   cs.sparams = sparams;
+   cs.sstats = &lstats;
+   cs.moncomm = MPI_COMM_NULL;
+   cs.trace = sparams->trace;
+   ws.trace = sparams->trace;
+   cs.verbose = verbose;
+   cs.verbout = verbout;
+   if(sparams->chunkmax < 1)
+      sparams->chunkmax = 1;
+   if(sparams->depth < 1)
+      sparams->depth = 1;
+   if(sparams->wslots < 1)
+      sparams->wslots = 1;
+   cs.workers = (WORKER_STATE*) calloc(cs.nworkers, sizeof(WORKER_STATE));
+   cs.sendu = (WORK_UNIT*) calloc(sparams->chunkmax * sparams->wslots, sizeof(WORK_UNIT));
+   cs.sendp = (WORK_UNIT**) calloc(sparams->chunkmax * sparams->wslots, sizeof(WORK_UNIT*));
+   if( (cs.nworkers < 1) || (cs.workers == NULL) || (cs.sendu == NULL) || (cs.sendp == NULL) )
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : node leader set up failed (%d local workers)\n", SRC_FILE, __LINE__, rank, cs.nworkers);
+      coord_state_free(&cs);
+      work_state_free(&ws);
+      return -1;
+   }
+   for(j = 0; j < cs.nworkers; j++)
+   {
+      cs.workers[j].rank = j + 1;
+      cs.workers[j].known = 1ULL;
+      cs.workers[j].slots = sparams->wslots;
+   }
+   cs.nslots = (unsigned int)cs.nworkers * sparams->wslots;
+   nodeslots = cs.nslots;
+   if( coord_trace_ranks(&cs) < 0)
+   {
+      coord_state_free(&cs);
+      work_state_free(&ws);
+      return -1;
+   }
+
+   if(verbose >= 2)
+      fprintf(verbout, "NODE LEADER RANK %d, %d LOCAL WORKERS\n", rank, cs.nworkers);
+
+   /* the leader has two sides to listen on so it polls, backing off briefly when idle */
+   while( (endwork == PX_NO) || (cs.done < taken) )
+   {
+      busy = PX_NO;
+
+      /* new batches from the coordinator */
+      while( (rc = work_recv(&ws, PX_NO)) == 1)
+      {
+         taken += ws.qlen;
+         if( lead_take(&cs, &ucap, &ws) < 0)
+            rc = -1;
+         busy = PX_YES;
+      }
+      if(rc < 0)
+         break;
+      if(rc == 2)
+         endwork = PX_YES;
+      /* the coordinator changed the units the node runs at once (--control) */
+      if( (ws.maxrun > 0) && (ws.maxrun != nodeslots) )
+      {
+         lead_resize(&cs, ws.maxrun);
+         nodeslots = ws.maxrun;
+         busy = PX_YES;
+      }
+
+      /* completions from the node */
+      for(;;)
+      {
+         if( (rc = MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, nodecomm, &flag, &status)) != MPI_SUCCESS)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Iprobe Failed! :(\n", SRC_FILE, __LINE__, rank);
+            rc = -1;
+            break;
+         }
+         if(flag == 0)
+            break;
+         if( (rc = mpi_recv_packed(status.MPI_SOURCE, status.MPI_TAG, nodecomm, &(cs.msg), &(cs.msgsize), &msglen, &status)) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Recv Failed! :(\n", SRC_FILE, __LINE__, rank);
+            break;
+         }
+         if( (status.MPI_SOURCE < 1) || (status.MPI_SOURCE >= nsize) )
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : unexpected message from node rank[%d]\n", SRC_FILE, __LINE__, rank, status.MPI_SOURCE);
+            rc = -1;
+            break;
+         }
+         if( (rc = lead_complete(&cs, &ws, &(cs.workers[status.MPI_SOURCE - 1]), msglen)) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : bad completion message from node rank[%d]\n", SRC_FILE, __LINE__, rank, status.MPI_SOURCE);
+            break;
+         }
+         busy = PX_YES;
+      }
+      if(rc != 0)
+         break;
+
+      /* keep the node busy */
+      if( (busy == PX_YES) && (lead_dispatch(&cs) < 0) )
+      {
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Isend Failed! :(\n", SRC_FILE, __LINE__, rank);
+         rc = -1;
+         break;
+      }
+      /* then pass what finished up, PX_REPORT_MAX units a message */
+      if(ws.nres > 0)
+      {
+         if( work_report(&ws) < 0)
+         {
+            fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed! :(\n", SRC_FILE, __LINE__, rank);
+            rc = -1;
+            break;
+         }
+         busy = PX_YES;
+      }
+#ifdef HAVE_NANOSLEEP 
+      if(busy == PX_NO)
+         nanosleep(&nanoreq, NULL);
+#endif
+   }
+
+   if(rc >= 0)
    {
-      if(verbose >= 2) 
-         fprintf(verbout, "COORDNTR WRLD Rank %d, NOTIFYING MONITOR[Rank %d] of the number of units (%u)\n", mrank, mnrank, n);
-      
-      if( MPI_Isend(&n, 1, MPI_UNSIGNED, mnrank, UNIT_TAG, moncomm, &req) != MPI_SUCCESS)
+      /* tell the node we're done */
+      if(cs.trace != NULL)
+         trace_event(cs.trace, PX_TRACE_CONTROL, now_tm_nsecs(), 0, 0, -1, ENDWORK, 0);
+      if( (coord_senddrain(&cs) < 0) || (mpi_endwork_tree(nodecomm, 1, cs.nworkers, 0) < 0) )
       {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_ISend Failed to monitor via sub comm.\n", SRC_FILE, __LINE__, mrank);
-         return -1;
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed! :(\n", SRC_FILE, __LINE__, rank);
+         rc = -1;
       }
+      if( MPI_Wait(&(ws.sendreq), &status) != MPI_SUCCESS)
+         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN MPI_Wait Failed! :(\n", SRC_FILE, __LINE__, rank);
    }
+   for(; cs.next < cs.n; cs.next++)
+      free(cs.wunits[cs.next].pargs);
+   free(cs.wunits);
+   coord_state_free(&cs);
+   work_state_free(&ws);
+   return ((rc < 0) ? -1 : 0);
+}/* subcoord_proc */
 
-   bfsize = mpi_sizeof_worku();
-   if( (mastmsg = (unsigned char*) malloc(bfsize)) == NULL)
+/*-------------------------------------------------------------------------
+* Local module routine, exposes an array of rank 0 in an RMA window, the 
+* other ranks expose nothing.
+*/
+static int rma_win(RMA_SCHED* rs, void* base, size_t nelem, int esize, MPI_Win* win)
+{
+   if(rs->rank != 0)
+   {
+      base = NULL;
+      nelem = 0;
+   }
+   if( MPI_Win_create(base, (MPI_Aint)(nelem * (size_t)esize), esize, MPI_INFO_NULL, rs->comm, win) != MPI_SUCCESS)
    {
-      fprintf(stderr, "\"%s\" @L %d RANK %d : malloc failed : %s\n", SRC_FILE, __LINE__, mrank, strerror(errno));
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Win_create Failed! :(\n", SRC_FILE, __LINE__, rs->rank);
+      *win = MPI_WIN_NULL;
       return -1;
    }
-   srand( (unsigned int) now_tm_secs() );
+   return 0;
+}/* rma_win */
+
+/*-------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int rma_sched_open( RMA_SCHED* rsched, MPI_Comm comm, int rank, WORK_STORE* wstore, 
+                    EXEC_TABLE* etab, const char* fname )
+{
+   unsigned int hdr[2] = {0, 0};
+   unsigned int i, plen = 0;
+   int rc = 0;
+
+   memset(rsched, 0, sizeof(RMA_SCHED));
+   rsched->comm = comm;
+   rsched->rank = rank;
+   rsched->swin = rsched->offswin = rsched->lenswin = rsched->execwin = MPI_WIN_NULL;
+   rsched->msecswin = rsched->rankwin = rsched->killwin = rsched->exitwin = MPI_WIN_NULL;
 
-   /* Do initial divvy */
-   for(i = 0, j = rankstart; (i < nworkers) && (i < n); i++, j++)
+   /* the unit count and the exec table rank 0 built while indexing */
+   if(rank == 0)
    {
-      wunits[i].resrank = j;
-      strcpy(wunits[i].procpath, proc);
-      set_work_tm_secs(&(wunits[i]));
-      mpi_worku_serialize(&(wunits[i]), mastmsg, bfsize);
-         
-      if(verbose >= 2)
-         fprintf(verbout, "Sending \"%s\" to rank[%d]\n", wunits[i].procpath, wunits[i].resrank);
-                     
-      if( (randstart >= 0) && (randend >= 0) )
-      {
-         waitfor = rand() % (randend - randstart + 1) + randstart;
-         if(verbose >= 3)
-            fprintf(verbout, "Wait for %d secs on sending \"%s\" to rank[%d]\n", waitfor, wunits[i].procpath, wunits[i].resrank);
-#ifdef HAVE_NANOSLEEP 
-         nanoreq.tv_sec = (time_t) waitfor; 
-         nanosleep(&nanoreq, NULL);
-#else
-         sleep(waitfor);
-#endif
-      }
-   
-      if( MPI_Send(mastmsg, bfsize, MPI_PACKED, j, DOWORK, MPI_COMM_WORLD) != MPI_SUCCESS)
+      hdr[0] = wstore->n;
+      hdr[1] = etab->n;
+   }
+   if( MPI_Bcast(hdr, 2, MPI_UNSIGNED, 0, comm) != MPI_SUCCESS)
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Bcast Failed! :(\n", SRC_FILE, __LINE__, rank);
+      return -1;
+   }
+   rsched->n = hdr[0];
+   for(i = 0; (i < hdr[1]) && (i < PXEXECMAX); i++)
+   {
+      if(rank == 0)
+         plen = (unsigned int) strlen(etab->paths[i]) + 1;
+      if( MPI_Bcast(&plen, 1, MPI_UNSIGNED, 0, comm) != MPI_SUCCESS)
+         rc = -1;
+      else if( (rsched->etab.paths[i] = (char*) calloc(plen, sizeof(char))) == NULL)
+         rc = -1;
+      else if(rank == 0)
+         memcpy(rsched->etab.paths[i], etab->paths[i], plen);
+      if( (rc < 0) || (MPI_Bcast(rsched->etab.paths[i], (int)plen, MPI_CHAR, 0, comm) != MPI_SUCCESS) )
       {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed! :(\n", SRC_FILE, __LINE__, mrank);
+         fprintf(stderr, "\"%s\" @L %d RANK %d : failed to share the exec table\n", SRC_FILE, __LINE__, rank);
+         rma_sched_close(rsched);
          return -1;
       }
+      rsched->etab.n = i + 1;
    }
 
-   /* Go until we're done (i starts from above i end) */
-   for(recvd = 0; i < n; i++)
+   /* the counter can overrun n by a claim per worker */
+   if(rsched->n > (UINT_MAX / 2))
    {
-      /* anybody finished? */
-      if( MPI_Recv(mastmsg, bfsize, MPI_PACKED, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status) != MPI_SUCCESS)
-      {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Recv Failed! :(\n", SRC_FILE, __LINE__, mrank);
-         return -1;
-      }
-      else
-         recvd += 1;
+      fprintf(stderr, "\"%s\" @L %d RANK %d : too many units (%u) for RMA scheduling\n", SRC_FILE, __LINE__, rank, rsched->n);
+      return -1;
+   }
+   rsched->nwords = (rsched->n + 31) / 32;
+   if( (rank == 0) && ((rsched->sched = (unsigned int*) calloc(rsched->nwords + 1, sizeof(unsigned int))) == NULL) )
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : calloc failed : %s\n", SRC_FILE, __LINE__, rank, strerror(errno));
+      return -1;
+   }
+   if( (rma_win(rsched, rsched->sched, rsched->nwords + 1, (int)sizeof(unsigned int), &(rsched->swin)) < 0) ||
+       (rma_win(rsched, ((wstore != NULL) ? wstore->offs : NULL), rsched->n, (int)sizeof(size_t), &(rsched->offswin)) < 0) ||
+       (rma_win(rsched, ((wstore != NULL) ? wstore->lens : NULL), rsched->n, (int)sizeof(unsigned int), &(rsched->lenswin)) < 0) ||
+       (rma_win(rsched, ((wstore != NULL) ? wstore->exec_idx : NULL), rsched->n, (int)sizeof(unsigned char), &(rsched->execwin)) < 0) ||
+       (rma_win(rsched, ((wstore != NULL) ? wstore->proc_msecs : NULL), rsched->n, (int)sizeof(unsigned int), &(rsched->msecswin)) < 0) ||
+       (rma_win(rsched, ((wstore != NULL) ? wstore->resrank : NULL), rsched->n, (int)sizeof(int), &(rsched->rankwin)) < 0) ||
+       (rma_win(rsched, ((wstore != NULL) ? wstore->was_killed : NULL), rsched->n, (int)sizeof(unsigned char), &(rsched->killwin)) < 0) ||
+       (rma_win(rsched, ((wstore != NULL) ? wstore->exitstat : NULL), rsched->n, (int)sizeof(int), &(rsched->exitwin)) < 0) )
+   {
+      rma_sched_close(rsched);
+      return -1;
+   }
+
+   /* each worker reads the args of its units from its own map */
+   if( (fname != NULL) && (work_store_map(&(rsched->wmap), fname) < 0) )
+   {
+      rma_sched_close(rsched);
+      return -1;
+   }
+   return 0;
+}/* rma_sched_open */
 
-      mpi_worku_unserialize(mastmsg, bfsize, &oneu);
-      wunits[oneu.id_tag].proc_secs = now_tm_secs() - oneu.proc_secs; 
-      wunits[oneu.id_tag].was_killed = oneu.was_killed;
+/*-------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void rma_sched_close(RMA_SCHED* rsched)
+{
+   MPI_Win* wins[8];
+   int i;
 
-      /* future TODO: reset anything else that matters here */
+   wins[0] = &(rsched->swin);
+   wins[1] = &(rsched->offswin);
+   wins[2] = &(rsched->lenswin);
+   wins[3] = &(rsched->execwin);
+   wins[4] = &(rsched->msecswin);
+   wins[5] = &(rsched->rankwin);
+   wins[6] = &(rsched->killwin);
+   wins[7] = &(rsched->exitwin);
+   for(i = 0; i < 8; i++)
+   {
+      if(*(wins[i]) != MPI_WIN_NULL)
+         MPI_Win_free(wins[i]);
+   }
+   free(rsched->sched);
+   rsched->sched = NULL;
+   work_store_close(&(rsched->wmap));
+   exec_table_free(&(rsched->etab));
+}/* rma_sched_close */
 
-      /* notify monitor of unit completion */
-      if(moncomm != MPI_COMM_NULL) 
-      {
-         if( MPI_Wait(&req, &mstatus) != MPI_SUCCESS)
-            fprintf(stderr, "\"%s\" @L %d RANK %d : WARN MPI_Wait Failed! :(\n", SRC_FILE, __LINE__, mrank);
-         if( MPI_Isend(&oneu.id_tag, 1, MPI_UNSIGNED, mnrank, COMPLETED_WORK, moncomm, &req) != MPI_SUCCESS)
-         {
-            fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_ISend Failed to monitor via sub comm.\n", SRC_FILE, __LINE__, mrank);
-            return -1;
-         }
-      }
-   
-      if(verbose >= 2)
-         fprintf(verbout, "received completed work from rank[%d]\n", status.MPI_SOURCE);
-   
-      /* send out next piece */
-      wunits[i].resrank = status.MPI_SOURCE;
-      strcpy(wunits[i].procpath, proc);
-      set_work_tm_secs(&(wunits[i]));
-      mpi_worku_serialize(&(wunits[i]), mastmsg, bfsize);
-
-      if(verbose >= 2)
-         fprintf(verbout, "Sending \"%s\" to rank[%d]\n", wunits[i].procpath, status.MPI_SOURCE);
-         
-      if( MPI_Send(mastmsg, bfsize, MPI_PACKED, status.MPI_SOURCE, DOWORK, MPI_COMM_WORLD) != MPI_SUCCESS)
-      {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed! :(\n", SRC_FILE, __LINE__, mrank);
-         return -1;
-      }
+/*-------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int rma_coordinate_proc( RMA_SCHED* rsched, WORK_STORE* wstore, MPI_Comm moncomm, int mnrank,
+                         JOURNAL* jrnl, HISTORY* hist, unsigned int verbose, FILE* verbout )
+{
+   MPI_Status mstatus;
+   COORD_STATE cs;
+   unsigned int *cur, *got;
+   unsigned int w, b, bits, id, nmon, lo = 0, done = 0;
+   int rc = 0, flag = 0;
+   double tnext;
+   const int mrank = 0; /* This is fixed to 0 for now */
+
+   /* only the monitor notification of the coordinator state is used */
+   memset(&cs, 0, sizeof(COORD_STATE));
+   cs.monreq = MPI_REQUEST_NULL;
+   cs.moncomm = moncomm;
+   cs.mnrank = mnrank;
+   cs.verbose = verbose;
+   cs.verbout = verbout;
+
+   cur = (unsigned int*) calloc(rsched->nwords + 1, sizeof(unsigned int));
+   got = (unsigned int*) calloc(rsched->nwords + 1, sizeof(unsigned int));
+   if( (cur == NULL) || (got == NULL) )
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : calloc failed : %s\n", SRC_FILE, __LINE__, mrank, strerror(errno));
+      free(cur); free(got);
+      return -1;
    }
-   /* get stragglers */
-   for(i = 0; i < (n-recvd); i++)
+   if(moncomm != MPI_COMM_NULL) 
    {
-      if( MPI_Recv(mastmsg, bfsize, MPI_PACKED, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status) != MPI_SUCCESS)
+      nmon = (wstore->orig != NULL) ? wstore->norig : rsched->n;
+      if(verbose >= 2) 
+         fprintf(verbout, "COORDNTR WRLD Rank %d, NOTIFYING MONITOR[Rank %d] of the number of units (%u)\n", mrank, mnrank, nmon);
+      if( (MPI_Isend(&nmon, 1, MPI_UNSIGNED, mnrank, UNIT_TAG, moncomm, &(cs.monreq)) != MPI_SUCCESS) ||
+          (coord_notify_skipped(&cs, wstore) < 0) )
       {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Recv Failed! (stragglers)\n", SRC_FILE, __LINE__, mrank);
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_ISend Failed to monitor via sub comm.\n", SRC_FILE, __LINE__, mrank);
+         free(cur); free(got);
          return -1;
       }
-         
-      mpi_worku_unserialize(mastmsg, bfsize, &oneu);
-      wunits[oneu.id_tag].proc_secs = now_tm_secs() - oneu.proc_secs; 
-      wunits[oneu.id_tag].was_killed = oneu.was_killed;
-      
-      if(verbose >= 2)
-         fprintf(verbout, "received completed work from straggler rank[%d] (id=%u)\n", status.MPI_SOURCE, oneu.id_tag);
+   }
 
-      /* future TODO: set anything else that matters here */
+   /* the results windows stay locked so they can be synced with each look at the bitmap */
+   if( (MPI_Win_lock_all(0, rsched->swin) != MPI_SUCCESS) || (MPI_Win_lock_all(0, rsched->msecswin) != MPI_SUCCESS) ||
+       (MPI_Win_lock_all(0, rsched->rankwin) != MPI_SUCCESS) || (MPI_Win_lock_all(0, rsched->killwin) != MPI_SUCCESS) ||
+       (MPI_Win_lock_all(0, rsched->exitwin) != MPI_SUCCESS) )
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Win_lock_all Failed! :(\n", SRC_FILE, __LINE__, mrank);
+      free(cur); free(got);
+      return -1;
+   }
+   while(done < rsched->n)
+   {
+      /* the workers' RMA may only move along while rank 0 is in MPI (no progress 
+         thread or RDMA), so rather than sleep rank 0 keeps the MPI progress going */
+      tnext = MPI_Wtime() + (PX_RMA_POLL_MSECS / 1000.0);
+      while(MPI_Wtime() < tnext)
+         MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, rsched->comm, &flag, &mstatus);
 
-      if(moncomm != MPI_COMM_NULL) 
+      /* an atomic read of the bitmap past the words that are all done */
+      if( (MPI_Get_accumulate(NULL, 0, MPI_UNSIGNED, &(cur[lo]), (int)(rsched->nwords - lo), MPI_UNSIGNED, 
+                              0, (MPI_Aint)(lo + 1), (int)(rsched->nwords - lo), MPI_UNSIGNED, MPI_NO_OP, rsched->swin) != MPI_SUCCESS) ||
+          (MPI_Win_flush(0, rsched->swin) != MPI_SUCCESS) )
       {
-         if( MPI_Wait(&req, &mstatus) != MPI_SUCCESS)
-            fprintf(stderr, "\"%s\" @L %d RANK %d : WARN MPI_Wait Failed! :(\n", SRC_FILE, __LINE__, mrank);
-         if( MPI_Isend(&oneu.id_tag, 1, MPI_UNSIGNED, mnrank, COMPLETED_WORK, moncomm, &req) != MPI_SUCCESS)
-         {
-            fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed to monitor via sub comm.\n", SRC_FILE, __LINE__, mrank);
-            return -1;
-         }
+         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Get_accumulate Failed! :(\n", SRC_FILE, __LINE__, mrank);
+         rc = -1;
+         break;
       }
-   }
-   
-   /* tell workers we're done */
-   for(j = rankstart; j < (rankstart+nworkers); j++)
-   {
-      if( MPI_Send(0, 0, MPI_INT, j, ENDWORK, MPI_COMM_WORLD) != MPI_SUCCESS)
+      /* the results were put before their bits were set, make them visible here */
+      MPI_Win_sync(rsched->msecswin); 
+      MPI_Win_sync(rsched->rankwin); 
+      MPI_Win_sync(rsched->killwin);
+      MPI_Win_sync(rsched->exitwin);
+      for(w = lo; (w < rsched->nwords) && (rc == 0); w++)
       {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed! :(\n", SRC_FILE, __LINE__, mrank);
-         return -1;
+         if( (bits = cur[w] & ~(got[w])) == 0)
+            continue;
+         got[w] |= bits;
+         for(b = 0; b < 32; b++)
+         {
+            if( (bits & (1U << b)) == 0)
+               continue;
+            done += 1;
+            id = (w * 32) + b;
+            if( (journal_record(jrnl, WORK_STORE_ORIG(wstore, id), (long)(wstore->proc_msecs[id] / 1000U), wstore->resrank[id], 
+                                (int)wstore->was_killed[id], wstore->exitstat[id]) < 0) || (coord_history(hist, wstore, id) < 0) ||
+                (coord_notify(&cs, WORK_STORE_ORIG(wstore, id)) < 0) )
+            {
+               fprintf(stderr, "\"%s\" @L %d RANK %d : failed to record unit %u\n", SRC_FILE, __LINE__, mrank, id);
+               rc = -1;
+               break;
+            }
+            if(verbose >= 2)
+               fprintf(verbout, "unit %u completed\n", id);
+         }
       }
+      if( (rc < 0) || ((rc = coord_monflush(&cs, PX_NO)) < 0) || ((rc = journal_flush(jrnl, PX_NO)) < 0) )
+         break;
+      while( (lo < rsched->nwords) && (got[lo] == UINT_MAX) )
+         lo++;
    }
-   
+   MPI_Win_unlock_all(rsched->exitwin);
+   MPI_Win_unlock_all(rsched->killwin);
+   MPI_Win_unlock_all(rsched->rankwin);
+   MPI_Win_unlock_all(rsched->msecswin);
+   MPI_Win_unlock_all(rsched->swin);
+   free(cur); free(got);
+   if( (rc == 0) && (verbose >= 1) )
+      fprintf(verbout, "COORDNTR RMA RUN DONE, %u UNITS\n", wstore->n);
+
    /* tell the monitor we're done */
    if(moncomm != MPI_COMM_NULL) 
    {
       fprintf(verbout, "Sending exit to monitor...\n");
-      if( MPI_Wait(&req, &mstatus) != MPI_SUCCESS)
+      if( coord_monflush(&cs, PX_YES) < 0)
+         rc = -1;
+      if( MPI_Wait(&(cs.monreq), &mstatus) != MPI_SUCCESS)
          fprintf(stderr, "\"%s\" @L %d RANK %d : WARN MPI_Wait Failed! :(\n", SRC_FILE, __LINE__, mrank);
-      if( MPI_Isend(0, 0, MPI_UNSIGNED, mnrank, ENDWORK, moncomm, &req) != MPI_SUCCESS)
+      if( MPI_Isend(0, 0, MPI_UNSIGNED, mnrank, ENDWORK, moncomm, &(cs.monreq)) != MPI_SUCCESS)
       {
          fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed to monitor via sub comm.\n", SRC_FILE, __LINE__, mrank);
-         return -1;
+         rc = -1;
       }
    }
-
-   free(mastmsg);
-   return 0;
-}/* coordinate_proc */
+   coord_state_free(&cs);
+   return rc;
+}/* rma_coordinate_proc */
 
 /*-------------------------------------------------------------------------
-* See pxargs.h for details
+* Local module type, a worker's RMA scratch
 */
-int monitor_proc( MPI_Comm coorcomm, int crank, int wrank, 
-                  unsigned int preexit, unsigned char** itemidx, 
-                  unsigned int* ni, unsigned int verbose, 
-                  FILE* verbout )
+typedef struct
 {
-   MPI_Status status;
-   MPI_Request req; 
-   unsigned int curiflg = 0;
-   int per = 0, stp = 0;
-   struct ptparams p;
-   pthread_t pthrd;
-   pthread_attr_t attr;
+   /* the index entries of a claim, cap long */
+   size_t* offs;
+   unsigned int* lens;
+   unsigned char* eidx;
+   unsigned int cap;
+   /* the last claim seen, for the chunk size */
+   unsigned int seen;
+   /* report buffers, run times (msecs) then bitmap words, rescap long each */
+   unsigned int* rbuf;
+   unsigned char* kbuf;
+   int* xbuf;
+   unsigned int rcap;
+} RMA_WORK;
 
-   *ni = 0;
-   *itemidx = NULL;
-   status.MPI_TAG = DOWORK; /* init */
-   p.preexit = preexit; 
-   p.verbose = verbose; 
-   p.verbout = verbout;
+/*-------------------------------------------------------------------------
+* Local module routine, claims the next units from the shared counter for need slots 
+* and queues them. The chunk per slot follows guided self-scheduling from the counter 
+* value this worker last saw. Returns 1 if units were queued, 0 if the counter is past 
+* the last unit and < 0 on failure.
+*/
+static int rma_claim( RMA_SCHED* rs, WORK_STATE* ws, RMA_WORK* rw, SCHED_PARAMS* sparams, 
+                      int nworkers, unsigned int need )
+{
+   WORK_UNIT oneu;
+   unsigned int k, u, remain, start = 0, cnt;
 
-   if(verbose >= 2)
-      fprintf(verbout, "MONITOR WRLD Rank %d, COORDNTR Sub Rank %d\n", wrank, crank);
-   
-   if( (per = pthread_mutex_init(&mtexstop, NULL)) != 0)
-   {   
-      fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_mutex_init Failed (pthrd error %d)\n", SRC_FILE, __LINE__, wrank, per);
-      return -1;
-   }   
-   if( (per = pthread_attr_init(&attr)) != 0)
-   {   
-      fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_attr_init Failed (pthrd error %d)\n", SRC_FILE, __LINE__, wrank, per);
-      return -1;
-   }   
-   if( (per = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED)) != 0)
-   {   
-      fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_attr_setdetachstate Failed (pthrd error %d)\n", SRC_FILE, __LINE__, wrank, per);
-      pthread_attr_destroy(&attr);
-      return -1;
+   remain = (rw->seen < rs->n) ? (rs->n - rw->seen) : 0;
+   k = 1;
+   if(sparams->chunkmax > 1)
+   {
+      k = (unsigned int) ceil( (double)remain / (double)(PX_GSS_FACTOR * (unsigned int)nworkers * ws->nslots * sparams->depth) );
+      if(k < 1)
+         k = 1;
+      if(k > sparams->chunkmax)
+         k = sparams->chunkmax;
    }
-   if( (per = pthread_create(&pthrd, &attr, pbs_poll, (void*) &p)) != 0)
+   k *= need;
+   if(k > rw->cap)
+      k = rw->cap;
+   if( (MPI_Fetch_and_op(&k, &start, MPI_UNSIGNED, 0, 0, MPI_SUM, rs->swin) != MPI_SUCCESS) ||
+       (MPI_Win_flush(0, rs->swin) != MPI_SUCCESS) )
    {
-      fprintf(stderr, "\"%s\" @L %d RANK %d : pthread_create Failed (pthrd error %d)\n", SRC_FILE, __LINE__, wrank, per);
-      pthread_attr_destroy(&attr);
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Fetch_and_op Failed! :(\n", SRC_FILE, __LINE__, ws->rank);
       return -1;
    }
-   pthread_attr_destroy(&attr);
+   if(start >= rs->n)
+      return 0;
+   cnt = ((rs->n - start) < k) ? (rs->n - start) : k;
+   rw->seen = start + cnt;
 
-   /* begin checkpointing and pbs poll loop... */
-   while(status.MPI_TAG != ENDWORK) 
+   /* where the units are in the arg list */
+   if( (MPI_Get(rw->offs, (int)(cnt * sizeof(size_t)), MPI_BYTE, 0, (MPI_Aint)start, (int)(cnt * sizeof(size_t)), MPI_BYTE, rs->offswin) != MPI_SUCCESS) ||
+       (MPI_Get(rw->lens, (int)cnt, MPI_UNSIGNED, 0, (MPI_Aint)start, (int)cnt, MPI_UNSIGNED, rs->lenswin) != MPI_SUCCESS) ||
+       (MPI_Get(rw->eidx, (int)cnt, MPI_UNSIGNED_CHAR, 0, (MPI_Aint)start, (int)cnt, MPI_UNSIGNED_CHAR, rs->execwin) != MPI_SUCCESS) ||
+       (MPI_Win_flush(0, rs->offswin) != MPI_SUCCESS) || (MPI_Win_flush(0, rs->lenswin) != MPI_SUCCESS) || 
+       (MPI_Win_flush(0, rs->execwin) != MPI_SUCCESS) )
    {
-      curiflg = 0;
-      if( MPI_Irecv(&curiflg, 1, MPI_UNSIGNED, crank, MPI_ANY_TAG, coorcomm, &req) != MPI_SUCCESS)
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Get Failed! :(\n", SRC_FILE, __LINE__, ws->rank);
+      return -1;
+   }
+   for(u = 0; u < cnt; u++)
+   {
+      if( (rw->offs[u] + rw->lens[u] > rs->wmap.maplen) || (rw->eidx[u] >= rs->etab.n) )
       {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Recv Failed! :(\n", SRC_FILE, __LINE__, wrank);
+         fprintf(stderr, "\"%s\" @L %d RANK %d : unit %u is not in the arg list, did it change?\n", SRC_FILE, __LINE__, ws->rank, start + u);
          return -1;
       }
-      
-      pthread_mutex_lock(&mtexstop);
-      stp = stopissed; 
-      pthread_mutex_unlock(&mtexstop);
-      if(stp == 1)
-      {
-         if(verbose >= 1) 
-            fprintf(verbout, "MONITOR, shutdown threat issued, MONITOR exiting...\n");
-         return 1;
-      }
-
-      /* it's assumed at least one message will come otherwise this will wait, and wait, and wait ... */
-      if( MPI_Wait(&req, &status) != MPI_SUCCESS)
-         fprintf(stderr, "\"%s\" @L %d RANK %d : WARN MPI_Wait Failed! :(\n", SRC_FILE, __LINE__, wrank);
-         
-      if(status.MPI_TAG == COMPLETED_WORK) 
-      {
-         if(verbose >= 3) 
-            fprintf(verbout, "MONITOR received id %u for a completed unit from rank %d\n", curiflg, status.MPI_SOURCE);
-         /* mark complete */
-         if( (*itemidx != NULL) && (curiflg < *ni) )
-            (*itemidx)[curiflg] = 1;
-
-      }
-      else if(status.MPI_TAG == UNIT_TAG)
+      memset(&oneu, 0, sizeof(WORK_UNIT));
+      if( (oneu.pargs = (char*) malloc(rw->lens[u] + 1)) == NULL)
       {
-         if(verbose >= 3) 
-            fprintf(verbout, "MONITOR received n items (%u) notice from rank %d\n", curiflg, status.MPI_SOURCE);
-         *ni = curiflg;
-
-         if( ( *itemidx = (unsigned char*) calloc( (size_t)(*ni), sizeof(unsigned char)) ) == NULL)
-         {
-            fprintf(stderr, "\"%s\" @L %d RANK %d : calloc failed : %s\n", SRC_FILE, __LINE__, wrank, strerror(errno));
-            return -1;
-         }
+         fprintf(stderr, "\"%s\" @L %d RANK %d : malloc failed : %s\n", SRC_FILE, __LINE__, ws->rank, strerror(errno));
+         return -1;
       }
-      else if(status.MPI_TAG == ENDWORK) 
+      if(rw->lens[u] > 0)
+         memcpy(oneu.pargs, &(rs->wmap.map[rw->offs[u]]), rw->lens[u]);
+      oneu.pargs[rw->lens[u]] = '\0';
+      oneu.resrank = ws->rank;
+      oneu.id_tag = start + u;
+      oneu.was_killed = PX_NO;
+      oneu.exec_idx = (unsigned int) rw->eidx[u];
+      oneu.procpath = rs->etab.paths[oneu.exec_idx];
+      if( work_queue_push(ws, &oneu, ((u == (cnt - 1)) ? PX_YES : PX_NO)) < 0)
       {
-         if(verbose >= 2) 
-            fprintf(verbout, "MONITOR received a normal exit signal\n");
-         stopissed = 2; /* locking this here not that critical */
+         free(oneu.pargs);
+         return -1;
       }
    }
-   return 0;
-}/* monitor_proc */
+   return 1;
+}/* rma_claim */
 
 /*-------------------------------------------------------------------------
-* See pxargs.h for details
+* Local module routine, puts the outcome of the finished units into rank 0's arrays,
+* then sets their bits. The bits are only set once the results are there.
 */
-int work_proc(int rank, unsigned int maxutime, unsigned int verbose, FILE* verbout)
+static int rma_report(RMA_SCHED* rs, WORK_STATE* ws, RMA_WORK* rw)
 {
-   MPI_Status status;
-   unsigned char* workmsg;
-   char* cmdbuf;
-   const unsigned int maxwork = PXMAXARGS; 
-   unsigned int i = 0;
-   int bfsize, cmdsize;
-   WORK_UNIT oneu; 
-   
-   cmdsize = PATH_MAX+PXARGLENMAX+64;
-   /* setup on maximum size */
-   bfsize = mpi_sizeof_worku();
-   if( (workmsg = (unsigned char*) malloc(bfsize)) == NULL)
+   void* nptr;
+   unsigned int u, id;
+   int rc = 0;
+
+   if(ws->nres == 0)
+      return 0;
+   if(ws->nres > rw->rcap)
    {
-      fprintf(stderr, "\"%s\" @L %d RANK %d : malloc failed : %s\n", SRC_FILE, __LINE__, rank, strerror(errno));
+      if( (nptr = realloc(rw->rbuf, 2 * ws->nres * sizeof(unsigned int))) == NULL)
+         return -1;
+      rw->rbuf = (unsigned int*) nptr;
+      if( (nptr = realloc(rw->kbuf, ws->nres * sizeof(unsigned char))) == NULL)
+         return -1;
+      rw->kbuf = (unsigned char*) nptr;
+      if( (nptr = realloc(rw->xbuf, ws->nres * sizeof(int))) == NULL)
+         return -1;
+      rw->xbuf = (int*) nptr;
+      rw->rcap = ws->nres;
+   }
+   for(u = 0; (u < ws->nres) && (rc == 0); u++)
+   {
+      id = ws->res[u].id_tag;
+      rw->rbuf[u] = ws->res[u].ru.wall_ms;
+      rw->kbuf[u] = (unsigned char)ws->res[u].was_killed;
+      rw->xbuf[u] = (ws->res[u].term_sig != 0) ? -(ws->res[u].term_sig) : ws->res[u].exit_code;
+      if( (MPI_Put(&(rw->rbuf[u]), 1, MPI_UNSIGNED, 0, (MPI_Aint)id, 1, MPI_UNSIGNED, rs->msecswin) != MPI_SUCCESS) ||
+          (MPI_Put(&(ws->rank), 1, MPI_INT, 0, (MPI_Aint)id, 1, MPI_INT, rs->rankwin) != MPI_SUCCESS) ||
+          (MPI_Put(&(rw->kbuf[u]), 1, MPI_UNSIGNED_CHAR, 0, (MPI_Aint)id, 1, MPI_UNSIGNED_CHAR, rs->killwin) != MPI_SUCCESS) ||
+          (MPI_Put(&(rw->xbuf[u]), 1, MPI_INT, 0, (MPI_Aint)id, 1, MPI_INT, rs->exitwin) != MPI_SUCCESS) )
+         rc = -1;
+   }
+   if( (rc < 0) || (MPI_Win_flush(0, rs->msecswin) != MPI_SUCCESS) || (MPI_Win_flush(0, rs->rankwin) != MPI_SUCCESS) ||
+       (MPI_Win_flush(0, rs->killwin) != MPI_SUCCESS) || (MPI_Win_flush(0, rs->exitwin) != MPI_SUCCESS) )
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Put Failed! :(\n", SRC_FILE, __LINE__, ws->rank);
       return -1;
    }
-   if( (cmdbuf = (char*) malloc(cmdsize)) == NULL)
+   for(u = 0; (u < ws->nres) && (rc == 0); u++)
    {
-      fprintf(stderr, "\"%s\" @L %d RANK %d : malloc failed : %s\n", SRC_FILE, __LINE__, rank, strerror(errno));
-      free(workmsg);
+      id = ws->res[u].id_tag;
+      rw->rbuf[ws->nres + u] = 1U << (id % 32);
+      if( MPI_Accumulate(&(rw->rbuf[ws->nres + u]), 1, MPI_UNSIGNED, 0, (MPI_Aint)((id / 32) + 1), 1, MPI_UNSIGNED, MPI_BOR, rs->swin) != MPI_SUCCESS)
+         rc = -1;
+   }
+   if( (rc < 0) || (MPI_Win_flush(0, rs->swin) != MPI_SUCCESS) )
+   {
+      fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Accumulate Failed! :(\n", SRC_FILE, __LINE__, ws->rank);
       return -1;
    }
+   ws->nres = 0;
+   return 0;
+}/* rma_report */
 
-   while(i <= maxwork) 
+/*-------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int rma_work_proc( RMA_SCHED* rsched, int rank, WORK_PARAMS* wparams, SCHED_PARAMS* sparams,
+                   int nworkers, unsigned int verbose, FILE* verbout )
+{
+   MPI_Win* wins[8];
+   WORK_STATE ws;
+   RMA_WORK rw;
+   unsigned int want;
+   int i, rc = 0, more = PX_YES;
+
+   memset(&ws, 0, sizeof(WORK_STATE));
+   ws.epfd = -1;
+   memset(&rw, 0, sizeof(RMA_WORK));
+   ws.rank = rank;
+   ws.comm = rsched->comm;
+   ws.sendreq = MPI_REQUEST_NULL;
+   ws.nslots = (wparams->nslots > 0) ? wparams->nslots : 1;
+   ws.maxumsecs = wparams->maxumsecs;
+   ws.gracemsecs = wparams->gracemsecs;
+   ws.noshell = wparams->noshell;
+   ws.trace = wparams->trace;
+   ws.verbose = verbose;
+   ws.verbout = verbout;
+   work_launch_init(&ws, wparams);
+   if(sparams->chunkmax < 1)
+      sparams->chunkmax = 1;
+   if(sparams->depth < 1)
+      sparams->depth = 1;
+   if(nworkers < 1)
+      nworkers = 1;
+
+   /* a claim is at most a chunk for each slot and prefetch level */
+   rw.cap = sparams->chunkmax * ws.nslots * sparams->depth;
+   rw.offs = (size_t*) malloc(rw.cap * sizeof(size_t));
+   rw.lens = (unsigned int*) malloc(rw.cap * sizeof(unsigned int));
+   rw.eidx = (unsigned char*) malloc(rw.cap * sizeof(unsigned char));
+   ws.slots = (WORK_SLOT*) calloc(ws.nslots, sizeof(WORK_SLOT));
+   if( (rw.offs == NULL) || (rw.lens == NULL) || (rw.eidx == NULL) || (ws.slots == NULL) )
    {
-      memset(workmsg, 0, bfsize);
-      memset(cmdbuf, 0, cmdsize);
+      fprintf(stderr, "\"%s\" @L %d RANK %d : malloc failed : %s\n", SRC_FILE, __LINE__, rank, strerror(errno));
+      free(rw.offs); free(rw.lens); free(rw.eidx);
+      work_state_free(&ws);
+      return -1;
+   }
+   wins[0] = &(rsched->swin);
+   wins[1] = &(rsched->offswin);
+   wins[2] = &(rsched->lenswin);
+   wins[3] = &(rsched->execwin);
+   wins[4] = &(rsched->msecswin);
+   wins[5] = &(rsched->rankwin);
+   wins[6] = &(rsched->killwin);
+   wins[7] = &(rsched->exitwin);
+   for(i = 0; i < 8; i++)
+      MPI_Win_lock_all(0, *(wins[i]));
+#ifdef PX_CHILD_SLOTS
+   sigemptyset(&(ws.waitmask));
+   sigaddset(&(ws.waitmask), SIGCHLD);
+   sigprocmask(SIG_BLOCK, &(ws.waitmask), &(ws.childmask));
+#endif
+#ifdef PX_PIDFD
+   /* a pidfd for each child, work_wait falls back to SIGCHLD without one */
+   ws.epfd = epoll_create1(EPOLL_CLOEXEC);
+#endif
+#ifdef PX_SUBREAPER
+   prctl(PR_SET_CHILD_SUBREAPER, 1);
+#endif
 
-      /* Receive a message from the master */
-      if( MPI_Recv(workmsg, bfsize, MPI_PACKED, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &status) != MPI_SUCCESS)
+   for(;;)
+   {
+      /* claim when the queue can not fill the free slots (plus depth-1 slots' worth queued) */
+      want = (ws.nslots - ws.nrun) + ((sparams->depth - 1) * ws.nslots);
+      if( (more == PX_YES) && (ws.qlen < want) )
       {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Recv Failed! :(\n", SRC_FILE, __LINE__, rank);
-         free(workmsg); free(cmdbuf);
-         return -1;
+         if( (rc = rma_claim(rsched, &ws, &rw, sparams, nworkers, want - ws.qlen)) < 0)
+            break;
+         if(rc == 0)
+            more = PX_NO;
       }
-
-      /* Check the tag of the received message. */
-      if (status.MPI_TAG == ENDWORK) 
+      if( (more == PX_NO) && (ws.qlen == 0) && (ws.nrun == 0) )
       {
-         if(verbose >= 2)
-            fprintf(verbout, "Rank %d received exit signal\n", rank);
-         free(cmdbuf); free(workmsg);
-         return 0;
-      }
-      mpi_worku_unserialize(workmsg, bfsize, &oneu);
-      
-      snprintf(cmdbuf, cmdsize, "%s %s", oneu.procpath, oneu.pargs); 
-      if(verbose == 2)
-         fprintf(verbout, "Rank %d received \"%s\" \"%s\"\n", rank, oneu.procpath, oneu.pargs);
-      else if(verbose >= 3)
-      {
-         fprintf(verbout, "Rank %d received WORK UNIT: ", rank);
-         fprint_worku(verbout, &oneu);
-         if(maxutime > 0)
-            fprintf(verbout, "Rank %d running \"%s\" (max runtime %u)\n", rank, cmdbuf, maxutime);
-         else
-            fprintf(verbout, "Rank %d running \"%s\"\n", rank, cmdbuf);
+         rc = 0;
+         break;
       }
 
-      /*-------------------------------*/
-      /* send to program/script        */
-      /*-------------------------------*/
-      if( xpopen(cmdbuf, maxutime, verbose, verbout) < 0)
-          fprintf(stderr, "%s @L %d RANK %d : Command \"%s\" failed with xpopen\n", SRC_FILE, __LINE__, rank, cmdbuf);
-
-      oneu.was_killed = MODTexceed;
-      /* future TODO: set anything else that matters here that may need to be sent back */
+      /* fill the free slots */
+      while( (rc = work_start(&ws)) == 1)
+         ;
+      if(rc < 0)
+         break;
 
-      /* now we're finished */
-      mpi_worku_serialize(&oneu, workmsg, bfsize);
-      if( MPI_Send(workmsg, bfsize, MPI_PACKED, 0, 0, MPI_COMM_WORLD) != MPI_SUCCESS)
+      /* collect what finished, waiting a little if nothing has yet (or for the next launch) */
+      if( ((rc = work_reap(&ws)) == 0) && ((ws.nrun > 0) || (ws.qlen > 0)) )
       {
-         fprintf(stderr, "\"%s\" @L %d RANK %d : MPI_Send Failed! :(\n", SRC_FILE, __LINE__, rank);
-         free(workmsg); free(cmdbuf);
-         return -1;
+         work_wait(&ws);
+         rc = work_reap(&ws);
       }
-      i++;
-   }
-
-   free(workmsg);
-   free(cmdbuf);
-   return 0;
-}/* work_proc */
+      if(rc < 0)
+         break;
 
+      /* the report is one sided, nobody waits on it so send it right away */
+      if( (rc = rma_report(rsched, &ws, &rw)) < 0)
+         break;
+   }
+   if( (rc == 0) && (verbose >= 2) )
+      fprintf(verbout, "Rank %d found no more units to claim\n", rank);
 
+#ifdef PX_CHILD_SLOTS
+   sigprocmask(SIG_SETMASK, &(ws.childmask), NULL);
+#endif
+   for(i = 0; i < 8; i++)
+      MPI_Win_unlock_all(*(wins[i]));
+   free(rw.offs); free(rw.lens); free(rw.eidx);
+   free(rw.rbuf); free(rw.kbuf); free(rw.xbuf);
+   work_state_free(&ws);
+   return ((rc < 0) ? -1 : 0);
+}/* rma_work_proc */
@@ -39,6 +39,9 @@
 #include <limits.h>
 #include <sys/time.h>
 #include <string.h>
+#ifdef HAVE_PTHREAD_H 
+ #include <pthread.h>
+#endif
 
 #include <mpi.h>
 
@@ -60,12 +63,51 @@
 /* signal for unit info */
 #define UNIT_TAG 16 
 
+/* signal code to drop a unit, the other copy of a backed up unit finished first */
+#define CANCELWORK 32
+
+/* signal code to change the units a worker runs at once (or a node leader's node), see --control */
+#define SLOTSWORK 64
+
 /* YES or NO, True or False, etc... */
 #define PX_YES 1 
 #define PX_NO 0 
 
-/* Maximum arg string length */
-#define PXARGLENMAX 8192
+/* Initial line buffer length used when reading the arg list, grown as needed */
+#define PXARGLENINIT 256
+
+/* Work unit wire format version, see mpi_worku_serialize */
+#define WU_WIRE_VERSION 1
+
+/* Work unit wire header field offsets (packed as MPI_LONG). New fields 
+   must be appended, readers skip fields they do not know about. */
+#define WU_F_IDTAG 0
+#define WU_F_RESRANK 1
+#define WU_F_KILLED 2
+#define WU_F_PROCSECS 3
+#define WU_F_ARGLEN 4
+#define WU_F_PATHLEN 5
+#define WU_F_EXECIDX 6
+#define WU_F_EXITCODE 7
+#define WU_F_TERMSIG 8
+#define WU_F_MAXMSECS 9
+#define WU_F_WALLMS 10
+#define WU_F_UTIMEMS 11
+#define WU_F_STIMEMS 12
+#define WU_F_MAXRSS 13
+#define WU_F_INBLOCK 14
+#define WU_F_OUBLOCK 15
+#define WU_F_NVCSW 16
+#define WU_F_NIVCSW 17
+#define WU_F_TRECV 18
+#define WU_F_TSTART 19
+#define WU_F_TEXIT 20
+#define WU_F_TREPORT 21
+#define WU_NFIELDS 22
+
+/* Maximum number of distinct executables in an arg list (see --exec-column),
+   index 0 is always the -p program broadcast at startup */
+#define PXEXECMAX 64
 
 /* Default sh path path */
 #define SHL_PATH "/bin/sh"
@@ -85,17 +127,184 @@
 /* Maximum number of jobs per worker, 2^32 - 1 */
 #define PXMAXARGS 4294967295
 
+/* Guided self-scheduling divisor, a dispatch message carries about 
+   remaining_units / (PX_GSS_FACTOR * nworkers) units (see --chunk) */
+#define PX_GSS_FACTOR 2
+
+/* A worker with running children checks for new work at least this often 
+   (milliseconds), a child exiting or a time limit wakes it sooner (see --slots) */
+#define PX_SLOT_POLL_MSECS 10
+
+/* Default milliseconds from the SIGTERM to the SIGKILL for a unit over its 
+   --max-time (see --kill-grace) */
+#define PX_KILL_GRACE_MSECS 2000
+
+/* The most units in one completion message, a worker with more finished sends them
+   in several. The coordinator keeps a receive posted for each worker sized for this
+   many (or the most the worker can hold if that is fewer) */
+#define PX_REPORT_MAX 256
+
+/* Streamed arg lists (stdin or --stream): the units held in memory at once by
+   default (see --window), the read size, and how long the coordinator waits 
+   for input (milliseconds) before it checks on the workers again */
+#define PX_STREAM_WINDOW 65536
+#define PX_STREAM_READ 65536
+#define PX_STREAM_POLL_MSECS 10
+
+/* Completed unit ids are sent to the monitor in batches, once PX_MON_BATCH are
+   pending or the oldest has waited PX_MON_FLUSH_MSECS, and only if the last batch 
+   is out so the coordinator never waits on the monitor */
+#define PX_MON_BATCH 1024
+#define PX_MON_FLUSH_MSECS 100
+
+/* How often (milliseconds) the monitor looks for the coordinator's messages and the
+   pbs poll's stop, it waits this way rather than in MPI so it can share a rank */
+#define PX_MON_POLL_MSECS 10
+
+/* With --rma how often (milliseconds) the coordinator looks at the completion bitmap */
+#define PX_RMA_POLL_MSECS 20
+
+/* Journal records (see --journal) are written and synced to disk together, once
+   PX_JRNL_BATCH are pending, the oldest has waited PX_JRNL_SYNC_MSECS or the 
+   coordinator has nothing else to do */
+#define PX_JRNL_BATCH 4096
+#define PX_JRNL_SYNC_MSECS 200
+
+/* Where work_store_order gets a unit's cost (see --lpt), a number in the column
+   after the exec column (if any), the sizes of the files the args name, or the
+   run time history (see --history) */
+#define PX_COST_COLUMN 1
+#define PX_COST_FILES 2
+#define PX_COST_HISTORY 3
+
+/* Run time history (see --history): a unit's time is the moving average of about its
+   last PX_HIST_WINDOW runs, the table starts with room for PX_HIST_INIT entries */
+#define PX_HIST_WINDOW 16
+#define PX_HIST_INIT 1024
+
+/* Live status (see --status): the file is rewritten every PX_STATUS_MSECS and the
+   throughput kept for PX_STATUS_WINDOW seconds, a status line is at most 
+   PX_STATUS_LNMAX bytes */
+#define PX_STATUS_MSECS 1000
+#define PX_STATUS_WINDOW 900
+#define PX_STATUS_LNMAX 640
+
+/* Runtime control (see --control): a command or reply line is at most PX_CTRL_LNMAX bytes 
+   and a client has PX_CTRL_READ_MSECS to send its command. The commands are: */
+#define PX_CTRL_LNMAX 1024
+#define PX_CTRL_READ_MSECS 2000
+/* stop sending units, and send them again */
+#define PX_CTRL_PAUSE 1
+#define PX_CTRL_RESUME 2
+/* stop sending units, wait for those out and end the run, writing the not-complete list */
+#define PX_CTRL_DRAIN 3
+/* drop the queued units that match a pattern, or send them before the rest */
+#define PX_CTRL_CANCEL 4
+#define PX_CTRL_FRONT 5
+/* change the units a worker (a node with -N) runs at once */
+#define PX_CTRL_SLOTS 6
+
+/* Timeline trace (see --trace): each rank keeps its events in memory, with room for PX_TRACE_INIT
+   at first and at most PX_TRACE_MAX (later ones are counted and dropped). Rank 0 lines up the
+   ranks' clocks with its own from the best of PX_TRACE_SYNC_ROUNDS round trips to each */
+#define PX_TRACE_INIT 4096
+#define PX_TRACE_MAX 4194304
+#define PX_TRACE_SYNC_ROUNDS 16
+/* what a rank does, its part of the trace is named after it */
+#define PX_TRACE_COORD 0
+#define PX_TRACE_WORKER 1
+#define PX_TRACE_LEADER 2
+#define PX_TRACE_MONITOR 3
+/* the events: a dispatch message sent and each unit in it, a completion message taken, a wait
+   for the workers, a CANCELWORK, SLOTSWORK or ENDWORK sent, a message a worker received, its
+   completion report and a unit's run */
+#define PX_TRACE_SEND 1
+#define PX_TRACE_UNIT 2
+#define PX_TRACE_COMPLETE 3
+#define PX_TRACE_WAIT 4
+#define PX_TRACE_CONTROL 5
+#define PX_TRACE_RECV 6
+#define PX_TRACE_REPORT 7
+#define PX_TRACE_RUN 8
+
+/* Speculative backups (see --speculate): a unit whose args start with the word PX_SPEC_MARK 
+   may be run twice. Once all units are sent, one that has been out for longer than the 
+   factor times the mean run time so far (and at least PX_SPEC_MIN_SECS) is sent to an idle 
+   slot too, the coordinator looks for them every PX_SPEC_POLL_MSECS */
+#define PX_SPEC_MARK "+"
+#define PX_SPEC_MIN_SECS 2.0
+#define PX_SPEC_POLL_MSECS 100
+
+/* The coordinator phases timed by --profile (see SCHED_STATS prof): completion receives
+   and reposts, unpacking completed units, monitor notifies, the journal and history, 
+   packing dispatches, sending them, reading a streamed arg list and waiting for the 
+   workers with nothing else to do */
+#define PX_PROF_RECV 0
+#define PX_PROF_UNPACK 1
+#define PX_PROF_NOTIFY 2
+#define PX_PROF_RECORD 3
+#define PX_PROF_PACK 4
+#define PX_PROF_SEND 5
+#define PX_PROF_READ 6
+#define PX_PROF_IDLE 7
+#define PX_PROF_NPHASES 8
+
+/* Retries (see --retries): SCHED_PARAMS retryon has a bit for each exit code 0 to 255 
+   that is retried, and the bits PX_RETRY_TIMEOUT for a unit stopped by its -m and 
+   PX_RETRY_SIGNAL for one ended by any other signal */
+#define PX_RETRY_TIMEOUT 256
+#define PX_RETRY_SIGNAL 257
+#define PX_RETRY_BITS 264
+#define PX_RETRY_ISSET(on, b) (((on)[(b) >> 3] & (1U << ((b) & 7))) != 0)
+
+/* 
+* The resources a unit's run used, from wait4 (the child and the descendants it 
+* waited for), all 0 where the platform does not have them or with --rma
+*/
+typedef struct
+{
+   /* wall clock, user and system CPU time in milliseconds */
+   unsigned int wall_ms;
+   unsigned int utime_ms;
+   unsigned int stime_ms;
+   /* peak resident set in kB */
+   unsigned int maxrss_kb;
+   /* block input and output operations */
+   unsigned int inblock;
+   unsigned int oublock;
+   /* voluntary (waits, mostly I/O) and involuntary (preempted) context switches */
+   unsigned int nvcsw;
+   unsigned int nivcsw;
+} WORK_RUSAGE;
+
+/* 
+* A unit's lifecycle, CLOCK_MONOTONIC nanoseconds, 0 for not (yet) known. The clocks
+* of different nodes are not comparable, only the times on one clock are subtracted.
+*/
+typedef struct
+{
+   /* on the coordinator's clock: the unit was sent and its completion received */
+   long long tdisp;
+   long long tdone;
+   /* on the worker's clock: the unit was received, its child started and exited and 
+      the unit was reported */
+   long long trecv;
+   long long tstart;
+   long long texit;
+   long long treport;
+} WORK_TIMES;
+
 /* 
 * Note, you will need to change the routines:
 *  mpi_sizeof_worku
 *  mpi_worku_serialize
 *  mpi_worku_unserialize
-* If you change the struct def below
+* and the WU_F_* field offsets if you change the struct def below
 */
 typedef struct
 {
-   /* parameters for procpath */ 
-   char pargs[PXARGLENMAX]; 
+   /* parameters for procpath (heap allocated, NULL if not loaded) */ 
+   char* pargs; 
    /* process time */
    long proc_secs;
    /* responsible rank */
@@ -104,200 +313,1450 @@ typedef struct
    unsigned int id_tag ;  
    /* was the unit killed, 0=No, 1=yes */
    int was_killed;
-   /* the last process/operation preformed script/exe */ 
-   char procpath[PATH_MAX]; 
+   /* index of the script/exe in the EXEC_TABLE, 0 is the -p program */ 
+   unsigned int exec_idx;
+   /* the script/exe path for exec_idx, not owned by the unit (points into the 
+      EXEC_TABLE) unless it came from mpi_worku_unserialize. NULL if unknown. */ 
+   char* procpath; 
+   /* the exit code, -1 if the unit did not exit on its own, and the signal that 
+      ended it, 0 for none */
+   int exit_code;
+   int term_sig;
+   /* the unit's own max run time in milliseconds (a retry's, see --retry-time), 
+      0 for the worker's */
+   unsigned int maxumsecs;
+   /* what the run used and its lifecycle, sent back with the completion */
+   WORK_RUSAGE ru;
+   WORK_TIMES tm;
    /* TODO: add more... */
 } WORK_UNIT;
 
+/* 
+* The interned executables of a job. The -p program is broadcast once at startup
+* and is always entry 0, per-line executables (see --exec-column) are added as 
+* they are found in the arg list. Work units only carry the entry index.
+*/
+typedef struct
+{
+   char* paths[PXEXECMAX];
+   unsigned int n;
+} EXEC_TABLE;
+
+/* The coordinator's counts shown by a live status, see status_update */
+typedef struct
+{
+   /* the units known (the list, or what is read so far of a stream), PX_YES once all are */
+   unsigned int units;
+   int listdone;
+   /* units done, sent and not reported yet, not sent yet (retries included) and the 
+      retries among them */
+   unsigned int done;
+   unsigned int inflight;
+   unsigned int queued;
+   unsigned int retryq;
+   /* runs killed over -m and the units that failed after their retries */
+   unsigned long killed;
+   unsigned long failed;
+   /* the workers' slots and how many of them have a unit */
+   unsigned int slots;
+   unsigned int busy;
+} STATUS_SNAP;
+
+/* 
+* A Unix domain socket served by a thread of its own, see sock_server_open. The live
+* status and the control socket are each one of these.
+*/
+typedef struct
+{
+   /* the socket path, the listening socket and a pipe that wakes the thread to stop */
+   char* path;
+   int sfd;
+   int pfd[2];
+   pthread_t thrd;
+   int running;
+} SOCK_SERVER;
+
+/* 
+* A live status of the coordinator, see status_open. A thread of its own rewrites the 
+* status file and answers the socket from the last STATUS_SNAP it was given, so the
+* coordinator only copies its counts in. The thread makes no MPI calls.
+*/
+typedef struct
+{
+   /* the status file, its temporary for the rename and the socket (<path>.sock) */
+   char* path;
+   char* tmppath;
+   SOCK_SERVER srv;
+   pthread_mutex_t mtx;
+   STATUS_SNAP snap;
+   /* when the status was opened (ns), and the units done at each of the last 
+      PX_STATUS_WINDOW ticks of PX_STATUS_MSECS, tick k is in ring[k % PX_STATUS_WINDOW] */
+   long long t0;
+   unsigned int* ring;
+   unsigned long tick;
+} LIVE_STATUS;
+
+/* A runtime control command, see control_take */
+typedef struct
+{
+   /* a PX_CTRL_* code */
+   int op;
+   /* PX_CTRL_SLOTS: the units at once and the worker's rank, -1 for all of them */
+   unsigned int n;
+   int rank;
+   /* the pattern of PX_CTRL_CANCEL and PX_CTRL_FRONT, the not-complete file of PX_CTRL_DRAIN 
+      ("" for the -n file) */
+   char arg[PX_CTRL_LNMAX];
+} CONTROL_CMD;
+
+/* 
+* The runtime control socket of the coordinator, see control_open. A thread of its own takes 
+* each connection's command and waits while the coordinator carries it out, the coordinator
+* only looks for a pending command between its other work.
+*/
+typedef struct
+{
+   SOCK_SERVER srv;
+   pthread_mutex_t mtx;
+   pthread_cond_t cond;
+   /* PX_YES while cmd waits for the coordinator, replied once reply has its answer, stop 
+      once the coordinator takes no more */
+   int pending;
+   int replied;
+   int stop;
+   CONTROL_CMD cmd;
+   char reply[PX_CTRL_LNMAX];
+} CONTROL;
+
+/* 
+* A trace event, see trace_event. Times are CLOCK_MONOTONIC nanoseconds of the rank that 
+* recorded it, the meaning of id, peer and val is up to the PX_TRACE_* kind.
+*/
+typedef struct
+{
+   long long ts;
+   long long dur;
+   unsigned int id;
+   int peer;
+   int val;
+   unsigned short kind;
+   unsigned short slot;
+} TRACE_EVENT;
+
+/* 
+* A rank's timeline trace, see trace_open. Events are only appended to ev while the job
+* runs, trace_close sends them to rank 0 which writes the one trace file.
+*/
+typedef struct
+{
+   TRACE_EVENT* ev;
+   size_t n;
+   size_t cap;
+   unsigned long dropped;
+   int rank;
+   int role;
+   /* a duplicate of the ranks' communicator for the clock syncs and the merge, 
+      MPI_COMM_NULL for a second buffer of a rank (see trace_open) */
+   MPI_Comm comm;
+   int nranks;
+   /* rank 0 only: its time at the open, and for each rank r the clock offset and the 
+      rank's own time at the sync of the open (sync[4*r], sync[4*r+1]) and of the close 
+      (sync[4*r+2], sync[4*r+3]) */
+   long long t0;
+   long long* sync;
+} TRACE;
+
+/* Scheduling parameters for coordinate_proc */
+typedef struct
+{
+   /* the largest number of units in one dispatch message, 1 sends one unit at a time */
+   unsigned int chunkmax;
+   /* chunks a worker may have outstanding (its prefetch queue depth), 1 means
+      the next unit is only sent when the worker reports the last one done */
+   unsigned int depth;
+   /* units each worker runs at once, NULL means wslots each. A node leader's
+      slots are the sum over its local workers (see subcoord_proc) */
+   unsigned int* slots;
+   /* units a plain worker runs at once (--slots) */
+   unsigned int wslots;
+   /* MPI_COMM_NULL, or a duplicate of the workers' communicator that the dispatch and
+      ENDWORK messages go out on when the coordinator's rank is also a worker (--coord-work).
+      The coordinator then polls rather than waits in MPI, leaving the rank's cores to its units */
+   MPI_Comm dispcomm;
+   /* 0, or the factor over the mean run time at which a marked unit gets a backup copy 
+      (--speculate, see PX_SPEC_MIN_SECS). Only used with a loaded arg list */
+   double speculate;
+   /* a failed unit is sent again, after the rest, up to retries times if its outcome
+      is in retryon (see PX_RETRY_BITS). Each retry's max run time is the job's maxumsecs 
+      times retrytime once more, with retryelse PX_YES it goes to another worker */
+   unsigned int retries;
+   unsigned char retryon[PX_RETRY_BITS / 8];
+   double retrytime;
+   int retryelse;
+   unsigned int maxumsecs;
+   /* PX_YES to time the coordinator's phases (--profile), see SCHED_STATS prof */
+   int profile;
+   /* NULL, or the live status the coordinator keeps up to date (--status) */
+   LIVE_STATUS* status;
+   /* NULL, or the runtime control socket (--control), and the -n file a drain writes 
+      the units not complete to unless it names one (NULL for none) */
+   CONTROL* control;
+   const char* notcomplete;
+   /* NULL, or the rank's timeline trace (--trace) */
+   TRACE* trace;
+} SCHED_PARAMS;
+
+/* An arg list read as it is dispatched, see work_stream_open */
+typedef struct
+{
+   int fd;
+   /* unread input is buf[pos] to buf[len] */
+   char* buf;
+   size_t pos;
+   size_t len;
+   size_t cap;
+   int eof;
+   /* the most units read ahead of the oldest unfinished one */
+   unsigned int window;
+   /* units read so far */
+   unsigned int nunits;
+   /* the exec table if each line names its executable, else NULL */
+   EXEC_TABLE* etab;
+   /* if not NULL each unit is printed here when it finishes (-w) */
+   FILE* retout;
+} WORK_STREAM;
+
+/* 
+* A loaded arg list, see work_store_open. The file is memory mapped and only the 
+* offset and length of each unit's args are kept, the per unit results are held 
+* in parallel arrays indexed by unit id.
+*/
+typedef struct
+{
+   /* the mapped arg file, NULL if it is empty */
+   char* map;
+   size_t maplen;
+   /* unit id's args are map[offs[id]] to map[offs[id]+lens[id]] */
+   size_t* offs;
+   unsigned int* lens;
+   /* index of each unit's executable in etab */
+   unsigned char* exec_idx;
+   /* results of each unit, see WORK_UNIT, the run time in milliseconds */
+   unsigned int* proc_msecs;
+   int* resrank;
+   unsigned char* was_killed;
+   /* the exit code, or minus the signal that ended the unit */
+   int* exitstat;
+   /* what each unit's run used and its lifecycle */
+   WORK_RUSAGE* ru;
+   WORK_TIMES* tm;
+   /* the number of units */
+   unsigned int n;
+   /* after work_store_skip or work_store_order the arg list position of each unit and 
+      the number of units in the whole list, orig is NULL if the units are as listed */
+   unsigned int* orig;
+   unsigned int norig;
+   /* PX_YES if the map is a heap copy of the file (no mmap on the platform) */
+   int copied;
+   /* the executable table the exec_idx entries refer to, may be NULL, and PX_YES 
+      if each line names its executable (entry 0 too when it is the -p program) */
+   EXEC_TABLE* etab;
+   int execcol;
+   /* after work_store_mark a flag for each unit that may be run twice, NULL if none may */
+   unsigned char* dupok;
+} WORK_STORE;
+
+/* the arg list position of store unit id, what the journal and the monitor know it by */
+#define WORK_STORE_ORIG(ws, id) (((ws)->orig != NULL) ? (ws)->orig[(id)] : (id))
+
+/* 
+* An append-only journal of completed units, see journal_open. Each record is a 
+* text line "<id> <secs> <rank> <killed> <status>" where id is the unit's position 
+* in the arg list and status its exit code, or minus the signal that ended it. 
+* Records are buffered and written and synced in groups.
+*/
+typedef struct
+{
+   int fd;
+   /* pending records are buf[0] to buf[len] */
+   char* buf;
+   size_t len;
+   size_t cap;
+   unsigned int npend;
+   /* when the oldest pending record came in (MPI_Wtime) */
+   double age;
+} JOURNAL;
+
+/* A unit's past runs, see HISTORY */
+typedef struct
+{
+   /* the hash of the unit's executable and args, 0 for an unused entry */
+   unsigned long long key;
+   /* runs recorded and how many of them were killed (-m) */
+   unsigned int runs;
+   unsigned int kills;
+   /* the predicted run time in seconds, see PX_HIST_WINDOW */
+   double secs;
+} HISTORY_ENTRY;
+
+/* 
+* The run times of units across runs, see history_load. A unit is known by a hash of 
+* its executable path and args, the entries are an open addressing table on it. On 
+* disk each entry is a text line "<hash> <runs> <kills> <secs>".
+*/
+typedef struct
+{
+   HISTORY_ENTRY* ents;
+   /* entries used, the table size (a power of 2) */
+   size_t n;
+   size_t cap;
+   /* runs recorded since the load */
+   unsigned int nrec;
+} HISTORY;
+
+/* 
+* RMA scheduling (--rma), see rma_sched_open. Rank 0 exposes a claim counter, the
+* completion bitmap and its WORK_STORE's index and result arrays in RMA windows. The
+* workers claim units with MPI_Fetch_and_op, read the args from their own map of the 
+* arg list and record the outcome with one-sided puts, rank 0 only watches the bitmap.
+*/
+typedef struct
+{
+   MPI_Comm comm;
+   int rank;
+   /* the number of units */
+   unsigned int n;
+   /* word 0 is the next unit to claim, bit id of words 1 to nwords is set when 
+      unit id is done (rank 0 only) */
+   unsigned int* sched;
+   unsigned int nwords;
+   MPI_Win swin;
+   /* rank 0's WORK_STORE arrays */
+   MPI_Win offswin;
+   MPI_Win lenswin;
+   MPI_Win execwin;
+   MPI_Win msecswin;
+   MPI_Win rankwin;
+   MPI_Win killwin;
+   MPI_Win exitwin;
+   /* a worker's map of the arg list, the exec table rank 0 built for it */
+   WORK_STORE wmap;
+   EXEC_TABLE etab;
+} RMA_SCHED;
+
+/* Worker parameters for work_proc */
+typedef struct
+{
+   /* units run at once (--slots) */
+   unsigned int nslots;
+   /* the max run time in milliseconds for a unit, 0 for no limit */
+   unsigned int maxumsecs;
+   /* milliseconds from the SIGTERM to the SIGKILL for a unit over maxumsecs, 
+      0 to send SIGKILL right away */
+   unsigned int gracemsecs;
+   /* this worker's share of the --launch-rate, units started per second, 0 for no limit */
+   double launchrate;
+   /* milliseconds the worker waits before it starts its first unit (-r), 0 for none */
+   unsigned int startmsecs;
+   /* PX_YES to split the command line into words and run the program 
+      directly (--no-shell), PX_NO to hand it to SHL_PATH -c */
+   int noshell;
+   /* PX_YES to start the units with /dev/null as stdin, for a worker on rank 0 
+      where stdin may be the arg list (--coord-work) */
+   int nullin;
+   /* the workers are ranks rankstart and up of the work_proc comm, ENDWORK is passed 
+      on down a binomial tree over them */
+   int rankstart;
+   /* MPI_COMM_NULL, or the duplicate of comm the units and ENDWORK come in on, so a 
+      worker sharing rank 0 with the coordinator only sees its own messages (see 
+      SCHED_PARAMS dispcomm) */
+   MPI_Comm incomm;
+   /* NULL, or the timeline trace the worker records its messages and runs in (--trace) */
+   TRACE* trace;
+} WORK_PARAMS;
+
+/* Scheduling counters filled in by coordinate_proc */
+typedef struct
+{
+   /* DOWORK messages sent */
+   unsigned long dispatch_msgs;
+   /* COMPLETED_WORK messages received */
+   unsigned long complete_msgs;
+   /* backup copies sent (--speculate) and how many of them finished first */
+   unsigned long backups;
+   unsigned long backup_wins;
+   /* retries sent (--retries) and the units that failed in the end */
+   unsigned long retried;
+   unsigned long failed;
+   /* runs killed over -m (retries included) */
+   unsigned long killed;
+   /* units cancelled (--control), and those left not complete by a drain (PX_YES if drained) */
+   unsigned long cancelled;
+   unsigned long notdone;
+   int drained;
+   /* the resources used by all of the runs (retries and backups too) : the runs, the sums
+      of their WORK_RUSAGE fields and the largest peak resident set, with its unit id */
+   unsigned long nusage;
+   unsigned long long wall_ms;
+   unsigned long long utime_ms;
+   unsigned long long stime_ms;
+   unsigned long long rss_kb;
+   unsigned long long inblock;
+   unsigned long long oublock;
+   unsigned long long nvcsw;
+   unsigned long long nivcsw;
+   unsigned int maxrss_kb;
+   unsigned int maxrss_id;
+   /* the units whose whole lifecycle is known (see WORK_TIMES) and the sums of their 
+      nanoseconds queued on the worker, running, held for the report and out for the 
+      rest of the round trip (messages both ways and the coordinator) */
+   unsigned long nlife;
+   unsigned long long queue_ns;
+   unsigned long long run_ns;
+   unsigned long long held_ns;
+   unsigned long long transit_ns;
+   /* with SCHED_PARAMS profile, the coordinator's nanoseconds in each PX_PROF_* phase 
+      and in all (from the first dispatch to the end of the run) */
+   unsigned long long prof[PX_PROF_NPHASES];
+   unsigned long long prof_ns;
+} SCHED_STATS;
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Nanoseconds on a clock that does not jump (CLOCK_MONOTONIC where there is one, else 
+*   the time of day). The one clock of the units' lifecycles (WORK_TIMES), the --profile
+*   phases, the --status rates and the --trace events and clock syncs.
+*
+* RETURN: 
+*   The time in nanoseconds
+*/
+long long now_tm_nsecs();
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Sets up an executable table with proc as entry 0.
+*
+* INPUTS:
+*    etab => the table to set up
+*    proc => the -p program, may be "" if each line names its own executable
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int exec_table_init(EXEC_TABLE* etab, const char* proc);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Interns an executable path in the table.
+*
+* INPUTS:
+*    etab => the table
+*    path => the executable path
+*    plen => the number of bytes of path to use
+*
+* RETURN: 
+*   The entry index for path, < 0 if the table is full (PXEXECMAX) or on failure
+*/
+int exec_table_intern(EXEC_TABLE* etab, const char* path, size_t plen);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Frees the entries of an executable table.
+*/
+void exec_table_free(EXEC_TABLE* etab);
+
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*   Loads the list of work unit arguments to be processed. The file format is of:
+*   Opens the list of work unit arguments to be processed. The file format is of:
 *     <args_1> 
 *     <  .   > 
 *     <  .   > 
 *     <args_n> 
+*   If execcol is PX_YES each line is of the form:
+*     <exec_i> <args_i>
+*   and the executables are interned in the table. The file is memory mapped and 
+*   indexed by line, the args are only copied out when a unit is dispatched, so
+*   the list costs a few bytes per unit plus the page cache.
 *
 * INPUTS:
 *    fname => The text file path
+*    etab => The job's executable table, entry 0 is the -p program. May be NULL 
+*            if execcol is PX_NO
+*    execcol => PX_YES if the arg list has an exec column
 *
 * OUTPUTS:
-*    WORK_UNIT => WORK_UNITs loaded from the file fname.
-*    n => the number of units (valid lines in file) in WORK_UNIT*
+*    wstore => the units of the file, wstore->n of them
 *
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
 */
-WORK_UNIT* load_work_list(const char* fname, unsigned int* n);
+int work_store_open(WORK_STORE* wstore, const char* fname, EXEC_TABLE* etab, int execcol);
 
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*   This routine will dump our the args in a WORK_UNIT list using an index (see below).
+*   Fills in a WORK_UNIT for unit id of a store. The args are copied to *abuf (grown 
+*   as needed) which the unit's pargs points to, procpath points into the store's 
+*   executable table.
 *
 * INPUTS:
-*   fname => The file path to dump the WORK_UNIT args to
-*   wlist => The list to dump
-*   nlist => The number of WORK_UNITs in wlist
-*   windex => The index that contains the id's of the WORK_UNITs in wlist to write.
-*             A 0 at index n implies don't dump, a 1 at index n implies dump the args 
-*   nindex => The number of items in windex 
+*    wstore => the store
+*    id => the unit id, < wstore->n
+*    abuf => the args buffer, *abuf may be NULL
+*    acap => the size of *abuf
+*
+* OUTPUTS:
+*    worku => the unit
 *
 * RETURN: 
 *   A value of 0 = success, < 0 = failed
 */
-int dump_work_list_by_index( const char* fname, WORK_UNIT* wlist, unsigned int nlist, 
-                             unsigned char* windex, unsigned int nindex);
+int work_store_unit(WORK_STORE* wstore, unsigned int id, WORK_UNIT* worku, char** abuf, size_t* acap);
 
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*   Routine prints a work unit list
+*   Maps an arg list without indexing it, the caller fills in the offsets of the 
+*   units it needs (see rma_work_proc). wstore->n is 0.
 *
 * INPUTS:
-*    fout => output file pointer
-*    list => the tile list
-*    n => number of units in the list
+*    fname => The text file path
+*
+* OUTPUTS:
+*    wstore => the mapped file
 *
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
 */
-void fprint_worklist(FILE* fout, WORK_UNIT* wlist, unsigned int n); 
+int work_store_map(WORK_STORE* wstore, const char* fname);
 
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Drops units from a store (see --resume). The units left are renumbered 0 to
+*   wstore->n - 1 in their original order, wstore->orig has their arg list positions.
+*
+* INPUTS:
+*    wstore => the store, not yet dispatched from
+*    done => wstore->n flags, units with a non zero flag are dropped
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int work_store_skip(WORK_STORE* wstore, unsigned char* done);
 
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*   Routine prints a WORK_UNIT structure 
+*   Puts the units of a store in longest processing time first order (see --lpt), 
+*   the units of equal cost keep their order. With PX_COST_COLUMN each unit's args
+*   start with its cost, which is taken off the args. With PX_COST_FILES the cost 
+*   is the sum of the sizes of the regular files named by the args' words (a word 
+*   or the part of it after a '='), each is looked up with stat. With PX_COST_HISTORY
+*   it is the unit's predicted run time, units that have not run before are taken to 
+*   be as costly as the costliest that has. wstore->orig has the units' arg list 
+*   positions after.
 *
 * INPUTS:
-*    fout => output file pointer
-*    work => the work unit list
+*    wstore => the store, not yet dispatched from (it may have been skipped)
+*    costsrc => PX_COST_COLUMN, PX_COST_FILES or PX_COST_HISTORY
+*    hist => the run time history for PX_COST_HISTORY, else not used
 *
-* OUTPUTS:
-*    None
+* RETURN: 
+*   A value of 0 = success, < 0 = failed (a unit without a cost column)
 */
-void fprint_worku(FILE* fout, WORK_UNIT* worku);
+int work_store_order(WORK_STORE* wstore, int costsrc, HISTORY* hist);
 
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*   Coordinator routine for asynchronous processing.
+*   Reorders the units from to from+k-1 of a store, unit ids[i] is moved to from+i. Only 
+*   the index moves, so the units must not have been dispatched yet. wstore->orig has 
+*   the units' arg list positions after.
 *
 * INPUTS:
-*    work => the work units list
-*    n => the number of tiles
-*    proc => processor script/program path
-*    nworkers => the number of worker processors involved
-*    rankstart => the starting rank of the workers (assume contiguous 
-*                 ranks, rankstart to rankstart+nworkers)
-*    randstart => if random release of the initial workload is
-*                 desired then set this to a value >= 0 (seconds)
-*    randend => see above, the closing interval value
-
-*    e.g. randstart=1,randend=10, causes the program to wait 
-*         between 1 and 10 seconds with each release of the initial
-*         work distribution.
-*    Note if these values are < 0 then the parameters are ignored
-*    and work is distributed without waiting.
-*    moncomm => if a monitor process exists this is the communicator handle.
-*               This can be MPI_COMM_NULL...
-*    mnrank => if moncomm exists then this should be set to the rank
-*             the monitor has in moncomm group
-*    verbose => the verbosity level
-*    verbout => the verbosity file stream
+*    wstore => the store
+*    from => the first unit moved
+*    ids => k ids, an ordering of from to from+k-1
+*    k => the number of units moved
 *
 * RETURN: 
 *   A value of 0 = success, < 0 = failed
 */
-int coordinate_proc( WORK_UNIT* wunits, unsigned int n, const char* proc, 
-                     int nworkers, int rankstart, int randstart, 
-                     int randend, MPI_Comm moncomm, int mnrank, 
-                     unsigned int verbose, FILE* verbout
-                   );
+int work_store_permute(WORK_STORE* wstore, unsigned int from, const unsigned int* ids, unsigned int k);
 
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*   worker routine for asynchronous processing.
+*   Finds the units that are safe to run twice (see --speculate), those whose args start
+*   with the word PX_SPEC_MARK. The word is taken off their args and their wstore->dupok
+*   flags are set. The mark comes before a cost column (see work_store_order).
 *
 * INPUTS:
-*    rank => the worker's rank
-*    maxutime => the max run time a unit is allowed to run (signals must be present on the platform) 
-*    verbose => the verbosity level
-*    verbout => the verbosity file stream
+*    wstore => the store, not yet dispatched from or ordered (it may have been skipped)
+*
+* OUTPUTS:
+*    nmark => the number of units marked
 *
 * RETURN: 
 *   A value of 0 = success, < 0 = failed
 */
-int work_proc(int rank, unsigned int maxutime, unsigned int verbose, FILE* verbout);
+int work_store_mark(WORK_STORE* wstore, unsigned int* nmark);
 
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*   A monitor routine for asynchronous event handling.
-* INPUTS:
-*    coorcomm => communicator handle, for 'talking' to the coordinator proc.
-*    crank => the coordinator's rank for the sub comm coorcomm 
-*    wrank => the rank for comm world
-*    preexit => Notify of a pre-exit event n seconds before the scheduling 
-*               facility is due to terminate this pxargs job. This is a 
-*               suggested time, it will not be exact (libpbs required).
-*    verbose => the verbosity level
-*    verbout => the verbosity file stream
+*   Unmaps and frees a store opened with work_store_open.
+*/
+void work_store_close(WORK_STORE* wstore);
+
+/*--------------------------------------------------------------------------------------------
 * 
+* DESCRIPTION:
+*   Opens a journal of completed units for appending, it is created if need be.
+*   Records of an earlier run are kept so one journal can span any number of
+*   restarts (see journal_load).
+*
+* INPUTS:
+*    fname => The journal path
+*
 * OUTPUTS:
-*    itemidx => An boolean array for which items were completed (1=yes, 0=no).
-*               Note, this array runs 'parallel' to the work units list id's 
-*               (wunits parameter in coordinate_proc), e.g. index[20] is work unit
-*               with id 20.
-*    ni => The length of itemidx.
+*    jrnl => the journal
 *
 * RETURN: 
-*   A value of 0 implies a successful run, i.e. nothing out of the ordinary happened
-*   A value of < 0 implies something failed badly
-*   A value of 1 implies a forced early exit notice by the scheduling.
+*   A value of 0 = success, < 0 = failed
+*/
+int journal_open(JOURNAL* jrnl, const char* fname);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Adds the record of a completed unit to a journal, the pending records are 
+*   written out if it is time to (see journal_flush).
 *
-* NOTES:
-*   The caller is responsible for freeing itemidx if it is not NULL
+* INPUTS:
+*    jrnl => the journal, may be NULL for none
+*    id => the unit's position in the arg list
+*    secs, rank, killed => the unit's outcome, see WORK_UNIT
+*    status => the exit code, or minus the signal that ended the unit
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
 */
-int monitor_proc( MPI_Comm coorcomm, int crank, int wrank, 
-                  unsigned int preexit, unsigned char** itemidx, 
-                  unsigned int* ni, unsigned int verbose, 
-                  FILE* verbout );
+int journal_record(JOURNAL* jrnl, unsigned int id, long secs, int rank, int killed, int status);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Writes and syncs the pending records of a journal as one group if there are 
+*   PX_JRNL_BATCH of them or the oldest is PX_JRNL_SYNC_MSECS old. With force 
+*   PX_YES any pending records are written now.
+*
+* INPUTS:
+*    jrnl => the journal, may be NULL for none
+*    force => PX_YES or PX_NO
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int journal_flush(JOURNAL* jrnl, int force);
 
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*  Returns the size of a WORK_UNIT type.
+*   Writes out any pending records and closes a journal.
+*
+* INPUTS:
+*    jrnl => the journal
 *
 * RETURN: 
-*   The number of bytes.
+*   A value of 0 = success, < 0 = failed
 */
-int mpi_sizeof_worku();
+int journal_close(JOURNAL* jrnl);
 
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*   Packs a work unit structure for sending/passing
+*   Reads the completed units of a journal. A journal that does not exist yet has
+*   none, and a last record cut short (the job was killed while writing it) is 
+*   ignored. A unit whose record has it failed (killed, ended by a signal or a 
+*   nonzero exit) is not complete unless it has a record of a success too.
 *
 * INPUTS:
-*   work => the work structure to serialize
-*   bufsize => the buffer size
+*    fname => The journal path
+*    n => the number of units in the arg list
 *
 * OUTPUTS:
-*   buf => a buffer, which should be of adequate size, that the work unit is packed into
+*    done => n flags, the flag of each unit in the journal is set to 1
+*    ndone => the number of units newly flagged
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
 */
-void mpi_worku_serialize(WORK_UNIT* work, void* buf, int bufsize);
+int journal_load(const char* fname, unsigned char* done, unsigned int n, unsigned int* ndone);
 
 /*--------------------------------------------------------------------------------------------
 * 
 * DESCRIPTION:
-*   Unpacks a work unit structure 
+*   Reads a run time history. A history that does not exist yet is empty, and a 
+*   last entry cut short is ignored.
 *
 * INPUTS:
-*   buf => a buffer of adequate size that was packed by mpi_work_serialize
-*   bufsize => the buffer size
+*    fname => The history path
 *
 * OUTPUTS:
-*   work => the work structure with the data from buf 
+*    hist => the history, free it with history_free
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int history_load(HISTORY* hist, const char* fname);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Looks up a unit's past runs.
+*
+* INPUTS:
+*    hist => the history, may be NULL
+*    proc => the unit's executable path
+*    args, alen => the unit's args and their length (they need not end with a '\0')
+*
+* RETURN: 
+*   The unit's entry, NULL if it has not run before
+*/
+HISTORY_ENTRY* history_lookup(HISTORY* hist, const char* proc, const char* args, size_t alen);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Adds a run of a unit to the history.
+*
+* INPUTS:
+*    hist => the history, may be NULL for none
+*    proc, args, alen => the unit, see history_lookup
+*    secs, killed => the unit's run time, in seconds to the millisecond, and whether it 
+*                    was killed
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int history_record(HISTORY* hist, const char* proc, const char* args, size_t alen, double secs, int killed);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Writes a history out. It is written to "<fname>.tmp" and renamed over fname,
+*   so a job killed while saving leaves the old history.
+*
+* INPUTS:
+*    hist => the history
+*    fname => The history path
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int history_save(HISTORY* hist, const char* fname);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Frees a history.
+*
+* INPUTS:
+*    hist => the history
+*/
+void history_free(HISTORY* hist);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Opens a Unix domain socket to be served by sock_server_start. A socket file left at 
+*   path by a job that was killed is removed first, anything else there fails the open. 
+*   The socket and the stop pipe are not passed on to the units.
+*
+* INPUTS:
+*    path => the socket path
+*    what => what the socket is for, for the error notes
+*    nonblock => PX_YES for a listening socket that does not block in accept
+*
+* OUTPUTS:
+*    srv => the socket
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int sock_server_open(SOCK_SERVER* srv, const char* path, const char* what, int nonblock);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Starts the thread of a socket from sock_server_open, with every signal blocked so
+*   they are left to the threads that run the units. The thread loops on 
+*   sock_server_wait and returns once it is told to stop.
+*
+* INPUTS:
+*    srv => the socket
+*    run, arg => the thread's routine and its argument
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int sock_server_start(SOCK_SERVER* srv, void* (*run)(void*), void* arg);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Waits, in the socket's thread, for a connection or for sock_server_close.
+*
+* INPUTS:
+*    srv => the socket
+*    msecs => the longest wait, < 0 for no limit
+*
+* RETURN: 
+*   1 if a connection waits to be accepted on srv->sfd, 0 if none came in time 
+*   and < 0 if the thread is to stop (or the wait failed)
+*/
+int sock_server_wait(SOCK_SERVER* srv, int msecs);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Sends a reply to a client, one that has hung up is no reason to stop (no SIGPIPE).
+*
+* INPUTS:
+*    cfd => the accepted connection
+*    buf, len => the reply
+*/
+void sock_server_send(int cfd, const char* buf, size_t len);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Stops the socket's thread if it was started and waits for it, then closes and 
+*   removes the socket. Safe on a socket that failed to open.
+*
+* INPUTS:
+*    srv => the socket
+*/
+void sock_server_close(SOCK_SERVER* srv);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Opens a live status: the file path, rewritten through a rename every PX_STATUS_MSECS 
+*   so a reader never sees half of it, and the Unix domain socket <path>.sock which 
+*   answers each connection with the status and closes it. Both hold one line of JSON
+*   with the counts of the last status_update, the throughput over the last 1, 5 and 15 
+*   minutes and the estimated seconds left. A thread started here does the work.
+*
+* INPUTS:
+*    path => the status file path
+*
+* OUTPUTS:
+*    live => the status
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int status_open(LIVE_STATUS* live, const char* path);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Gives a live status the coordinator's latest counts, they are shown from the next
+*   rewrite or connection on.
+*
+* INPUTS:
+*    live => the status, may be NULL for none
+*    snap => the counts
+*/
+void status_update(LIVE_STATUS* live, const STATUS_SNAP* snap);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Stops a live status, the file is written a last time and left, the socket is removed.
+*
+* INPUTS:
+*    live => the status
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int status_close(LIVE_STATUS* live);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Opens a runtime control socket, a Unix domain socket at path. Each connection sends 
+*   one command line and gets one reply line, once the coordinator has carried it out:
+*      pause | resume | drain [path] | cancel <pattern> | front <pattern> | slots <n> [rank]
+*   A pattern is a shell wildcard matched against the unit's line. A thread started here 
+*   takes the connections, see control_take for the coordinator's side.
+*
+* INPUTS:
+*    path => the socket path
+*
+* OUTPUTS:
+*    ctrl => the control socket
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int control_open(CONTROL* ctrl, const char* path);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Whether a command waits for the coordinator.
+*
+* INPUTS:
+*    ctrl => the control socket, may be NULL for none
+*
+* RETURN: 
+*   PX_YES or PX_NO
+*/
+int control_pending(CONTROL* ctrl);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Takes the command waiting for the coordinator, if there is one. Its client waits 
+*   for control_reply.
+*
+* INPUTS:
+*    ctrl => the control socket, may be NULL for none
+*
+* OUTPUTS:
+*    cmd => the command
+*
+* RETURN: 
+*   1 if a command was taken, 0 if there is none
+*/
+int control_take(CONTROL* ctrl, CONTROL_CMD* cmd);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Answers the command last taken with control_take.
+*
+* INPUTS:
+*    ctrl => the control socket
+*    msg => the reply, one line without its newline
+*/
+void control_reply(CONTROL* ctrl, const char* msg);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Closes a runtime control socket, a client still waiting is told the run is over. 
+*   The socket is removed.
+*
+* INPUTS:
+*    ctrl => the control socket
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int control_close(CONTROL* ctrl);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Opens a rank's timeline trace. With a communicator the call is collective on it, rank 0
+*   times round trips to the other ranks to line their clocks up with its own. A thread of
+*   a rank that records events of its own (the worker of --coord-work) gets a second trace 
+*   opened with MPI_COMM_NULL, it is written out with the rank's first (see trace_close).
+*
+* INPUTS:
+*    comm => the communicator of all the traced ranks, or MPI_COMM_NULL
+*    rank => the rank in comm
+*    role => PX_TRACE_COORD, PX_TRACE_WORKER, PX_TRACE_LEADER or PX_TRACE_MONITOR
+*
+* OUTPUTS:
+*    trace => the trace
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int trace_open(TRACE* trace, MPI_Comm comm, int rank, int role);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Records an event in a trace. Only the memory of the trace is touched, an event that 
+*   does not fit in PX_TRACE_MAX is counted and dropped.
+*
+* INPUTS:
+*    trace => the trace, may be NULL for none
+*    kind => a PX_TRACE_* event
+*    ts, dur => when it started and how long it took (ns, 0 for an instant)
+*    id => the unit id, or the units or number of the message
+*    peer => the rank of the other end of a message (MPI_COMM_WORLD), -1 if not known, 
+*            or PX_YES if the unit of PX_TRACE_RUN was killed (-m)
+*    val => the message tag, the relay flag of PX_TRACE_UNIT or the exit status of PX_TRACE_RUN 
+*    slot => the worker slot of PX_TRACE_RUN
+*/
+void trace_event(TRACE* trace, int kind, long long ts, long long dur, unsigned int id, int peer, int val, unsigned int slot);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Closes the traces of all the ranks, collective on the communicator of trace_open. Rank 0
+*   times the round trips again, takes each rank's events and writes them with its own to
+*   one Chrome trace (JSON) file, which Perfetto and chrome://tracing load. Each rank is a 
+*   process, with its scheduling messages, its worker's messages and each of its slots as
+*   threads. The clocks are lined up by the offsets of the two syncs, drifting linearly 
+*   between them. The buffers are freed.
+*
+* INPUTS:
+*    trace => the rank's trace
+*    also => the rank's second trace, NULL for none
+*    fname => the trace file path, only used on rank 0
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int trace_close(TRACE* trace, TRACE* also, const char* fname);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Opens an arg list (same format as work_store_open) to be read as the coordinator 
+*   dispatches it rather than loaded up front. The coordinator keeps no more than 
+*   window units in memory and stops reading while the window is full, so a producer
+*   writing into a pipe is held back to the pace of the workers.
+*
+* INPUTS:
+*    fname => The text file path, NULL for stdin
+*    window => The most units held at once, 0 for PX_STREAM_WINDOW
+*    etab => The executable table when the arg list has an exec column, else NULL
+*
+* OUTPUTS:
+*    wstream => the stream, see coordinate_proc
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int work_stream_open(WORK_STREAM* wstream, const char* fname, unsigned int window, EXEC_TABLE* etab);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Closes a stream opened with work_stream_open.
+*
+* INPUTS:
+*    wstream => the stream
+*/
+void work_stream_close(WORK_STREAM* wstream);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   This routine will dump our the args in a WORK_STORE using an index (see below).
+*
+* INPUTS:
+*   fname => The file path to dump the unit args to
+*   wstore => The list to dump
+*   windex => The index that contains the id's of the units in wstore to write.
+*             A 0 at index n implies don't dump, a 1 at index n implies dump the args 
+*   nindex => The number of items in windex 
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int dump_work_list_by_index( const char* fname, WORK_STORE* wstore, 
+                             unsigned char* windex, unsigned int nindex);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Writes units of a WORK_STORE out as their whole lines of the arg list, in arg list
+*   order. Unlike dump_work_list_by_index the exec column, an --lpt cost column and a
+*   --speculate "+" taken off by work_store_order and work_store_mark are kept, so the 
+*   file can be run again with the same options.
+*
+* INPUTS:
+*   fname => The file path to write the lines to
+*   wstore => The list, after any work_store_skip, work_store_order or work_store_mark
+*   windex => wstore->n flags by unit id, the units with a 0 are written
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int dump_work_list_as_listed(const char* fname, WORK_STORE* wstore, unsigned char* windex);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Routine prints a work unit list
+*
+* INPUTS:
+*    fout => output file pointer
+*    wstore => the unit list
+*
+*/
+void fprint_worklist(FILE* fout, WORK_STORE* wstore); 
+
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Routine prints a WORK_UNIT structure 
+*
+* INPUTS:
+*    fout => output file pointer
+*    work => the work unit list
+*
+* OUTPUTS:
+*    None
+*/
+void fprint_worku(FILE* fout, WORK_UNIT* worku);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Coordinator routine for asynchronous processing.
+*
+* INPUTS:
+*    wstore => the work units list, the results are recorded in it
+*    wstream => if not NULL the units are read from this stream as they are
+*               dispatched (see work_stream_open) and wstore is not used.
+*               No unit count is sent to the monitor then, so it can not 
+*               checkpoint.
+*    etab => the executable table, entry 0 is the processor script/program path
+*            which the workers already have. Other entries are sent to a worker 
+*            with the first unit that needs them.
+*    wcomm => the communicator the workers are in, MPI_COMM_WORLD or the
+*             node leader communicator for a node tree
+*    nworkers => the number of worker processors involved
+*    rankstart => the starting rank of the workers in wcomm (assume contiguous 
+*                 ranks, rankstart to rankstart+nworkers)
+*    moncomm => if a monitor process exists this is the communicator handle.
+*               This can be MPI_COMM_NULL...
+*    mnrank => if moncomm exists then this should be set to the rank
+*             the monitor has in moncomm group
+*    jrnl => if not NULL each completed unit is recorded in this journal
+*    hist => if not NULL each completed unit's run time is added to this history
+*    sparams => scheduling parameters. With sparams->chunkmax > 1 each dispatch
+*               carries a batch of units sized by guided self-scheduling, i.e. 
+*               large batches while the queue is long shrinking to 1 unit at the tail.
+*               With sparams->depth > 1 each worker is kept up to depth batches ahead 
+*               so its next unit is already local when the current one finishes.
+*               With sparams->dispcomm set the coordinator's rank may also be a worker.
+*               With sparams->speculate > 0 the units wstore->dupok marks may get a 
+*               backup copy at the tail of the run, the other copy is cancelled 
+*               (CANCELWORK) when one finishes.
+*    verbose => the verbosity level
+*    verbout => the verbosity file stream
+*
+* OUTPUTS:
+*    sstats => message and backup counters for the run
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int coordinate_proc( WORK_STORE* wstore, WORK_STREAM* wstream, 
+                     EXEC_TABLE* etab, MPI_Comm wcomm, int nworkers, int rankstart, 
+                     MPI_Comm moncomm, int mnrank, JOURNAL* jrnl, HISTORY* hist,
+                     SCHED_PARAMS* sparams, SCHED_STATS* sstats,
+                     unsigned int verbose, FILE* verbout
+                   );
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   worker routine for asynchronous processing. Each dispatch message may carry
+*   a batch of units, they are started in order and reported back in one message.
+*   Messages that arrive while units run are queued (prefetch) and the report
+*   is sent nonblocking so the next queued unit starts right away. Up to nslots
+*   units run at once, each in its own process group with its own time limit.
+*
+* INPUTS:
+*    comm => the communicator shared with the coordinator, which is rank 0 in it
+*            (MPI_COMM_WORLD, or a node communicator under a node leader)
+*    rank => the worker's rank
+*    proc => the processor script/program path broadcast at startup
+*    wparams => the number of units run at once (child processes), the max run 
+*               time a unit is allowed (signals must be present on the platform),
+*               whether the units are run without a shell, and the workers' ranks
+*               and incoming communicator. With wparams->incomm set rank 0 may run 
+*               work_proc in a thread beside coordinate_proc (needs MPI_THREAD_MULTIPLE).
+*               The worker holds queued units back to its launchrate and until 
+*               startmsecs have gone by, it keeps taking in work while it waits.
+*    verbose => the verbosity level
+*    verbout => the verbosity file stream
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int work_proc( MPI_Comm comm, int rank, const char* proc, WORK_PARAMS* wparams, 
+               unsigned int verbose, FILE* verbout );
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Node leader routine for the node tree. To the coordinator the leader looks
+*   like a worker with the slots of all its local workers: it takes batches from rank 0
+*   of upcomm and reports completions back, several units per message. To the 
+*   other ranks of its node it is the coordinator, handing the units out over
+*   nodecomm with the same batching and prefetch rules. Only the leaders talk
+*   to the coordinator so its message load scales with nodes, not ranks.
+*
+* INPUTS:
+*    upcomm => the communicator shared with the coordinator (rank 0)
+*    nodecomm => the node communicator, the leader is rank 0, the local workers 1 to size-1
+*    rank => the leader's rank
+*    proc => the processor script/program path broadcast at startup
+*    sparams => scheduling parameters for the local workers
+*    verbose => the verbosity level
+*    verbout => the verbosity file stream
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int subcoord_proc( MPI_Comm upcomm, MPI_Comm nodecomm, int rank, const char* proc, 
+                   SCHED_PARAMS* sparams, unsigned int verbose, FILE* verbout );
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Sets up RMA scheduling, collective over comm. Rank 0 passes the loaded arg list, 
+*   its unit count and exec table are broadcast and its arrays are exposed in RMA 
+*   windows. The workers map the arg list themselves (a shared file system is assumed) 
+*   but do not index it, the offsets of the units they claim are read from rank 0.
+*
+* INPUTS:
+*    comm => the communicator of the whole job, the coordinator is rank 0
+*    rank => the caller's rank in comm
+*    wstore => rank 0's loaded arg list, NULL on the other ranks
+*    etab => rank 0's exec table, NULL on the other ranks
+*    fname => the arg list path on a worker, NULL on rank 0 and the monitor
+*
+* OUTPUTS:
+*    rsched => the windows, see rma_coordinate_proc and rma_work_proc
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int rma_sched_open( RMA_SCHED* rsched, MPI_Comm comm, int rank, WORK_STORE* wstore, 
+                    EXEC_TABLE* etab, const char* fname );
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Frees the windows of rma_sched_open, collective over its comm.
+*/
+void rma_sched_close(RMA_SCHED* rsched);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   The coordinator of an RMA scheduled run. No unit passes through it, it polls the 
+*   completion bitmap every PX_RMA_POLL_MSECS to pass completed units to the journal
+*   and the monitor (if any) and returns once every unit is done. The results are 
+*   then in wstore.
+*
+* INPUTS:
+*    rsched => from rma_sched_open
+*    wstore => the arg list given to rma_sched_open
+*    moncomm => if a monitor process exists this is the communicator handle.
+*               This can be MPI_COMM_NULL...
+*    mnrank => if moncomm exists then this should be set to the rank
+*             the monitor has in moncomm group
+*    jrnl => if not NULL each completed unit is recorded in this journal
+*    hist => if not NULL each completed unit's run time is added to this history
+*    verbose => the verbosity level
+*    verbout => the verbosity file stream
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int rma_coordinate_proc( RMA_SCHED* rsched, WORK_STORE* wstore, MPI_Comm moncomm, int mnrank,
+                         JOURNAL* jrnl, HISTORY* hist, unsigned int verbose, FILE* verbout );
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   The worker of an RMA scheduled run, see work_proc. Units are claimed from the 
+*   shared counter in guided self-scheduling sized chunks (up to sparams->chunkmax per 
+*   slot) whenever the queue runs short, and the worker returns once the counter 
+*   passes the last unit and its units are done.
+*
+* INPUTS:
+*    rsched => from rma_sched_open
+*    rank => the worker's rank
+*    wparams => see work_proc
+*    sparams => the chunk limit, prefetch depth and slots per worker
+*    nworkers => the number of workers, for the chunk sizes
+*    verbose => the verbosity level
+*    verbout => the verbosity file stream
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int rma_work_proc( RMA_SCHED* rsched, int rank, WORK_PARAMS* wparams, SCHED_PARAMS* sparams,
+                   int nworkers, unsigned int verbose, FILE* verbout );
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   A monitor routine for asynchronous event handling.
+* INPUTS:
+*    coorcomm => communicator handle, for 'talking' to the coordinator proc.
+*    crank => the coordinator's rank for the sub comm coorcomm 
+*    wrank => the rank for comm world
+*    preexit => Notify of a pre-exit event n seconds before the scheduling 
+*               facility is due to terminate this pxargs job. This is a 
+*               suggested time, it will not be exact (libpbs required).
+*    verbose => the verbosity level
+*    verbout => the verbosity file stream
+* 
+* OUTPUTS:
+*    itemidx => An boolean array for which items were completed (1=yes, 0=no).
+*               Note, this array runs 'parallel' to the work units list id's 
+*               (wunits parameter in coordinate_proc), e.g. index[20] is work unit
+*               with id 20.
+*    ni => The length of itemidx.
+*
+* RETURN: 
+*   A value of 0 implies a successful run, i.e. nothing out of the ordinary happened
+*   A value of < 0 implies something failed badly
+*   A value of 1 implies a forced early exit notice by the scheduling.
+*   A value of 2 implies a normal exit with some items not completed (they failed,
+*   the coordinator does not report those).
+*
+* NOTES:
+*   The caller is responsible for freeing itemidx if it is not NULL
+*/
+int monitor_proc( MPI_Comm coorcomm, int crank, int wrank, 
+                  unsigned int preexit, unsigned char** itemidx, 
+                  unsigned int* ni, unsigned int verbose, 
+                  FILE* verbout );
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*  Returns the packed size of a WORK_UNIT. Only the bytes in use by the
+*  pargs and procpath strings are counted, see mpi_worku_serialize.
+*
+* INPUTS:
+*   work => the work unit to size
+*
+* RETURN: 
+*   The number of bytes.
+*/
+int mpi_sizeof_worku(WORK_UNIT* work);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Packs a work unit structure for sending/passing. The wire format is:
+*     unsigned version (WU_WIRE_VERSION)
+*     unsigned nfields
+*     long     fields[nfields] (see WU_F_* offsets)
+*     char     pargs[fields[WU_F_ARGLEN]] (not NUL terminated)
+*     char     procpath[fields[WU_F_PATHLEN]] (not NUL terminated)
+*   A unit with pargs or procpath set to NULL is packed with a zero length for
+*   that string. The procpath is only sent the first time a worker needs the
+*   executable for fields[WU_F_EXECIDX], see EXEC_TABLE.
+*
+* INPUTS:
+*   work => the work structure to serialize
+*   bufsize => the buffer size
+*   position => the offset in buf to start packing at 
+*
+* OUTPUTS:
+*   buf => a buffer, which should be of adequate size, that the work unit is packed into
+*   position => updated to the end of the packed unit
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed (buffer too small)
+*/
+int mpi_worku_serialize(WORK_UNIT* work, void* buf, int bufsize, int* position);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Unpacks a work unit structure. Header fields beyond WU_NFIELDS are skipped and
+*   fields missing from an older sender are left as 0.
+*
+* INPUTS:
+*   buf => a buffer that was packed by mpi_worku_serialize
+*   bufsize => the number of packed bytes in buf
+*   position => the offset in buf to start unpacking at 
+*
+* OUTPUTS:
+*   work => the work structure with the data from buf, work->pargs and work->procpath
+*           are heap allocated (or NULL if not sent) and should be freed by the caller
+*   position => updated to the end of the unpacked unit
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed (bad version or short buffer)
+*/
+int mpi_worku_unserialize(void* buf, int bufsize, int* position, WORK_UNIT* work);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*  Returns the packed size of a work message, a batch of n work units. 
+*
+* INPUTS:
+*   units => the work units in the message
+*   n => the number of units
+*
+* RETURN: 
+*   The number of bytes.
+*/
+int mpi_sizeof_workmsg(WORK_UNIT** units, unsigned int n);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Packs a work message. Dispatch (DOWORK) and completion (COMPLETED_WORK) messages 
+*   carry one or more units:
+*     unsigned n
+*     n units packed with mpi_worku_serialize
+*
+* INPUTS:
+*   units => the work units to serialize
+*   n => the number of units
+*   bufsize => the buffer size
+*   position => the offset in buf to start packing at 
+*
+* OUTPUTS:
+*   buf => a buffer of at least mpi_sizeof_workmsg bytes
+*   position => updated to the end of the packed message
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
+*/
+int mpi_workmsg_serialize(WORK_UNIT** units, unsigned int n, void* buf, int bufsize, int* position);
+
+/*--------------------------------------------------------------------------------------------
+* 
+* DESCRIPTION:
+*   Unpacks the unit count of a work message, the units follow and are unpacked 
+*   with mpi_worku_unserialize.
+*
+* INPUTS:
+*   buf => a buffer that was packed by mpi_workmsg_serialize
+*   bufsize => the number of packed bytes in buf
+*   position => the offset in buf to start unpacking at 
+*
+* OUTPUTS:
+*   n => the number of units in the message
+*   position => updated to the first unit
+*
+* RETURN: 
+*   A value of 0 = success, < 0 = failed
 */
-void mpi_worku_unserialize(void* buf, int bufsize, WORK_UNIT* work);
+int mpi_workmsg_nunits(void* buf, int bufsize, int* position, unsigned int* n);
 
 #endif
@@ -0,0 +1,301 @@
+/*$**************************************************************************
+*
+* FILE:
+*    pxctrl.c
+*
+* AUTHOR:
+*    Andrew Michaelis, amac@hyperplane.org
+*
+* FILE VERSION:
+*    0.0.1
+*
+* LICENSE:
+*  This file is part of pxargs.
+*
+*  pxargs is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  pxargs is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with pxargs. If not, see http://www.gnu.org/licenses/.
+*
+*  Copyright (C) 2012, 2014, 2015 Andrew Michaelis
+*
+***************************************************************************$*/
+#ifdef HAVE_CONFIG_H
+ #include <config.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+
+#include <sys/types.h>
+#ifdef HAVE_POLL_H
+ #include <poll.h>
+#endif
+#ifdef HAVE_SYS_SOCKET_H
+ #include <sys/socket.h>
+#endif
+
+#include <pxargs.h>
+
+/* the reply to a line that is not a command */
+#define CTRL_USAGE "error: the commands are pause, resume, drain [path], cancel <pattern>, front <pattern>, slots <n> [rank]"
+
+/* module error note */
+static const char* SRC_FILE = __FILE__;
+
+/*--------------------------------------------------------------------
+* Local module routine, reads a client's command line into buf (PX_CTRL_LNMAX
+* long) without its newline, waiting at most PX_CTRL_READ_MSECS. Returns its
+* length, < 0 if none came.
+*/
+static int ctrl_read(int cfd, char* buf)
+{
+   struct pollfd pfd;
+   ssize_t nr;
+   int len = 0;
+
+   pfd.fd = cfd;
+   pfd.events = POLLIN;
+   while(len < (PX_CTRL_LNMAX - 1))
+   {
+      pfd.revents = 0;
+      if(poll(&pfd, 1, PX_CTRL_READ_MSECS) <= 0)
+         return -1;
+      if( (nr = read(cfd, &(buf[len]), (size_t)(PX_CTRL_LNMAX - 1 - len))) < 0)
+      {
+         if(errno == EINTR)
+            continue;
+         return -1;
+      }
+      if(nr == 0)
+         break;
+      len += (int)nr;
+      if(memchr(buf, '\n', (size_t)len) != NULL)
+         break;
+   }
+   buf[len] = '\0';
+   /* the line ends at the first newline, trailing blanks are dropped */
+   len = (int)strcspn(buf, "\r\n");
+   while( (len > 0) && isspace((unsigned char)buf[len-1]) )
+      len--;
+   buf[len] = '\0';
+   return len;
+}/* ctrl_read */
+
+/*--------------------------------------------------------------------
+* Local module routine, a command line into cmd. Returns 0, or < 0 if it 
+* is not a command.
+*/
+static int ctrl_parse(char* line, CONTROL_CMD* cmd)
+{
+   char* arg;
+   char* end;
+   size_t wlen;
+   long v;
+
+   memset(cmd, 0, sizeof(CONTROL_CMD));
+   cmd->rank = -1;
+   while(isspace((unsigned char)*line))
+      line++;
+   wlen = strcspn(line, " \t");
+   for(arg = &(line[wlen]); isspace((unsigned char)*arg); arg++)
+      ;
+   if( (wlen == 5) && (strncmp(line, "pause", wlen) == 0) && (*arg == '\0') )
+      cmd->op = PX_CTRL_PAUSE;
+   else if( (wlen == 6) && (strncmp(line, "resume", wlen) == 0) && (*arg == '\0') )
+      cmd->op = PX_CTRL_RESUME;
+   else if( (wlen == 5) && (strncmp(line, "drain", wlen) == 0) )
+      cmd->op = PX_CTRL_DRAIN;
+   else if( (wlen == 6) && (strncmp(line, "cancel", wlen) == 0) && (*arg != '\0') )
+      cmd->op = PX_CTRL_CANCEL;
+   else if( (wlen == 5) && (strncmp(line, "front", wlen) == 0) && (*arg != '\0') )
+      cmd->op = PX_CTRL_FRONT;
+   else if( (wlen == 5) && (strncmp(line, "slots", wlen) == 0) )
+   {
+      /* a count of at least 1 and maybe a rank */
+      if( ((v = strtol(arg, &end, 10)) < 1) || (end == arg) )
+         return -1;
+      cmd->n = (unsigned int) v;
+      for(arg = end; isspace((unsigned char)*arg); arg++)
+         ;
+      if(*arg != '\0')
+      {
+         if( ((v = strtol(arg, &end, 10)) < 0) || (end == arg) || (*end != '\0') )
+            return -1;
+         cmd->rank = (int) v;
+      }
+      cmd->op = PX_CTRL_SLOTS;
+      return 0;
+   }
+   else
+      return -1;
+   strcpy(cmd->arg, arg);
+   return 0;
+}/* ctrl_parse */
+
+/*--------------------------------------------------------------------
+* Local module routine, serves one connection: its command is handed to 
+* the coordinator and the client gets the reply
+*/
+static void ctrl_serve(CONTROL* ctrl, int cfd)
+{
+   CONTROL_CMD cmd;
+   char buf[PX_CTRL_LNMAX + 1];
+
+   if(ctrl_read(cfd, buf) <= 0)
+      return;
+   if(ctrl_parse(buf, &cmd) < 0)
+      strcpy(buf, CTRL_USAGE);
+   else
+   {
+      pthread_mutex_lock(&(ctrl->mtx));
+      if(ctrl->stop == PX_YES)
+         strcpy(buf, "error: the run is over");
+      else
+      {
+         ctrl->cmd = cmd;
+         ctrl->replied = PX_NO;
+         ctrl->pending = PX_YES;
+         while( (ctrl->replied == PX_NO) && (ctrl->stop == PX_NO) )
+            pthread_cond_wait(&(ctrl->cond), &(ctrl->mtx));
+         strcpy(buf, ((ctrl->replied == PX_YES) ? ctrl->reply : "error: the run is over"));
+         ctrl->pending = PX_NO;
+      }
+      pthread_mutex_unlock(&(ctrl->mtx));
+   }
+   strcat(buf, "\n");
+   sock_server_send(cfd, buf, strlen(buf));
+}/* ctrl_serve */
+
+/*--------------------------------------------------------------------
+* Local module routine, the control thread: a connection at a time until
+* the stop pipe wakes it
+*/
+static void* ctrl_run(void* targs)
+{
+   CONTROL* ctrl = (CONTROL*) targs;
+   int rc, cfd;
+
+   while( (rc = sock_server_wait(&(ctrl->srv), -1)) >= 0)
+   {
+      if( (rc == 1) && ((cfd = accept(ctrl->srv.sfd, NULL, NULL)) >= 0) )
+      {
+         ctrl_serve(ctrl, cfd);
+         close(cfd);
+      }
+   }
+   return NULL;
+}/* ctrl_run */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int control_open(CONTROL* ctrl, const char* path)
+{
+   int per;
+
+   memset(ctrl, 0, sizeof(CONTROL));
+   /* a connection at a time, the thread waits in accept for it */
+   if( sock_server_open(&(ctrl->srv), path, "control", PX_NO) < 0)
+      return -1;
+   if( (per = pthread_mutex_init(&(ctrl->mtx), NULL)) != 0)
+   {
+      fprintf(stderr, "%s @L %d : pthread_mutex_init Failed (pthrd error %d)\n", SRC_FILE, __LINE__, per);
+      sock_server_close(&(ctrl->srv));
+      return -1;
+   }
+   if( (per = pthread_cond_init(&(ctrl->cond), NULL)) != 0)
+   {
+      fprintf(stderr, "%s @L %d : pthread_cond_init Failed (pthrd error %d)\n", SRC_FILE, __LINE__, per);
+      pthread_mutex_destroy(&(ctrl->mtx));
+      sock_server_close(&(ctrl->srv));
+      return -1;
+   }
+   if( sock_server_start(&(ctrl->srv), ctrl_run, (void*) ctrl) < 0)
+   {
+      pthread_cond_destroy(&(ctrl->cond));
+      pthread_mutex_destroy(&(ctrl->mtx));
+      sock_server_close(&(ctrl->srv));
+      return -1;
+   }
+   return 0;
+}/* control_open */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int control_pending(CONTROL* ctrl)
+{
+   int pending;
+
+   if(ctrl == NULL)
+      return PX_NO;
+   pthread_mutex_lock(&(ctrl->mtx));
+   pending = ((ctrl->pending == PX_YES) && (ctrl->replied == PX_NO)) ? PX_YES : PX_NO;
+   pthread_mutex_unlock(&(ctrl->mtx));
+   return pending;
+}/* control_pending */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int control_take(CONTROL* ctrl, CONTROL_CMD* cmd)
+{
+   int taken = 0;
+
+   if(ctrl == NULL)
+      return 0;
+   pthread_mutex_lock(&(ctrl->mtx));
+   if( (ctrl->pending == PX_YES) && (ctrl->replied == PX_NO) )
+   {
+      *cmd = ctrl->cmd;
+      taken = 1;
+   }
+   pthread_mutex_unlock(&(ctrl->mtx));
+   return taken;
+}/* control_take */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void control_reply(CONTROL* ctrl, const char* msg)
+{
+   pthread_mutex_lock(&(ctrl->mtx));
+   snprintf(ctrl->reply, PX_CTRL_LNMAX, "%s", msg);
+   ctrl->replied = PX_YES;
+   pthread_cond_broadcast(&(ctrl->cond));
+   pthread_mutex_unlock(&(ctrl->mtx));
+}/* control_reply */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int control_close(CONTROL* ctrl)
+{
+   if(ctrl->srv.running != PX_YES)
+      return 0;
+   /* a client waiting on a reply is let go first */
+   pthread_mutex_lock(&(ctrl->mtx));
+   ctrl->stop = PX_YES;
+   pthread_cond_broadcast(&(ctrl->cond));
+   pthread_mutex_unlock(&(ctrl->mtx));
+   sock_server_close(&(ctrl->srv));
+   pthread_cond_destroy(&(ctrl->cond));
+   pthread_mutex_destroy(&(ctrl->mtx));
+   memset(ctrl, 0, sizeof(CONTROL));
+   return 0;
+}/* control_close */
@@ -0,0 +1,255 @@
+/*$**************************************************************************
+*
+* FILE:
+*    pxhist.c
+*
+* AUTHOR:
+*    Andrew Michaelis, amac@hyperplane.org
+*
+* FILE VERSION:
+*    0.0.1
+*
+* LICENSE:
+*  This file is part of pxargs.
+*
+*  pxargs is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  pxargs is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with pxargs. If not, see http://www.gnu.org/licenses/.
+*
+*  Copyright (C) 2012, 2014, 2015 Andrew Michaelis
+*
+***************************************************************************$*/
+#ifdef HAVE_CONFIG_H
+ #include <config.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <pxargs.h>
+
+/* the longest entry line, a hash and three numbers */
+#define HIST_LNMAX 128
+
+/* written at the top of the file, '#' lines are skipped by history_load */
+#define HIST_HEADER "# pxargs history: <hash> <runs> <kills> <secs>\n"
+
+/* module error note */
+static const char* SRC_FILE = __FILE__;
+
+/*--------------------------------------------------------------------
+* Local module routine, the 64 bit FNV-1a hash of the executable and args,
+* 0 marks an empty table entry so it is never a key.
+*/
+static unsigned long long hist_key(const char* proc, const char* args, size_t alen)
+{
+   unsigned long long h = 14695981039346656037ULL;
+   size_t i;
+
+   for(i = 0; (proc != NULL) && (proc[i] != '\0'); i++)
+      h = (h ^ (unsigned char)proc[i]) * 1099511628211ULL;
+   h = (h ^ 0) * 1099511628211ULL;
+   for(i = 0; (args != NULL) && (i < alen); i++)
+      h = (h ^ (unsigned char)args[i]) * 1099511628211ULL;
+   return ((h == 0) ? 1 : h);
+}/* hist_key */
+
+/*--------------------------------------------------------------------
+* Local module routine, the entry for key, or the empty one it would go in.
+* The table is never full (see hist_grow).
+*/
+static HISTORY_ENTRY* hist_slot(HISTORY* hist, unsigned long long key)
+{
+   size_t i;
+
+   for(i = (size_t)(key & (hist->cap - 1)); ; i = (i + 1) & (hist->cap - 1))
+   {
+      if( (hist->ents[i].key == key) || (hist->ents[i].key == 0) )
+         return &(hist->ents[i]);
+   }
+}/* hist_slot */
+
+/*--------------------------------------------------------------------
+* Local module routine, doubles the table once it is half full.
+*/
+static int hist_grow(HISTORY* hist)
+{
+   HISTORY_ENTRY* old = hist->ents;
+   size_t i, ocap = hist->cap;
+
+   if( (hist->ents != NULL) && (2 * (hist->n + 1) <= hist->cap) )
+      return 0;
+   hist->cap = (ocap > 0) ? (2 * ocap) : PX_HIST_INIT;
+   if( (hist->ents = (HISTORY_ENTRY*) calloc(hist->cap, sizeof(HISTORY_ENTRY))) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : calloc error for history : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      hist->ents = old;
+      hist->cap = ocap;
+      return -1;
+   }
+   for(i = 0; i < ocap; i++)
+   {
+      if(old[i].key != 0)
+         *hist_slot(hist, old[i].key) = old[i];
+   }
+   free(old);
+   return 0;
+}/* hist_grow */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int history_load(HISTORY* hist, const char* fname)
+{
+   FILE* fin;
+   char lnbuf[HIST_LNMAX];
+   HISTORY_ENTRY ent, *e;
+   size_t len;
+
+   memset(hist, 0, sizeof(HISTORY));
+   if(hist_grow(hist) < 0)
+      return -1;
+   if( (fin = fopen(fname, "r")) == NULL)
+   {
+      if(errno == ENOENT)
+         return 0;
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      history_free(hist);
+      return -1;
+   }
+   while(fgets(lnbuf, HIST_LNMAX, fin) != NULL)
+   {
+      /* skip what is not a whole entry, a later entry for a key replaces an earlier one */
+      len = strlen(lnbuf);
+      if( (len == 0) || (lnbuf[len-1] != '\n') || (lnbuf[0] == '#') )
+         continue;
+      memset(&ent, 0, sizeof(HISTORY_ENTRY));
+      if( (sscanf(lnbuf, "%llx %u %u %lf", &(ent.key), &(ent.runs), &(ent.kills), &(ent.secs)) != 4) || 
+          (ent.key == 0) || (ent.runs == 0) )
+         continue;
+      if(hist_grow(hist) < 0)
+      {
+         fclose(fin);
+         history_free(hist);
+         return -1;
+      }
+      if( (e = hist_slot(hist, ent.key))->key == 0)
+         hist->n += 1;
+      *e = ent;
+   }
+   if(ferror(fin))
+   {
+      fprintf(stderr, "%s @L %d : read error for \"%s\"\n", SRC_FILE, __LINE__, fname);
+      fclose(fin);
+      history_free(hist);
+      return -1;
+   }
+   fclose(fin);
+   return 0;
+}/* history_load */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+HISTORY_ENTRY* history_lookup(HISTORY* hist, const char* proc, const char* args, size_t alen)
+{
+   HISTORY_ENTRY* e;
+
+   if( (hist == NULL) || (hist->ents == NULL) )
+      return NULL;
+   e = hist_slot(hist, hist_key(proc, args, alen));
+   return ((e->key != 0) ? e : NULL);
+}/* history_lookup */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int history_record(HISTORY* hist, const char* proc, const char* args, size_t alen, double secs, int killed)
+{
+   HISTORY_ENTRY* e;
+   unsigned long long key;
+   unsigned int w;
+
+   if(hist == NULL)
+      return 0;
+   key = hist_key(proc, args, alen);
+   if(hist_grow(hist) < 0)
+      return -1;
+   if( (e = hist_slot(hist, key))->key == 0)
+   {
+      e->key = key;
+      hist->n += 1;
+   }
+   /* the mean of the runs so far, then a moving average over about PX_HIST_WINDOW runs */
+   e->runs += 1;
+   w = (e->runs < PX_HIST_WINDOW) ? e->runs : PX_HIST_WINDOW;
+   e->secs += (((secs > 0.0) ? secs : 0.0) - e->secs) / (double)w;
+   if(killed != 0)
+      e->kills += 1;
+   hist->nrec += 1;
+   return 0;
+}/* history_record */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int history_save(HISTORY* hist, const char* fname)
+{
+   FILE* fout;
+   char* tmpname;
+   size_t i;
+   int rc = 0;
+
+   if( (tmpname = (char*) malloc(strlen(fname) + 8)) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   /* written aside and renamed over the old one, so a kill leaves one or the other */
+   sprintf(tmpname, "%s.tmp", fname);
+   if( (fout = fopen(tmpname, "w")) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, tmpname, strerror(errno));
+      free(tmpname);
+      return -1;
+   }
+   fputs(HIST_HEADER, fout);
+   for(i = 0; i < hist->cap; i++)
+   {
+      if(hist->ents[i].key != 0)
+         fprintf(fout, "%016llx %u %u %.3f\n", hist->ents[i].key, hist->ents[i].runs, hist->ents[i].kills, hist->ents[i].secs);
+   }
+   if( (fflush(fout) != 0) || (fsync(fileno(fout)) < 0) )
+      rc = -1;
+   if( (fclose(fout) != 0) || (rc < 0) || (rename(tmpname, fname) < 0) )
+   {
+      fprintf(stderr, "%s @L %d : failed to write \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      unlink(tmpname);
+      rc = -1;
+   }
+   free(tmpname);
+   return rc;
+}/* history_save */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void history_free(HISTORY* hist)
+{
+   free(hist->ents);
+   memset(hist, 0, sizeof(HISTORY));
+}/* history_free */
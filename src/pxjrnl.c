@@ -0,0 +1,237 @@
+/*$**************************************************************************
+*
+* FILE:
+*    pxjrnl.c
+*
+* AUTHOR:
+*    Andrew Michaelis, amac@hyperplane.org
+*
+* FILE VERSION:
+*    0.0.1
+*
+* LICENSE:
+*  This file is part of pxargs.
+*
+*  pxargs is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  pxargs is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with pxargs. If not, see http://www.gnu.org/licenses/.
+*
+*  Copyright (C) 2012, 2014, 2015 Andrew Michaelis
+*
+***************************************************************************$*/
+#ifdef HAVE_CONFIG_H
+ #include <config.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_FCNTL_H
+ #include <fcntl.h>
+#endif
+
+#include <pxargs.h>
+
+/* the longest record, five numbers and their separators */
+#define JRNL_RECMAX 96
+
+/* written at the top of a new journal, '#' lines are skipped by journal_load */
+#define JRNL_HEADER "# pxargs journal: <id> <secs> <rank> <killed> <status>\n"
+
+/* module error note */
+static const char* SRC_FILE = __FILE__;
+
+/*--------------------------------------------------------------------
+* Local module routine, writes all of buf to fd.
+*/
+static int jrnl_write(int fd, const char* buf, size_t len)
+{
+   ssize_t nw;
+   size_t off = 0;
+
+   while(off < len)
+   {
+      if( (nw = write(fd, &(buf[off]), len - off)) < 0)
+      {
+         if(errno == EINTR)
+            continue;
+         fprintf(stderr, "%s @L %d : journal write error : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
+      }
+      off += (size_t)nw;
+   }
+   return 0;
+}/* jrnl_write */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int journal_open(JOURNAL* jrnl, const char* fname)
+{
+   struct stat sbuf;
+   char last = '\n';
+
+   memset(jrnl, 0, sizeof(JOURNAL));
+   if( (jrnl->fd = open(fname, O_RDWR | O_CREAT | O_APPEND, 0644)) < 0)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      return -1;
+   }
+   if( (jrnl->buf = (char*) malloc(PX_JRNL_BATCH * JRNL_RECMAX)) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for journal buffer : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      close(jrnl->fd);
+      jrnl->fd = -1;
+      return -1;
+   }
+   jrnl->cap = PX_JRNL_BATCH * JRNL_RECMAX;
+   if(fstat(jrnl->fd, &sbuf) < 0)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      journal_close(jrnl);
+      return -1;
+   }
+   if(sbuf.st_size == 0)
+   {
+      memcpy(jrnl->buf, JRNL_HEADER, strlen(JRNL_HEADER));
+      jrnl->len = strlen(JRNL_HEADER);
+   }
+   /* end a record cut short by a kill so the next one is not run into it */
+   else if( (pread(jrnl->fd, &last, 1, sbuf.st_size - 1) == 1) && (last != '\n') )
+   {
+      jrnl->buf[0] = '\n';
+      jrnl->len = 1;
+   }
+   return 0;
+}/* journal_open */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int journal_record(JOURNAL* jrnl, unsigned int id, long secs, int rank, int killed, int status)
+{
+   int nc;
+
+   if(jrnl == NULL)
+      return 0;
+   if( (jrnl->len + JRNL_RECMAX > jrnl->cap) && (journal_flush(jrnl, PX_YES) < 0) )
+      return -1;
+   if( (nc = snprintf(&(jrnl->buf[jrnl->len]), JRNL_RECMAX, "%u %ld %d %d %d\n", id, ((secs > 0) ? secs : 0L), rank, killed, status)) < 0)
+      return -1;
+   if(jrnl->npend == 0)
+      jrnl->age = MPI_Wtime();
+   jrnl->len += (size_t)nc;
+   jrnl->npend += 1;
+   return journal_flush(jrnl, PX_NO);
+}/* journal_record */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int journal_flush(JOURNAL* jrnl, int force)
+{
+   if( (jrnl == NULL) || (jrnl->len == 0) )
+      return 0;
+   if( (force == PX_NO) && (jrnl->npend < PX_JRNL_BATCH) &&
+       ((MPI_Wtime() - jrnl->age) < (PX_JRNL_SYNC_MSECS / 1000.0)) )
+      return 0;
+   if( jrnl_write(jrnl->fd, jrnl->buf, jrnl->len) < 0)
+      return -1;
+   /* one sync for the whole group */
+#ifdef HAVE_FDATASYNC
+   if(fdatasync(jrnl->fd) < 0)
+#else
+   if(fsync(jrnl->fd) < 0)
+#endif
+   {
+      fprintf(stderr, "%s @L %d : journal sync error : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   jrnl->len = 0;
+   jrnl->npend = 0;
+   return 0;
+}/* journal_flush */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int journal_close(JOURNAL* jrnl)
+{
+   int rc = 0;
+
+   if(jrnl->fd >= 0)
+   {
+      rc = journal_flush(jrnl, PX_YES);
+      if(close(jrnl->fd) < 0)
+         rc = -1;
+   }
+   free(jrnl->buf);
+   memset(jrnl, 0, sizeof(JOURNAL));
+   jrnl->fd = -1;
+   return rc;
+}/* journal_close */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int journal_load(const char* fname, unsigned char* done, unsigned int n, unsigned int* ndone)
+{
+   FILE* fin;
+   char lnbuf[JRNL_RECMAX];
+   unsigned long id;
+   long secs;
+   int rank, killed, status, nf;
+   size_t len;
+
+   *ndone = 0;
+   if( (fin = fopen(fname, "r")) == NULL)
+   {
+      if(errno == ENOENT)
+         return 0;
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      return -1;
+   }
+   while(fgets(lnbuf, JRNL_RECMAX, fin) != NULL)
+   {
+      /* a record is only whole with its newline and all of its fields, the 
+         start of one cut short may have been ended by journal_open */
+      len = strlen(lnbuf);
+      if( (len == 0) || (lnbuf[len-1] != '\n') || (lnbuf[0] == '#') )
+         continue;
+      /* the status is missing from the records of older journals, those units are done */
+      status = 0;
+      if( ((nf = sscanf(lnbuf, "%lu %ld %d %d %d", &id, &secs, &rank, &killed, &status)) < 4) || (id >= (unsigned long)n) )
+         continue;
+      if( (nf == 5) && ((killed != 0) || (status != 0)) )
+         continue;
+      if(done[id] == 0)
+      {
+         done[id] = 1;
+         *ndone += 1;
+      }
+   }
+   if(ferror(fin))
+   {
+      fprintf(stderr, "%s @L %d : read error for \"%s\"\n", SRC_FILE, __LINE__, fname);
+      fclose(fin);
+      return -1;
+   }
+   fclose(fin);
+   return 0;
+}/* journal_load */
@@ -0,0 +1,219 @@
+/*$**************************************************************************
+*
+* FILE:
+*    pxsock.c
+*
+* AUTHOR:
+*    Andrew Michaelis, amac@hyperplane.org
+*
+* FILE VERSION:
+*    0.0.1
+*
+* LICENSE:
+*  This file is part of pxargs.
+*
+*  pxargs is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  pxargs is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with pxargs. If not, see http://www.gnu.org/licenses/.
+*
+*  Copyright (C) 2012, 2014, 2015 Andrew Michaelis
+*
+***************************************************************************$*/
+#ifdef HAVE_CONFIG_H
+ #include <config.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_FCNTL_H
+ #include <fcntl.h>
+#endif
+#ifdef HAVE_POLL_H
+ #include <poll.h>
+#endif
+#ifdef HAVE_SIGNAL_H 
+ #include <signal.h>
+#endif
+#ifdef HAVE_SYS_SOCKET_H
+ #include <sys/socket.h>
+#endif
+#ifdef HAVE_SYS_UN_H
+ #include <sys/un.h>
+#endif
+
+#include <pxargs.h>
+
+/* a client that hangs up early is no reason to stop */
+#ifndef MSG_NOSIGNAL
+ #define MSG_NOSIGNAL 0
+#endif
+
+/* module error note */
+static const char* SRC_FILE = __FILE__;
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int sock_server_open(SOCK_SERVER* srv, const char* path, const char* what, int nonblock)
+{
+   struct sockaddr_un addr;
+   struct stat sbuf;
+
+   memset(srv, 0, sizeof(SOCK_SERVER));
+   srv->sfd = -1;
+   srv->pfd[0] = -1;
+   srv->pfd[1] = -1;
+   memset(&addr, 0, sizeof(struct sockaddr_un));
+   addr.sun_family = AF_UNIX;
+   if(strlen(path) >= sizeof(addr.sun_path))
+   {
+      fprintf(stderr, "%s @L %d : the %s socket path \"%s\" is too long (%u bytes at most)\n", SRC_FILE, __LINE__, 
+              what, path, (unsigned int)(sizeof(addr.sun_path) - 1));
+      return -1;
+   }
+   strcpy(addr.sun_path, path);
+   if( (srv->path = strdup(path)) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for the %s socket : %s\n", SRC_FILE, __LINE__, what, strerror(errno));
+      return -1;
+   }
+   /* a socket left by a killed job is in the way, anything else at the path is not ours */
+   if(lstat(path, &sbuf) == 0)
+   {
+      if(!S_ISSOCK(sbuf.st_mode))
+      {
+         fprintf(stderr, "%s @L %d : \"%s\" is in the way of the %s socket and is not one\n", SRC_FILE, __LINE__, path, what);
+         sock_server_close(srv);
+         return -1;
+      }
+      unlink(path);
+   }
+   else if(errno != ENOENT)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, path, strerror(errno));
+      sock_server_close(srv);
+      return -1;
+   }
+   if( ((srv->sfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) || 
+       (bind(srv->sfd, (struct sockaddr*) &addr, sizeof(struct sockaddr_un)) < 0) ||
+       (listen(srv->sfd, 16) < 0) || (fcntl(srv->sfd, F_SETFD, FD_CLOEXEC) < 0) ||
+       ((nonblock == PX_YES) && (fcntl(srv->sfd, F_SETFL, fcntl(srv->sfd, F_GETFL) | O_NONBLOCK) < 0)) )
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, path, strerror(errno));
+      sock_server_close(srv);
+      return -1;
+   }
+   if( (pipe(srv->pfd) < 0) || (fcntl(srv->pfd[0], F_SETFD, FD_CLOEXEC) < 0) || (fcntl(srv->pfd[1], F_SETFD, FD_CLOEXEC) < 0) )
+   {
+      fprintf(stderr, "%s @L %d : pipe error for the %s socket : %s\n", SRC_FILE, __LINE__, what, strerror(errno));
+      sock_server_close(srv);
+      return -1;
+   }
+   return 0;
+}/* sock_server_open */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int sock_server_start(SOCK_SERVER* srv, void* (*run)(void*), void* arg)
+{
+#ifdef HAVE_SIGNAL_H 
+   sigset_t allmask, oldmask;
+#endif
+   int per;
+
+   /* the signals are left to the threads that run the units */
+#ifdef HAVE_SIGNAL_H 
+   sigfillset(&allmask);
+   pthread_sigmask(SIG_SETMASK, &allmask, &oldmask);
+#endif
+   per = pthread_create(&(srv->thrd), NULL, run, arg);
+#ifdef HAVE_SIGNAL_H 
+   pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
+#endif
+   if(per != 0)
+   {
+      fprintf(stderr, "%s @L %d : pthread_create Failed (pthrd error %d)\n", SRC_FILE, __LINE__, per);
+      return -1;
+   }
+   srv->running = PX_YES;
+   return 0;
+}/* sock_server_start */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int sock_server_wait(SOCK_SERVER* srv, int msecs)
+{
+   struct pollfd pfd[2];
+
+   pfd[0].fd = srv->sfd;
+   pfd[0].events = POLLIN;
+   pfd[0].revents = 0;
+   pfd[1].fd = srv->pfd[0];
+   pfd[1].events = POLLIN;
+   pfd[1].revents = 0;
+   if(poll(pfd, 2, msecs) < 0)
+   {
+      if(errno == EINTR)
+         return 0;
+      fprintf(stderr, "%s @L %d : \"%s\" poll error : %s\n", SRC_FILE, __LINE__, srv->path, strerror(errno));
+      return -1;
+   }
+   if(pfd[1].revents != 0)
+      return -1;
+   return ((pfd[0].revents & POLLIN) ? 1 : 0);
+}/* sock_server_wait */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void sock_server_send(int cfd, const char* buf, size_t len)
+{
+   send(cfd, buf, len, MSG_NOSIGNAL);
+}/* sock_server_send */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void sock_server_close(SOCK_SERVER* srv)
+{
+   if(srv->running == PX_YES)
+   {
+      /* a byte in an empty pipe, only a signal gets in the way */
+      while( (write(srv->pfd[1], "x", 1) < 0) && (errno == EINTR) )
+         ;
+      pthread_join(srv->thrd, NULL);
+   }
+   if(srv->sfd >= 0)
+   {
+      close(srv->sfd);
+      unlink(srv->path);
+   }
+   if(srv->pfd[0] >= 0)
+      close(srv->pfd[0]);
+   if(srv->pfd[1] >= 0)
+      close(srv->pfd[1]);
+   free(srv->path);
+   memset(srv, 0, sizeof(SOCK_SERVER));
+   srv->sfd = -1;
+   srv->pfd[0] = -1;
+   srv->pfd[1] = -1;
+}/* sock_server_close */
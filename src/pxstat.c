@@ -0,0 +1,305 @@
+/*$**************************************************************************
+*
+* FILE:
+*    pxstat.c
+*
+* AUTHOR:
+*    Andrew Michaelis, amac@hyperplane.org
+*
+* FILE VERSION:
+*    0.0.1
+*
+* LICENSE:
+*  This file is part of pxargs.
+*
+*  pxargs is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  pxargs is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with pxargs. If not, see http://www.gnu.org/licenses/.
+*
+*  Copyright (C) 2012, 2014, 2015 Andrew Michaelis
+*
+***************************************************************************$*/
+#ifdef HAVE_CONFIG_H
+ #include <config.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_FCNTL_H
+ #include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_SOCKET_H
+ #include <sys/socket.h>
+#endif
+
+#include <pxargs.h>
+
+/* the socket is the status path with this added */
+#define STAT_SOCK_EXT ".sock"
+
+/* ticks of PX_STATUS_MSECS in a minute */
+#define STAT_MIN_TICKS (60000 / PX_STATUS_MSECS)
+
+/* module error note */
+static const char* SRC_FILE = __FILE__;
+
+/*--------------------------------------------------------------------
+* Local module routine, the units done per second over the last mins 
+* minutes, or as much of them as has gone by
+*/
+static double stat_rate(LIVE_STATUS* live, unsigned int mins)
+{
+   unsigned long span = (unsigned long)mins * STAT_MIN_TICKS;
+
+   if(span > live->tick)
+      span = live->tick;
+   if(span >= PX_STATUS_WINDOW)
+      span = PX_STATUS_WINDOW - 1;
+   if(span == 0)
+      return 0.0;
+   return ((double)(live->ring[live->tick % PX_STATUS_WINDOW] - live->ring[(live->tick - span) % PX_STATUS_WINDOW])) / 
+          ((double)span * (PX_STATUS_MSECS / 1000.0));
+}/* stat_rate */
+
+/*--------------------------------------------------------------------
+* Local module routine, the status line in buf (PX_STATUS_LNMAX long), 
+* final PX_YES once the coordinator is done. Returns its length.
+*/
+static int stat_format(LIVE_STATUS* live, char* buf, int final)
+{
+   STATUS_SNAP snap;
+   double r1, r5, r15, rate;
+   char eta[32];
+   int nc;
+
+   pthread_mutex_lock(&(live->mtx));
+   snap = live->snap;
+   pthread_mutex_unlock(&(live->mtx));
+   r1 = stat_rate(live, 1);
+   r5 = stat_rate(live, 5);
+   r15 = stat_rate(live, 15);
+   /* the most recent rate there is, no estimate while the list is still coming in */
+   rate = (r1 > 0.0) ? r1 : ((r5 > 0.0) ? r5 : r15);
+   if( (snap.listdone == PX_YES) && (snap.done >= snap.units) )
+      strcpy(eta, "0");
+   else if( (snap.listdone == PX_YES) && (rate > 0.0) )
+      snprintf(eta, sizeof(eta), "%.0f", ((double)(snap.units - snap.done)) / rate);
+   else
+      strcpy(eta, "null");
+   nc = snprintf(buf, PX_STATUS_LNMAX, "{\"time\":%ld,\"state\":\"%s\",\"elapsed\":%.1f,\"units\":%u,\"list_complete\":%s,"
+                 "\"done\":%u,\"in_flight\":%u,\"queued\":%u,\"retry_queued\":%u,\"killed\":%lu,\"failed\":%lu,"
+                 "\"slots\":%u,\"busy\":%u,\"idle\":%u,\"rate_1m\":%.3f,\"rate_5m\":%.3f,\"rate_15m\":%.3f,\"eta_secs\":%s}\n", 
+                 (long)time(NULL), ((final == PX_YES) ? "done" : "running"), (now_tm_nsecs() - live->t0) / 1e9, 
+                 snap.units, ((snap.listdone == PX_YES) ? "true" : "false"), snap.done, snap.inflight, snap.queued, 
+                 snap.retryq, snap.killed, snap.failed, snap.slots, snap.busy, 
+                 ((snap.busy < snap.slots) ? (snap.slots - snap.busy) : 0), r1, r5, r15, eta);
+   return ((nc < 0) || (nc >= PX_STATUS_LNMAX)) ? -1 : nc;
+}/* stat_format */
+
+/*--------------------------------------------------------------------
+* Local module routine, rewrites the status file through its temporary 
+* so a reader sees the old line or the new one
+*/
+static int stat_write(LIVE_STATUS* live, int final)
+{
+   char buf[PX_STATUS_LNMAX];
+   ssize_t nw;
+   int fd, len, off = 0;
+
+   if( (len = stat_format(live, buf, final)) < 0)
+      return -1;
+   if( (fd = open(live->tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+      return -1;
+   while(off < len)
+   {
+      if( (nw = write(fd, &(buf[off]), len - off)) < 0)
+      {
+         if(errno == EINTR)
+            continue;
+         close(fd);
+         return -1;
+      }
+      off += (int)nw;
+   }
+   if(close(fd) < 0)
+      return -1;
+   return rename(live->tmppath, live->path);
+}/* stat_write */
+
+/*--------------------------------------------------------------------
+* Local module routine, answers the waiting connections with the status
+*/
+static void stat_serve(LIVE_STATUS* live)
+{
+   char buf[PX_STATUS_LNMAX];
+   int cfd, len = -1;
+
+   /* a fresh socket's buffer holds the line, the send does not wait on the client */
+   while( (cfd = accept(live->srv.sfd, NULL, NULL)) >= 0)
+   {
+      if(len < 0)
+         len = stat_format(live, buf, PX_NO);
+      if(len > 0)
+         sock_server_send(cfd, buf, (size_t)len);
+      close(cfd);
+   }
+}/* stat_serve */
+
+/*--------------------------------------------------------------------
+* Local module routine, the status thread: every PX_STATUS_MSECS the done
+* count goes in the ring and the file is rewritten, in between it waits 
+* on the socket and the stop pipe
+*/
+static void* stat_run(void* targs)
+{
+   LIVE_STATUS* live = (LIVE_STATUS*) targs;
+   unsigned long k;
+   unsigned int done;
+   long long t;
+   int nerr = 0, rc;
+
+   for(;;)
+   {
+      t = now_tm_nsecs();
+      if( (k = (unsigned long)((t - live->t0) / (PX_STATUS_MSECS * 1000000LL))) > live->tick)
+      {
+         pthread_mutex_lock(&(live->mtx));
+         done = live->snap.done;
+         pthread_mutex_unlock(&(live->mtx));
+         /* a late wake up fills the ticks it missed */
+         while(live->tick < k)
+         {
+            live->tick += 1;
+            live->ring[live->tick % PX_STATUS_WINDOW] = done;
+         }
+         if( (stat_write(live, PX_NO) < 0) && (nerr++ == 0) )
+            fprintf(stderr, "%s @L %d : WARN : failed to write the status file \"%s\" : %s\n", SRC_FILE, __LINE__, live->path, strerror(errno));
+      }
+      if( (rc = sock_server_wait(&(live->srv), (int)(((long long)(live->tick + 1) * PX_STATUS_MSECS) - ((t - live->t0) / 1000000LL) + 1))) < 0)
+         break;
+      if(rc == 1)
+         stat_serve(live);
+   }
+   return NULL;
+}/* stat_run */
+
+/*--------------------------------------------------------------------
+* Local module routine, frees what status_open set up
+*/
+static void stat_free(LIVE_STATUS* live)
+{
+   sock_server_close(&(live->srv));
+   free(live->path);
+   free(live->tmppath);
+   free(live->ring);
+   memset(live, 0, sizeof(LIVE_STATUS));
+}/* stat_free */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int status_open(LIVE_STATUS* live, const char* path)
+{
+   char* sockpath;
+   size_t plen = strlen(path);
+   int per;
+
+   memset(live, 0, sizeof(LIVE_STATUS));
+   live->srv.sfd = -1;
+   live->srv.pfd[0] = -1;
+   live->srv.pfd[1] = -1;
+   live->path = (char*) malloc(plen + 1);
+   live->tmppath = (char*) malloc(plen + 5);
+   sockpath = (char*) malloc(plen + strlen(STAT_SOCK_EXT) + 1);
+   live->ring = (unsigned int*) calloc(PX_STATUS_WINDOW, sizeof(unsigned int));
+   if( (live->path == NULL) || (live->tmppath == NULL) || (sockpath == NULL) || (live->ring == NULL) )
+   {
+      fprintf(stderr, "%s @L %d : malloc error for the status : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      free(sockpath);
+      stat_free(live);
+      return -1;
+   }
+   strcpy(live->path, path);
+   sprintf(live->tmppath, "%s.tmp", path);
+   sprintf(sockpath, "%s%s", path, STAT_SOCK_EXT);
+   /* each wake up answers all of the waiting connections */
+   per = sock_server_open(&(live->srv), sockpath, "status", PX_YES);
+   free(sockpath);
+   if(per < 0)
+   {
+      stat_free(live);
+      return -1;
+   }
+   /* stat_write takes the lock */
+   if( (per = pthread_mutex_init(&(live->mtx), NULL)) != 0)
+   {
+      fprintf(stderr, "%s @L %d : pthread_mutex_init Failed (pthrd error %d)\n", SRC_FILE, __LINE__, per);
+      stat_free(live);
+      return -1;
+   }
+   live->t0 = now_tm_nsecs();
+   if(stat_write(live, PX_NO) < 0)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, path, strerror(errno));
+      pthread_mutex_destroy(&(live->mtx));
+      stat_free(live);
+      return -1;
+   }
+   if( sock_server_start(&(live->srv), stat_run, (void*) live) < 0)
+   {
+      pthread_mutex_destroy(&(live->mtx));
+      stat_free(live);
+      return -1;
+   }
+   return 0;
+}/* status_open */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void status_update(LIVE_STATUS* live, const STATUS_SNAP* snap)
+{
+   if(live == NULL)
+      return;
+   pthread_mutex_lock(&(live->mtx));
+   live->snap = *snap;
+   pthread_mutex_unlock(&(live->mtx));
+}/* status_update */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int status_close(LIVE_STATUS* live)
+{
+   int rc = 0;
+
+   if(live->srv.running != PX_YES)
+      return 0;
+   sock_server_close(&(live->srv));
+   if(stat_write(live, PX_YES) < 0)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, live->path, strerror(errno));
+      rc = -1;
+   }
+   pthread_mutex_destroy(&(live->mtx));
+   stat_free(live);
+   return rc;
+}/* status_close */
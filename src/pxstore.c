@@ -0,0 +1,740 @@
+/*$**************************************************************************
+*
+* FILE:
+*    pxstore.c
+*
+* AUTHOR:
+*    Andrew Michaelis, amac@hyperplane.org
+*
+* FILE VERSION:
+*    0.0.1
+*
+* LICENSE:
+*  This file is part of pxargs.
+*
+*  pxargs is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  pxargs is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with pxargs. If not, see http://www.gnu.org/licenses/.
+*
+*  Copyright (C) 2012, 2014, 2015 Andrew Michaelis
+*
+***************************************************************************$*/
+#ifdef HAVE_CONFIG_H
+ #include <config.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef HAVE_LIMITS_H
+ #include <limits.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_FCNTL_H
+ #include <fcntl.h>
+#endif
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+ #include <sys/mman.h>
+#endif
+
+#include <pxargs.h>
+
+/* module error note */
+static const char* SRC_FILE = __FILE__;
+
+/* Local module type, a unit's cost for work_store_order */
+typedef struct
+{
+   double cost;
+   unsigned int id;
+} STORE_COST;
+
+/*--------------------------------------------------------------------
+* Local module routine, maps (or without mmap reads) the whole of fd.
+*/
+static int store_map(WORK_STORE* wstore, int fd, const char* fname)
+{
+   struct stat sbuf;
+#if !defined(HAVE_SYS_MMAN_H) || !defined(HAVE_MMAP)
+   ssize_t nr;
+   size_t len = 0;
+#endif
+
+   if(fstat(fd, &sbuf) < 0)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      return -1;
+   }
+   wstore->maplen = (size_t) sbuf.st_size;
+   if(wstore->maplen == 0)
+      return 0;
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+   if( (wstore->map = (char*) mmap(NULL, wstore->maplen, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+   {
+      wstore->map = NULL;
+      fprintf(stderr, "%s @L %d : mmap error for \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      return -1;
+   }
+#ifdef HAVE_MADVISE
+   /* the index is built front to back */
+   madvise(wstore->map, wstore->maplen, MADV_SEQUENTIAL);
+#endif
+#else
+   if( (wstore->map = (char*) malloc(wstore->maplen)) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for arg list : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   wstore->copied = PX_YES;
+   while(len < wstore->maplen)
+   {
+      if( (nr = read(fd, &(wstore->map[len]), wstore->maplen - len)) < 0)
+      {
+         if(errno == EINTR)
+            continue;
+         fprintf(stderr, "%s @L %d : read error for \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+         return -1;
+      }
+      if(nr == 0)
+         break;
+      len += (size_t)nr;
+   }
+   wstore->maplen = len;
+#endif
+   return 0;
+}/* store_map */
+
+/*--------------------------------------------------------------------
+* Local module routine, finds the args of the line at *pos and moves *pos to
+* the next line. The rules are those of parse_work_line: blank lines and
+* comments are skipped, a line ends at its first '\r' or '\n' and with execcol
+* the first column is the executable. Returns 1 for a unit (with *off, *len
+* and *eidx set), 0 for a skipped line and < 0 on failure.
+*/
+static int store_line( WORK_STORE* wstore, size_t* pos, int execcol, unsigned int id,
+                       size_t* off, size_t* len, int* eidx )
+{
+   const char* ln = &(wstore->map[*pos]);
+   const char* nl;
+   size_t lnlen, skip, elen;
+
+   if( (nl = (const char*) memchr(ln, '\n', wstore->maplen - *pos)) != NULL)
+      lnlen = (size_t)(nl - ln);
+   else
+      lnlen = wstore->maplen - *pos;
+   *pos += lnlen + ((nl != NULL) ? 1 : 0);
+
+   /* skip comments, etc... */
+   if( (lnlen == 0) || (ln[0] == '\r') || (ln[0] == '#') || (ln[0] == '\0') )
+      return 0;
+   for(skip = 0; (skip < lnlen) && (ln[skip] != '\r') && (ln[skip] != '\0'); skip++)
+      ;
+   lnlen = skip;
+
+   *off = (size_t)(ln - wstore->map);
+   *eidx = 0;
+   if(execcol == PX_YES)
+   {
+      /* split off the exec column, the rest are the args */
+      for(skip = 0; (skip < lnlen) && ((ln[skip] == ' ') || (ln[skip] == '\t')); skip++)
+         ;
+      for(elen = 0; (skip + elen < lnlen) && (ln[skip+elen] != ' ') && (ln[skip+elen] != '\t'); elen++)
+         ;
+      if( (elen == 0) || ((*eidx = exec_table_intern(wstore->etab, &(ln[skip]), elen)) < 0) )
+      {
+         fprintf(stderr, "%s @L %d : bad exec column for unit %u\n", SRC_FILE, __LINE__, id);
+         return -1;
+      }
+      skip += elen;
+      while( (skip < lnlen) && ((ln[skip] == ' ') || (ln[skip] == '\t')) )
+         skip++;
+      *off += skip;
+      lnlen -= skip;
+   }
+   *len = lnlen;
+   return 1;
+}/* store_line */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int work_store_map(WORK_STORE* wstore, const char* fname)
+{
+   int fd, rc;
+
+   memset(wstore, 0, sizeof(WORK_STORE));
+   if( (fd = open(fname, O_RDONLY)) < 0)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      return -1;
+   }
+   rc = store_map(wstore, fd, fname);
+   close(fd);
+   if(rc < 0)
+   {
+      work_store_close(wstore);
+      return -1;
+   }
+   return 0;
+}/* work_store_map */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int work_store_open(WORK_STORE* wstore, const char* fname, EXEC_TABLE* etab, int execcol)
+{
+   size_t pos, off, len;
+   unsigned int i;
+   int rc, eidx;
+
+   if( (execcol == PX_YES) && (etab == NULL) )
+      return -1;
+   if( work_store_map(wstore, fname) < 0)
+      return -1;
+   wstore->etab = etab;
+   wstore->execcol = execcol;
+
+   /* just count here */
+   for(pos = 0; pos < wstore->maplen; )
+   {
+      if( (wstore->map[pos] != '\n') && (wstore->map[pos] != '\r') && (wstore->map[pos] != '#') )
+         wstore->n += 1;
+      if(wstore->n == UINT_MAX)
+      {
+         fprintf(stderr, "%s @L %d : too many units in \"%s\"\n", SRC_FILE, __LINE__, fname);
+         work_store_close(wstore);
+         return -1;
+      }
+      for(; (pos < wstore->maplen) && (wstore->map[pos] != '\n'); pos++)
+         ;
+      pos++;
+   }
+
+   wstore->offs = (size_t*) malloc((wstore->n + 1) * sizeof(size_t));
+   wstore->lens = (unsigned int*) malloc((wstore->n + 1) * sizeof(unsigned int));
+   wstore->exec_idx = (unsigned char*) calloc(wstore->n + 1, sizeof(unsigned char));
+   wstore->proc_msecs = (unsigned int*) calloc(wstore->n + 1, sizeof(unsigned int));
+   wstore->resrank = (int*) malloc((wstore->n + 1) * sizeof(int));
+   wstore->was_killed = (unsigned char*) calloc(wstore->n + 1, sizeof(unsigned char));
+   wstore->exitstat = (int*) calloc(wstore->n + 1, sizeof(int));
+   wstore->ru = (WORK_RUSAGE*) calloc(wstore->n + 1, sizeof(WORK_RUSAGE));
+   wstore->tm = (WORK_TIMES*) calloc(wstore->n + 1, sizeof(WORK_TIMES));
+   if( (wstore->offs == NULL) || (wstore->lens == NULL) || (wstore->exec_idx == NULL) ||
+       (wstore->proc_msecs == NULL) || (wstore->resrank == NULL) || (wstore->was_killed == NULL) ||
+       (wstore->exitstat == NULL) || (wstore->ru == NULL) || (wstore->tm == NULL) )
+   {
+      fprintf(stderr, "%s @L %d : malloc error for work unit index : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      work_store_close(wstore);
+      return -1;
+   }
+
+   /* index here */
+   for(pos = 0, i = 0; (pos < wstore->maplen) && (i < wstore->n); )
+   {
+      if( (rc = store_line(wstore, &pos, execcol, i, &off, &len, &eidx)) < 0)
+      {
+         fprintf(stderr, "%s @L %d : bad line for unit %u in \"%s\"\n", SRC_FILE, __LINE__, i, fname);
+         work_store_close(wstore);
+         return -1;
+      }
+      if(rc == 0)
+         continue;
+      if(len >= UINT_MAX)
+      {
+         fprintf(stderr, "%s @L %d : line too long for unit %u in \"%s\"\n", SRC_FILE, __LINE__, i, fname);
+         work_store_close(wstore);
+         return -1;
+      }
+      wstore->offs[i] = off;
+      wstore->lens[i] = (unsigned int)len;
+      wstore->exec_idx[i] = (unsigned char)eidx;
+      wstore->resrank[i] = RANK_UNASSIGNED;
+      i++;
+   }
+   /* a "\0" led line is counted but not a unit */
+   wstore->n = i;
+   return 0;
+}/* work_store_open */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int work_store_unit(WORK_STORE* wstore, unsigned int id, WORK_UNIT* worku, char** abuf, size_t* acap)
+{
+   char* nbuf;
+   size_t len, ncap;
+
+   if(id >= wstore->n)
+      return -1;
+   len = (size_t) wstore->lens[id];
+   if( (*abuf == NULL) || (len + 1 > *acap) )
+   {
+      ncap = (len + 1 > PXARGLENINIT) ? (len + 1) : PXARGLENINIT;
+      if( (nbuf = (char*) realloc(*abuf, ncap)) == NULL)
+      {
+         fprintf(stderr, "%s @L %d : realloc error for work unit args : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
+      }
+      *abuf = nbuf;
+      *acap = ncap;
+   }
+   if(len > 0)
+      memcpy(*abuf, &(wstore->map[wstore->offs[id]]), len);
+   (*abuf)[len] = '\0';
+
+   memset(worku, 0, sizeof(WORK_UNIT));
+   worku->pargs = *abuf;
+   worku->proc_secs = (long)(wstore->proc_msecs[id] / 1000U);
+   worku->resrank = wstore->resrank[id];
+   worku->id_tag = id;
+   worku->was_killed = (int) wstore->was_killed[id];
+   worku->exit_code = (wstore->exitstat[id] >= 0) ? wstore->exitstat[id] : -1;
+   worku->term_sig = (wstore->exitstat[id] < 0) ? -(wstore->exitstat[id]) : 0;
+   worku->maxumsecs = 0;
+   worku->ru = wstore->ru[id];
+   /* with --rma only the run time came back, not the rest of ru or tm */
+   worku->ru.wall_ms = wstore->proc_msecs[id];
+   worku->tm = wstore->tm[id];
+   worku->exec_idx = (unsigned int) wstore->exec_idx[id];
+   if( (wstore->etab != NULL) && (worku->exec_idx < wstore->etab->n) )
+      worku->procpath = wstore->etab->paths[worku->exec_idx];
+   return 0;
+}/* work_store_unit */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int work_store_skip(WORK_STORE* wstore, unsigned char* done)
+{
+   unsigned int i, k;
+
+   for(i = 0, k = 0; i < wstore->n; i++)
+   {
+      if(done[i] == 0)
+         k++;
+   }
+   if(k == wstore->n)
+      return 0;
+   if( (wstore->orig = (unsigned int*) malloc((k + 1) * sizeof(unsigned int))) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for work unit index : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   /* units only move down, the result arrays are still unset */
+   for(i = 0, k = 0; i < wstore->n; i++)
+   {
+      if(done[i] != 0)
+         continue;
+      wstore->offs[k] = wstore->offs[i];
+      wstore->lens[k] = wstore->lens[i];
+      wstore->exec_idx[k] = wstore->exec_idx[i];
+      if(wstore->dupok != NULL)
+         wstore->dupok[k] = wstore->dupok[i];
+      wstore->orig[k] = i;
+      k++;
+   }
+   wstore->norig = wstore->n;
+   wstore->n = k;
+   return 0;
+}/* work_store_skip */
+
+/*--------------------------------------------------------------------
+* Local module routine, qsort order for work_store_order, the costliest first
+* and equal costs by position so they keep the list order.
+*/
+static int store_cost_cmp(const void* a, const void* b)
+{
+   const STORE_COST* ca = (const STORE_COST*) a;
+   const STORE_COST* cb = (const STORE_COST*) b;
+
+   if(ca->cost != cb->cost)
+      return (ca->cost > cb->cost) ? -1 : 1;
+   return (ca->id < cb->id) ? -1 : ((ca->id > cb->id) ? 1 : 0);
+}/* store_cost_cmp */
+
+/*--------------------------------------------------------------------
+* Local module routine, copies the word of unit id's args at *pos (words are 
+* separated by blanks) to wbuf without enclosing quotes, wbuf is "" if the word
+* does not fit in wcap. *pos is moved past the word. Returns the word's length 
+* in the args, 0 when there are no more.
+*/
+static size_t store_word(WORK_STORE* wstore, unsigned int id, size_t* pos, char* wbuf, size_t wcap)
+{
+   const char* a = &(wstore->map[wstore->offs[id]]);
+   size_t len = (size_t) wstore->lens[id];
+   size_t start, wlen, cstart, clen;
+
+   while( (*pos < len) && ((a[*pos] == ' ') || (a[*pos] == '\t')) )
+      *pos += 1;
+   start = *pos;
+   while( (*pos < len) && (a[*pos] != ' ') && (a[*pos] != '\t') )
+      *pos += 1;
+   wlen = *pos - start;
+   cstart = start;
+   clen = wlen;
+   if( (wlen >= 2) && ((a[start] == '"') || (a[start] == '\'')) && (a[start + wlen - 1] == a[start]) )
+   {
+      cstart += 1;
+      clen -= 2;
+   }
+   if(clen >= wcap)
+      clen = 0;
+   memcpy(wbuf, &(a[cstart]), clen);
+   wbuf[clen] = '\0';
+   return wlen;
+}/* store_word */
+
+/*--------------------------------------------------------------------
+* Local module routine, takes the first pos bytes of unit id's args, and
+* the blanks after them, off the args.
+*/
+static void store_drop(WORK_STORE* wstore, unsigned int id, size_t pos)
+{
+   while( (pos < wstore->lens[id]) && ((wstore->map[wstore->offs[id] + pos] == ' ') || (wstore->map[wstore->offs[id] + pos] == '\t')) )
+      pos++;
+   wstore->offs[id] += pos;
+   wstore->lens[id] -= (unsigned int)pos;
+}/* store_drop */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int work_store_order(WORK_STORE* wstore, int costsrc, HISTORY* hist)
+{
+   struct stat sbuf;
+   HISTORY_ENTRY* hent;
+   STORE_COST* costs;
+   size_t* noffs;
+   unsigned int* nlens;
+   unsigned char* neidx;
+   unsigned char* ndup = NULL;
+   unsigned int* norig;
+   char wbuf[PATH_MAX + 1];
+   char* end;
+   char* eq;
+   size_t pos;
+   unsigned int i, j;
+   double maxcost = 0.0;
+
+   if(wstore->n == 0)
+      return 0;
+   if( (costs = (STORE_COST*) calloc(wstore->n, sizeof(STORE_COST))) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for unit costs : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   for(i = 0; i < wstore->n; i++)
+   {
+      costs[i].id = i;
+      pos = 0;
+      if(costsrc == PX_COST_COLUMN)
+      {
+         /* the first word is the cost, the args start at the next one */
+         end = wbuf;
+         if(store_word(wstore, i, &pos, wbuf, sizeof(wbuf)) > 0)
+            costs[i].cost = strtod(wbuf, &end);
+         if( (end == wbuf) || (*end != '\0') )
+         {
+            fprintf(stderr, "%s @L %d : bad cost column for unit %u\n", SRC_FILE, __LINE__, WORK_STORE_ORIG(wstore, i));
+            free(costs);
+            return -1;
+         }
+         store_drop(wstore, i, pos);
+      }
+      else if(costsrc == PX_COST_HISTORY)
+      {
+         /* a unit never run before is marked for now */
+         hent = history_lookup(hist, ((wstore->etab != NULL) ? wstore->etab->paths[wstore->exec_idx[i]] : NULL), 
+                               &(wstore->map[wstore->offs[i]]), (size_t)wstore->lens[i]);
+         costs[i].cost = (hent != NULL) ? hent->secs : -1.0;
+         if(costs[i].cost > maxcost)
+            maxcost = costs[i].cost;
+      }
+      else
+      {
+         while(store_word(wstore, i, &pos, wbuf, sizeof(wbuf)) > 0)
+         {
+            if(wbuf[0] == '\0')
+               continue;
+            if( (stat(wbuf, &sbuf) == 0) && S_ISREG(sbuf.st_mode) )
+               costs[i].cost += (double) sbuf.st_size;
+            else if( ((eq = strchr(wbuf, '=')) != NULL) && (stat(&(eq[1]), &sbuf) == 0) && S_ISREG(sbuf.st_mode) )
+               costs[i].cost += (double) sbuf.st_size;
+         }
+      }
+   }
+   for(i = 0; (costsrc == PX_COST_HISTORY) && (i < wstore->n); i++)
+   {
+      if(costs[i].cost < 0.0)
+         costs[i].cost = maxcost;
+   }
+   qsort(costs, wstore->n, sizeof(STORE_COST), store_cost_cmp);
+
+   noffs = (size_t*) malloc((wstore->n + 1) * sizeof(size_t));
+   nlens = (unsigned int*) malloc((wstore->n + 1) * sizeof(unsigned int));
+   neidx = (unsigned char*) calloc(wstore->n + 1, sizeof(unsigned char));
+   norig = (unsigned int*) malloc((wstore->n + 1) * sizeof(unsigned int));
+   if(wstore->dupok != NULL)
+      ndup = (unsigned char*) calloc(wstore->n + 1, sizeof(unsigned char));
+   if( (noffs == NULL) || (nlens == NULL) || (neidx == NULL) || (norig == NULL) || ((wstore->dupok != NULL) && (ndup == NULL)) )
+   {
+      fprintf(stderr, "%s @L %d : malloc error for work unit index : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      free(noffs); free(nlens); free(neidx); free(norig); free(ndup); free(costs);
+      return -1;
+   }
+   /* the result arrays are still unset, only the index moves */
+   for(i = 0; i < wstore->n; i++)
+   {
+      j = costs[i].id;
+      noffs[i] = wstore->offs[j];
+      nlens[i] = wstore->lens[j];
+      neidx[i] = wstore->exec_idx[j];
+      norig[i] = WORK_STORE_ORIG(wstore, j);
+      if(ndup != NULL)
+         ndup[i] = wstore->dupok[j];
+   }
+   if(wstore->orig == NULL)
+      wstore->norig = wstore->n;
+   free(wstore->offs); free(wstore->lens); free(wstore->exec_idx); free(wstore->orig); free(wstore->dupok); free(costs);
+   wstore->offs = noffs;
+   wstore->lens = nlens;
+   wstore->exec_idx = neidx;
+   wstore->orig = norig;
+   wstore->dupok = ndup;
+   return 0;
+}/* work_store_order */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int work_store_permute(WORK_STORE* wstore, unsigned int from, const unsigned int* ids, unsigned int k)
+{
+   size_t* noffs;
+   unsigned int* nlens;
+   unsigned char* neidx;
+   unsigned char* ndup = NULL;
+   unsigned int* norig;
+   unsigned int i;
+
+   if(k == 0)
+      return 0;
+   /* the arg list positions have to move with the units */
+   if(wstore->orig == NULL)
+   {
+      if( (wstore->orig = (unsigned int*) malloc((wstore->n + 1) * sizeof(unsigned int))) == NULL)
+      {
+         fprintf(stderr, "%s @L %d : malloc error for work unit index : %s\n", SRC_FILE, __LINE__, strerror(errno));
+         return -1;
+      }
+      for(i = 0; i < wstore->n; i++)
+         wstore->orig[i] = i;
+      wstore->norig = wstore->n;
+   }
+   noffs = (size_t*) malloc(k * sizeof(size_t));
+   nlens = (unsigned int*) malloc(k * sizeof(unsigned int));
+   neidx = (unsigned char*) malloc(k * sizeof(unsigned char));
+   norig = (unsigned int*) malloc(k * sizeof(unsigned int));
+   if(wstore->dupok != NULL)
+      ndup = (unsigned char*) malloc(k * sizeof(unsigned char));
+   if( (noffs == NULL) || (nlens == NULL) || (neidx == NULL) || (norig == NULL) || ((wstore->dupok != NULL) && (ndup == NULL)) )
+   {
+      fprintf(stderr, "%s @L %d : malloc error for work unit index : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      free(noffs); free(nlens); free(neidx); free(norig); free(ndup);
+      return -1;
+   }
+   for(i = 0; i < k; i++)
+   {
+      noffs[i] = wstore->offs[ids[i]];
+      nlens[i] = wstore->lens[ids[i]];
+      neidx[i] = wstore->exec_idx[ids[i]];
+      norig[i] = wstore->orig[ids[i]];
+      if(ndup != NULL)
+         ndup[i] = wstore->dupok[ids[i]];
+   }
+   memcpy(&(wstore->offs[from]), noffs, k * sizeof(size_t));
+   memcpy(&(wstore->lens[from]), nlens, k * sizeof(unsigned int));
+   memcpy(&(wstore->exec_idx[from]), neidx, k * sizeof(unsigned char));
+   memcpy(&(wstore->orig[from]), norig, k * sizeof(unsigned int));
+   if(ndup != NULL)
+      memcpy(&(wstore->dupok[from]), ndup, k * sizeof(unsigned char));
+   free(noffs); free(nlens); free(neidx); free(norig); free(ndup);
+   return 0;
+}/* work_store_permute */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int work_store_mark(WORK_STORE* wstore, unsigned int* nmark)
+{
+   char wbuf[sizeof(PX_SPEC_MARK) + 1];
+   size_t pos;
+   unsigned int i;
+
+   *nmark = 0;
+   free(wstore->dupok);
+   if( (wstore->dupok = (unsigned char*) calloc(wstore->n + 1, sizeof(unsigned char))) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for work unit flags : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   for(i = 0; i < wstore->n; i++)
+   {
+      pos = 0;
+      if( (store_word(wstore, i, &pos, wbuf, sizeof(wbuf)) > 0) && (strcmp(wbuf, PX_SPEC_MARK) == 0) )
+      {
+         store_drop(wstore, i, pos);
+         wstore->dupok[i] = 1;
+         *nmark += 1;
+      }
+   }
+   if(*nmark == 0)
+   {
+      free(wstore->dupok);
+      wstore->dupok = NULL;
+   }
+   return 0;
+}/* work_store_mark */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void work_store_close(WORK_STORE* wstore)
+{
+   if(wstore->map != NULL)
+   {
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+      if(wstore->copied == PX_NO)
+         munmap(wstore->map, wstore->maplen);
+      else
+#endif
+         free(wstore->map);
+   }
+   free(wstore->offs);
+   free(wstore->lens);
+   free(wstore->exec_idx);
+   free(wstore->proc_msecs);
+   free(wstore->resrank);
+   free(wstore->was_killed);
+   free(wstore->exitstat);
+   free(wstore->ru);
+   free(wstore->tm);
+   free(wstore->orig);
+   free(wstore->dupok);
+   memset(wstore, 0, sizeof(WORK_STORE));
+}/* work_store_close */
+
+/*-----------------------------------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int dump_work_list_by_index( const char* fname, WORK_STORE* wstore,
+                             unsigned char* windex, unsigned int nindex )
+{
+   FILE* fout;
+   unsigned int i, eidx;
+
+   if( (fout = fopen(fname, "w")) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      return -1;
+   }
+   for(i = 0; (i < nindex) && (i < wstore->n); i++)
+   {
+      if(windex[i] == 0)
+      {
+         /* keep the exec column if the list had one */
+         eidx = (unsigned int) wstore->exec_idx[i];
+         if( (wstore->execcol == PX_YES) && (eidx < wstore->etab->n) )
+            fprintf(fout, "%s ", wstore->etab->paths[eidx]);
+         else if(wstore->lens[i] == 0)
+            continue;
+         fwrite(&(wstore->map[wstore->offs[i]]), 1, (size_t) wstore->lens[i], fout);
+         fputc('\n', fout);
+      }
+   }
+   fclose(fout);
+   return 0;
+}/* dump_work_list_by_index */
+
+/*-----------------------------------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int dump_work_list_as_listed(const char* fname, WORK_STORE* wstore, unsigned char* windex)
+{
+   FILE* fout;
+   unsigned int* byorig;
+   unsigned int i, id, norig;
+   size_t start;
+
+   norig = (wstore->orig != NULL) ? wstore->norig : wstore->n;
+   if( (byorig = (unsigned int*) malloc((norig + 1) * sizeof(unsigned int))) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for the list order : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   for(i = 0; i < norig; i++)
+      byorig[i] = UINT_MAX;
+   for(id = 0; id < wstore->n; id++)
+   {
+      if(windex[id] == 0)
+         byorig[WORK_STORE_ORIG(wstore, id)] = id;
+   }
+   if( (fout = fopen(fname, "w")) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      free(byorig);
+      return -1;
+   }
+   for(i = 0; i < norig; i++)
+   {
+      if( (id = byorig[i]) == UINT_MAX)
+         continue;
+      /* the args only ever lose their front, the line starts after the newline before them */
+      for(start = wstore->offs[id]; (start > 0) && (wstore->map[start-1] != '\n'); start--)
+         ;
+      fwrite(&(wstore->map[start]), 1, wstore->offs[id] + wstore->lens[id] - start, fout);
+      fputc('\n', fout);
+   }
+   free(byorig);
+   if(fclose(fout) != 0)
+   {
+      fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+      return -1;
+   }
+   return 0;
+}/* dump_work_list_as_listed */
+
+/*-----------------------------------------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void fprint_worklist(FILE* fout, WORK_STORE* wstore)
+{
+   WORK_UNIT oneu;
+   char* abuf = NULL;
+   size_t acap = 0;
+   unsigned int i;
+
+   if(wstore == NULL)
+      return;
+   for(i = 0; i < wstore->n; i++)
+   {
+      if( work_store_unit(wstore, i, &oneu, &abuf, &acap) < 0)
+         break;
+      fprint_worku(fout, &oneu);
+   }
+   free(abuf);
+}/* fprint_worklist */
@@ -0,0 +1,421 @@
+/*$**************************************************************************
+*
+* FILE:
+*    pxtrace.c
+*
+* AUTHOR:
+*    Andrew Michaelis, amac@hyperplane.org
+*
+* FILE VERSION:
+*    0.0.1
+*
+* LICENSE:
+*  This file is part of pxargs.
+*
+*  pxargs is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  pxargs is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with pxargs. If not, see http://www.gnu.org/licenses/.
+*
+*  Copyright (C) 2012, 2014, 2015 Andrew Michaelis
+*
+***************************************************************************$*/
+#ifdef HAVE_CONFIG_H
+ #include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <pxargs.h>
+
+/* the tag of the syncs and the merge, the communicator is the trace's own */
+#define TRACE_TAG 1
+
+/* the threads of a rank's process in the trace: its scheduling messages (coordinator or
+   node leader), its worker's messages and the worker's slots from TRACE_TID_SLOT on */
+#define TRACE_TID_SCHED 0
+#define TRACE_TID_WORK 1
+#define TRACE_TID_SLOT 2
+
+/* module error note */
+static const char* SRC_FILE = __FILE__;
+
+/* the names of the roles, by PX_TRACE_* role */
+static const char* TRACE_ROLES[] = { "coordinator", "worker", "node leader", "monitor" };
+
+/*--------------------------------------------------------------------
+* Local module routine, the name of a message tag
+*/
+static const char* trace_tagname(int tag)
+{
+   switch(tag)
+   {
+      case DOWORK:
+         return "units";
+      case CANCELWORK:
+         return "cancel";
+      case SLOTSWORK:
+         return "slots";
+      case ENDWORK:
+         return "end";
+      default:
+         break;
+   }
+   return "message";
+}/* trace_tagname */
+
+/*--------------------------------------------------------------------
+* Local module routine, lines up the clocks, the first or second (pass 0
+* or 1) sync. Rank 0 keeps, for each rank, the offset of the round trip
+* that took the least time and the rank's time then.
+*/
+static int trace_sync(TRACE* trace, int pass)
+{
+   MPI_Status status;
+   long long t0, t1, tr, best;
+   int r, k;
+
+   for(r = 1; r < trace->nranks; r++)
+   {
+      best = -1;
+      for(k = 0; k < PX_TRACE_SYNC_ROUNDS; k++)
+      {
+         if(trace->rank == 0)
+         {
+            t0 = now_tm_nsecs();
+            if( (MPI_Send(NULL, 0, MPI_BYTE, r, TRACE_TAG, trace->comm) != MPI_SUCCESS) ||
+                (MPI_Recv(&tr, 1, MPI_LONG_LONG, r, TRACE_TAG, trace->comm, &status) != MPI_SUCCESS) )
+               return -1;
+            t1 = now_tm_nsecs();
+            /* the rank read its clock about half way through the round trip */
+            if( (best < 0) || ((t1 - t0) < best) )
+            {
+               best = t1 - t0;
+               trace->sync[(4 * r) + (2 * pass)] = tr - (t0 + ((t1 - t0) / 2));
+               trace->sync[(4 * r) + (2 * pass) + 1] = tr;
+            }
+         }
+         else if(trace->rank == r)
+         {
+            if( MPI_Recv(NULL, 0, MPI_BYTE, 0, TRACE_TAG, trace->comm, &status) != MPI_SUCCESS)
+               return -1;
+            tr = now_tm_nsecs();
+            if( MPI_Send(&tr, 1, MPI_LONG_LONG, 0, TRACE_TAG, trace->comm) != MPI_SUCCESS)
+               return -1;
+         }
+      }
+   }
+   return 0;
+}/* trace_sync */
+
+/*--------------------------------------------------------------------
+* Local module routine, the time x of a rank on rank 0's clock, from the
+* rank's sync entries s (NULL for rank 0) in microseconds since t0
+*/
+static double trace_usecs(const long long* s, long long x, long long t0)
+{
+   double off = 0.0;
+
+   if( (s != NULL) && (s[3] > s[1]) )
+      off = (double)s[0] + ((double)(s[2] - s[0]) * ((double)(x - s[1]) / (double)(s[3] - s[1])));
+   else if(s != NULL)
+      off = (double)s[0];
+   return ((double)(x - t0) - off) / 1000.0;
+}/* trace_usecs */
+
+/*--------------------------------------------------------------------
+* Local module routine, writes n events of rank pid as JSON trace events.
+* s and t0 are as for trace_usecs. The threads used are flagged in used,
+* TRACE_TID_SLOT of them, and the highest is kept in *maxtid.
+*/
+static void trace_write(FILE* fout, const TRACE_EVENT* ev, size_t n, int pid, const long long* s, long long t0, int* used, int* maxtid)
+{
+   const TRACE_EVENT* e;
+   double ts;
+   size_t i;
+   int tid;
+
+   for(i = 0; i < n; i++)
+   {
+      e = &(ev[i]);
+      ts = trace_usecs(s, e->ts, t0);
+      tid = TRACE_TID_SCHED;
+      switch(e->kind)
+      {
+         case PX_TRACE_SEND:
+            fprintf(fout, ",\n{\"name\":\"dispatch\",\"cat\":\"sched\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,"
+                          "\"args\":{\"to\":%d,\"units\":%u}}", ts, e->dur / 1000.0, pid, tid, e->peer, e->id);
+            break;
+         case PX_TRACE_UNIT:
+            /* a flow from the dispatch to the run, through a node leader's dispatch */
+            fprintf(fout, ",\n{\"name\":\"unit\",\"cat\":\"unit\",\"ph\":\"%s\",\"id\":%u,\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                    ((e->val == PX_YES) ? "t" : "s"), e->id, ts, pid, tid);
+            break;
+         case PX_TRACE_COMPLETE:
+            fprintf(fout, ",\n{\"name\":\"complete\",\"cat\":\"sched\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,"
+                          "\"args\":{\"from\":%d,\"units\":%u}}", ts, e->dur / 1000.0, pid, tid, e->peer, e->id);
+            break;
+         case PX_TRACE_WAIT:
+            fprintf(fout, ",\n{\"name\":\"wait\",\"cat\":\"sched\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+                    ts, e->dur / 1000.0, pid, tid);
+            break;
+         case PX_TRACE_CONTROL:
+            fprintf(fout, ",\n{\"name\":\"%s\",\"cat\":\"sched\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                          "\"args\":{\"to\":%d,\"value\":%u}}", trace_tagname(e->val), ts, pid, tid, e->peer, e->id);
+            break;
+         case PX_TRACE_RECV:
+            tid = TRACE_TID_WORK;
+            fprintf(fout, ",\n{\"name\":\"%s\",\"cat\":\"work\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                          "\"args\":{\"value\":%u}}", trace_tagname(e->val), ts, pid, tid, e->id);
+            break;
+         case PX_TRACE_REPORT:
+            tid = TRACE_TID_WORK;
+            fprintf(fout, ",\n{\"name\":\"report\",\"cat\":\"work\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                          "\"args\":{\"units\":%u}}", ts, pid, tid, e->id);
+            break;
+         case PX_TRACE_RUN:
+            tid = TRACE_TID_SLOT + (int)e->slot;
+            fprintf(fout, ",\n{\"name\":\"unit %u\",\"cat\":\"run\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,"
+                          "\"args\":{\"id\":%u,\"status\":%d,\"killed\":%s}}", e->id, ts, e->dur / 1000.0, pid, tid, e->id,
+                    e->val, ((e->peer == PX_YES) ? "true" : "false"));
+            fprintf(fout, ",\n{\"name\":\"unit\",\"cat\":\"unit\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%u,\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                    e->id, ts, pid, tid);
+            break;
+         default:
+            continue;
+      }
+      if(tid < TRACE_TID_SLOT)
+         used[tid] = PX_YES;
+      if(tid > *maxtid)
+         *maxtid = tid;
+   }
+}/* trace_write */
+
+/*--------------------------------------------------------------------
+* Local module routine, names rank pid after its role, sep comes before
+*/
+static void trace_procname(FILE* fout, const char* sep, int pid, int role)
+{
+   fprintf(fout, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d %s\"}}",
+           sep, pid, pid, TRACE_ROLES[((role >= 0) && (role <= PX_TRACE_MONITOR)) ? role : PX_TRACE_WORKER]);
+}/* trace_procname */
+
+/*--------------------------------------------------------------------
+* Local module routine, orders rank pid and names its threads, those flagged
+* in used (see trace_write) and the slots up to maxtid
+*/
+static void trace_threads(FILE* fout, int pid, int role, const int* used, int maxtid)
+{
+   int tid;
+
+   fprintf(fout, ",\n{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"sort_index\":%d}}", pid, pid);
+   for(tid = 0; tid <= maxtid; tid++)
+   {
+      if( (tid < TRACE_TID_SLOT) && (used[tid] == PX_NO) )
+         continue;
+      if(tid == TRACE_TID_SCHED)
+         fprintf(fout, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                 pid, tid, ((role == PX_TRACE_LEADER) ? "node dispatch" : "dispatch"));
+      else if(tid == TRACE_TID_WORK)
+         fprintf(fout, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"messages\"}}", pid, tid);
+      else
+         fprintf(fout, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"slot %d\"}}",
+                 pid, tid, tid - TRACE_TID_SLOT);
+   }
+}/* trace_threads */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int trace_open(TRACE* trace, MPI_Comm comm, int rank, int role)
+{
+   memset(trace, 0, sizeof(TRACE));
+   trace->comm = MPI_COMM_NULL;
+   trace->rank = rank;
+   trace->role = role;
+   if( (trace->ev = (TRACE_EVENT*) malloc(PX_TRACE_INIT * sizeof(TRACE_EVENT))) == NULL)
+   {
+      fprintf(stderr, "%s @L %d : malloc error for the trace : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   trace->cap = PX_TRACE_INIT;
+   if(comm == MPI_COMM_NULL)
+      return 0;
+
+   if( (MPI_Comm_dup(comm, &(trace->comm)) != MPI_SUCCESS) || (MPI_Comm_size(trace->comm, &(trace->nranks)) != MPI_SUCCESS) )
+   {
+      fprintf(stderr, "%s @L %d : MPI_Comm_dup Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   if( (rank == 0) && ((trace->sync = (long long*) calloc(4 * (size_t)trace->nranks, sizeof(long long))) == NULL) )
+   {
+      fprintf(stderr, "%s @L %d : calloc error for the trace : %s\n", SRC_FILE, __LINE__, strerror(errno));
+      return -1;
+   }
+   if( trace_sync(trace, 0) < 0)
+   {
+      fprintf(stderr, "%s @L %d : trace clock sync Failed! :(\n", SRC_FILE, __LINE__);
+      return -1;
+   }
+   trace->t0 = now_tm_nsecs();
+   return 0;
+}/* trace_open */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+void trace_event(TRACE* trace, int kind, long long ts, long long dur, unsigned int id, int peer, int val, unsigned int slot)
+{
+   TRACE_EVENT* e;
+   void* nptr;
+   size_t ncap;
+
+   if(trace == NULL)
+      return;
+   if(trace->n == trace->cap)
+   {
+      ncap = ((trace->cap * 2) < PX_TRACE_MAX) ? (trace->cap * 2) : PX_TRACE_MAX;
+      if( (ncap <= trace->cap) || ((nptr = realloc(trace->ev, ncap * sizeof(TRACE_EVENT))) == NULL) )
+      {
+         trace->dropped += 1;
+         return;
+      }
+      trace->ev = (TRACE_EVENT*) nptr;
+      trace->cap = ncap;
+   }
+   e = &(trace->ev[trace->n]);
+   e->ts = ts;
+   e->dur = (dur > 0) ? dur : 0;
+   e->id = id;
+   e->peer = peer;
+   e->val = val;
+   e->kind = (unsigned short)kind;
+   e->slot = (slot < 65535U) ? (unsigned short)slot : 65535U;
+   trace->n += 1;
+}/* trace_event */
+
+/*--------------------------------------------------------------------
+* See pxargs.h for details
+*/
+int trace_close(TRACE* trace, TRACE* also, const char* fname)
+{
+   MPI_Status status;
+   FILE* fout = NULL;
+   TRACE_EVENT* ev = NULL;
+   long long hdr[3];
+   unsigned long dropped;
+   size_t nev;
+   int used[TRACE_TID_SLOT];
+   int r, maxtid, rc = 0;
+
+   if( trace_sync(trace, 1) < 0)
+   {
+      fprintf(stderr, "%s @L %d : trace clock sync Failed! :(\n", SRC_FILE, __LINE__);
+      rc = -1;
+   }
+   if( (rc == 0) && (trace->rank != 0) )
+   {
+      /* the sends wait for rank 0 to get to this rank */
+      hdr[0] = (long long)trace->n;
+      hdr[1] = (long long)trace->dropped;
+      hdr[2] = (long long)trace->role;
+      if( (MPI_Send(hdr, 3, MPI_LONG_LONG, 0, TRACE_TAG, trace->comm) != MPI_SUCCESS) ||
+          (MPI_Send(trace->ev, (int)(trace->n * sizeof(TRACE_EVENT)), MPI_BYTE, 0, TRACE_TAG, trace->comm) != MPI_SUCCESS) )
+      {
+         fprintf(stderr, "%s @L %d : MPI_Send Failed! :(\n", SRC_FILE, __LINE__);
+         rc = -1;
+      }
+   }
+   else if(rc == 0)
+   {
+      /* the other ranks are still taken in if the file cannot be written, so none is left waiting */
+      if( (fout = fopen(fname, "w")) == NULL)
+      {
+         fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+         rc = -1;
+      }
+      memset(used, 0, sizeof(used));
+      maxtid = -1;
+      dropped = trace->dropped;
+      if(fout != NULL)
+      {
+         fprintf(fout, "{\"traceEvents\":[");
+         trace_procname(fout, "\n", 0, trace->role);
+         trace_write(fout, trace->ev, trace->n, 0, NULL, trace->t0, used, &maxtid);
+         if(also != NULL)
+         {
+            trace_write(fout, also->ev, also->n, 0, NULL, trace->t0, used, &maxtid);
+            dropped += also->dropped;
+         }
+         trace_threads(fout, 0, trace->role, used, maxtid);
+      }
+      for(r = 1; r < trace->nranks; r++)
+      {
+         if( MPI_Recv(hdr, 3, MPI_LONG_LONG, r, TRACE_TAG, trace->comm, &status) != MPI_SUCCESS)
+         {
+            fprintf(stderr, "%s @L %d : MPI_Recv Failed! :(\n", SRC_FILE, __LINE__);
+            rc = -1;
+            break;
+         }
+         nev = (size_t)hdr[0];
+         dropped += (unsigned long)hdr[1];
+         if( (ev = (TRACE_EVENT*) malloc((nev + 1) * sizeof(TRACE_EVENT))) == NULL)
+         {
+            fprintf(stderr, "%s @L %d : malloc error for the trace : %s\n", SRC_FILE, __LINE__, strerror(errno));
+            rc = -1;
+            break;
+         }
+         if( MPI_Recv(ev, (int)(nev * sizeof(TRACE_EVENT)), MPI_BYTE, r, TRACE_TAG, trace->comm, &status) != MPI_SUCCESS)
+         {
+            fprintf(stderr, "%s @L %d : MPI_Recv Failed! :(\n", SRC_FILE, __LINE__);
+            free(ev);
+            rc = -1;
+            break;
+         }
+         if(fout != NULL)
+         {
+            memset(used, 0, sizeof(used));
+            maxtid = -1;
+            trace_write(fout, ev, nev, r, &(trace->sync[4 * r]), trace->t0, used, &maxtid);
+            trace_procname(fout, ",\n", r, (int)hdr[2]);
+            trace_threads(fout, r, (int)hdr[2], used, maxtid);
+         }
+         free(ev);
+      }
+      if(fout != NULL)
+      {
+         fprintf(fout, "\n],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{\"ranks\":%d,\"dropped_events\":%lu}}\n", trace->nranks, dropped);
+         if(fclose(fout) != 0)
+         {
+            fprintf(stderr, "%s @L %d : \"%s\" : %s\n", SRC_FILE, __LINE__, fname, strerror(errno));
+            rc = -1;
+         }
+      }
+      if(dropped > 0)
+         fprintf(stderr, "WARN: the trace is missing %lu events, a rank records at most %d.\n", dropped, PX_TRACE_MAX);
+   }
+   if(trace->comm != MPI_COMM_NULL)
+      MPI_Comm_free(&(trace->comm));
+   free(trace->ev);
+   free(trace->sync);
+   memset(trace, 0, sizeof(TRACE));
+   trace->comm = MPI_COMM_NULL;
+   if(also != NULL)
+   {
+      free(also->ev);
+      memset(also, 0, sizeof(TRACE));
+      also->comm = MPI_COMM_NULL;
+   }
+   return rc;
+}/* trace_close */